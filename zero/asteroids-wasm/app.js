@@ -13,6 +13,7 @@ class Game{ constructor(){ this.cv=document.getElementById('canvas'); this.gl=ne
     // Evitar scroll con flechas
     if(e.code.startsWith('Arrow')) e.preventDefault();
     if(e.code==='KeyR'){ this.mod.reset(); this.mod.start(); }
+    if(e.code==='KeyT'){ this.mod.stress(); }
   });
   addEventListener('keyup',(e)=>{ this.keys[e.code]=false; });
  }
@@ -35,9 +36,9 @@ class Game{ constructor(){ this.cv=document.getElementById('canvas'); this.gl=ne
   for(let i=0;i<nA;i++,k++){ pts[k*2]=asts[i*3]; pts[k*2+1]=asts[i*3+1]; sizes[k]=Math.max(3.0,asts[i*3+2]*200.0); cols[k*3]=0.9; cols[k*3+1]=0.95; cols[k*3+2]=1.0; }
   this.gl.draw(pts,sizes,cols);
   // HUD
-  this.updateHUD(stepMs, score, lives, wave);
+  this.updateHUD(stepMs, score, lives, wave, nA);
   requestAnimationFrame(this.loop); }
- updateHUD(stepMs,score,lives,wave){ const fpsEl=document.getElementById('fps'); const stepEl=document.getElementById('step'); const sEl=document.getElementById('score'); const lEl=document.getElementById('lives'); const wEl=document.getElementById('wave'); this._frames=(this._frames||0)+1; if(this._frames%30===0){ const now=performance.now(); const d=now-(this._lastFps||now); this._fps=Math.round(30000/d); this._lastFps=now; fpsEl.textContent=this._fps; } stepEl.textContent=stepMs.toFixed(2); sEl.textContent=score; lEl.textContent=lives; wEl.textContent=wave; }
+ updateHUD(stepMs,score,lives,wave,nA){ const fpsEl=document.getElementById('fps'); const stepEl=document.getElementById('step'); const sEl=document.getElementById('score'); const lEl=document.getElementById('lives'); const wEl=document.getElementById('wave'); this._frames=(this._frames||0)+1; if(this._frames%30===0){ const now=performance.now(); const d=now-(this._lastFps||now); this._fps=Math.round(30000/d); this._lastFps=now; fpsEl.textContent=this._fps; document.getElementById('asts').textContent=nA; document.getElementById('pairs').textContent=this.mod.getPairTests(); } stepEl.textContent=stepMs.toFixed(2); sEl.textContent=score; lEl.textContent=lives; wEl.textContent=wave; }
 }
 
 document.addEventListener('DOMContentLoaded',()=>new Game());
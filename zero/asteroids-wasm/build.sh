@@ -1,6 +1,17 @@
 #!/bin/bash
 set -euo pipefail
 
+# ./build.sh          -> physics.js (WASM)
+# ./build.sh native   -> asteroids-bench (campo de asteroides y lotes de partidas headless con stepBatch)
+MODE="${1:-wasm}"
+
+if [ "$MODE" = "native" ]; then
+  echo "🔨 Compilando benchmark nativo (Asteroids)..."
+  ${CXX:-c++} physics.cpp -O3 -std=c++17 -pthread -DASTEROIDS_BENCH -o asteroids-bench
+  echo "✅ Compilación OK → ./asteroids-bench"
+  exit 0
+fi
+
 echo "🔨 Compilando Asteroids WASM ..."
 
 emcc physics.cpp \
@@ -1,71 +1,204 @@
+#ifdef __EMSCRIPTEN__
 #include <emscripten/bind.h>
+using namespace emscripten;
+#else
+#include <thread>
+#endif
 #include <vector>
 #include <cmath>
 #include <cstdint>
 #include <algorithm>
-using namespace emscripten;
 
 static inline float wrap01(float v){ if(v<0) v+=1.0f; if(v>1) v-=1.0f; return v; }
-static inline float rnd(){ return (float)rand()/(float)RAND_MAX; }
+static void wrap(float &x,float &y){ x=wrap01(x); y=wrap01(y); }
 
 struct Ship{ float x=0.5f,y=0.5f,vx=0,vy=0,ang=0; int cooldown=0; int lives=3; bool alive=true; };
 struct Bullet{ float x,y,vx,vy,ttl; };
 struct Ast{ float x,y,vx,vy,r; };
 
-static Ship ship;
-static std::vector<Bullet> bullets;
-static std::vector<Ast> asts;
-static int wave=1; static int score=0;
+// xorshift32 por mundo: cada partida es reproducible a partir de su semilla y no comparte estado con otras
+struct Rng{ uint32_t s=0x9E3779B9u; void seed(uint32_t v){ s=v? v : 0x9E3779B9u; } uint32_t next(){ s^=s<<13; s^=s>>17; s^=s<<5; return s; } float f(){ return (next()>>8)*(1.0f/16777216.0f); } };
 
-static const float SHIP_THRUST=0.35f; static const float SHIP_ROT=3.2f; static const float SHIP_DAMP=0.995f;
+static const float SHIP_THRUST=0.35f; static const float SHIP_ROT=3.2f; static const float SHIP_DAMP=0.995f; static const float SHIP_R=0.012f;
 static const float BULLET_SPEED=0.8f; static const float BULLET_TTL=1.2f; static const float AST_MIN_R=0.01f; static const float AST_MAX_R=0.06f;
 
-void reset(){ ship=Ship(); bullets.clear(); asts.clear(); wave=1; score=0; }
+// Una partida completa. Todo el estado (incluidos los buffers de la grilla) es del mundo, así
+// varios mundos pueden avanzar a la vez en hilos distintos sin compartir nada.
+struct World {
+  Ship ship; std::vector<Bullet> bullets; std::vector<Ast> asts; int wave=1; int score=0; Rng rng; bool used=true;
 
-static void spawnWave(){ int n=3 + wave; for(int i=0;i<n;i++){ Ast a; a.r = AST_MAX_R * (0.6f + 0.4f*rnd()); a.x=rnd(); a.y=rnd(); float ang=rnd()*6.2831853f; float sp=0.05f+0.12f*rnd(); a.vx=std::cos(ang)*sp; a.vy=std::sin(ang)*sp; asts.push_back(a);} }
+  // Broadphase toroidal: grilla uniforme por counting sort (conteo por celda, prefix sum, scatter) con un anillo
+  // de celdas fantasma. Los asteroides de la primera/última fila o columna se copian, desplazados ±1, al anillo
+  // del lado opuesto: las consultas leen el 3x3 alrededor de su celda sin cruzar la costura ni hacer wrap01 por par.
+  // La celda mide al menos 2*radio máximo (y radio máximo + nave), así el 3x3 alcanza para cualquier par.
+  int G=1, GP=3; // celdas reales por lado; GP = G + 2 del anillo
+  std::vector<int> cellStart, cellFill; // GP*GP+1
+  std::vector<float> gx, gy, gr; std::vector<int> gi; // entradas ordenadas por celda (copias incluidas)
+  double pairTests=0;
 
-void start(){ reset(); spawnWave(); }
+  // Eventos diferidos: durante collisions() nada cambia de lugar en bullets/asts; los splits se aplican al final del step
+  std::vector<uint8_t> astHit; std::vector<int> hitList; std::vector<Ast> spawned;
 
-void input(bool thrust, float rot, bool fire){ // rot: -1..1
-  // rotación
-  ship.ang += rot * SHIP_ROT * (1.0f/60.0f);
-  // thrust
-  if(thrust){ ship.vx += std::cos(ship.ang)*SHIP_THRUST*(1.0f/60.0f); ship.vy += std::sin(ship.ang)*SHIP_THRUST*(1.0f/60.0f); }
-  // disparo
-  if(fire && ship.cooldown<=0 && ship.alive){ Bullet b; b.x=ship.x; b.y=ship.y; b.vx=std::cos(ship.ang)*BULLET_SPEED; b.vy=std::sin(ship.ang)*BULLET_SPEED; b.ttl=BULLET_TTL; bullets.push_back(b); ship.cooldown=9; }
-}
+  void reset(){ ship=Ship(); bullets.clear(); asts.clear(); wave=1; score=0; }
 
-static void wrap(float &x,float &y){ x=wrap01(x); y=wrap01(y); }
+  void spawnWave(){ int n=3 + wave; for(int i=0;i<n;i++){ Ast a; a.r = AST_MAX_R * (0.6f + 0.4f*rng.f()); a.x=rng.f(); a.y=rng.f(); float ang=rng.f()*6.2831853f; float sp=0.05f+0.12f*rng.f(); a.vx=std::cos(ang)*sp; a.vy=std::sin(ang)*sp; asts.push_back(a);} }
 
-static void stepBullets(float dt){ for(size_t i=0;i<bullets.size();){ Bullet &b=bullets[i]; b.x+=b.vx*dt; b.y+=b.vy*dt; wrap(b.x,b.y); b.ttl-=dt; if(b.ttl<=0){ bullets[i]=bullets.back(); bullets.pop_back(); } else { ++i; } } }
-static void stepAst(float dt){ for(auto &a:asts){ a.x+=a.vx*dt; a.y+=a.vy*dt; wrap(a.x,a.y);} }
+  void start(){ reset(); spawnWave(); }
 
-static void splitAst(size_t idx){ Ast a=asts[idx]; asts[idx]=asts.back(); asts.pop_back(); score+= (a.r>0.045f? 20 : a.r>0.025f? 50 : 100);
-  if(a.r>AST_MIN_R*2.0f){ int pieces=2 + (rand()%2); for(int i=0;i<pieces;i++){ Ast c; c.r=a.r*0.55f; float ang=rnd()*6.2831853f; float sp=0.08f+0.12f*rnd(); c.vx=std::cos(ang)*sp; c.vy=std::sin(ang)*sp; c.x=a.x; c.y=a.y; asts.push_back(c);} }
-}
+  void stress(){ // campo de asteroides: 10K rocas chicas (con un hueco alrededor de la nave) + 2000 balas en anillo
+    reset();
+    asts.reserve(10000);
+    while(asts.size()<10000){ Ast a; a.r=0.002f+0.003f*rng.f(); a.x=rng.f(); a.y=rng.f(); float dx=a.x-ship.x, dy=a.y-ship.y; if(dx*dx+dy*dy<0.08f*0.08f) continue; float ang=rng.f()*6.2831853f; float sp=0.02f+0.06f*rng.f(); a.vx=std::cos(ang)*sp; a.vy=std::sin(ang)*sp; asts.push_back(a); }
+    for(int i=0;i<2000;i++){ float ang=6.2831853f*i/2000.0f; Bullet b; b.x=ship.x; b.y=ship.y; b.vx=std::cos(ang)*BULLET_SPEED; b.vy=std::sin(ang)*BULLET_SPEED; b.ttl=BULLET_TTL; bullets.push_back(b); }
+  }
+
+  void input(bool thrust, float rot, bool fire){ // rot: -1..1
+    // rotación
+    ship.ang += rot * SHIP_ROT * (1.0f/60.0f);
+    // thrust
+    if(thrust){ ship.vx += std::cos(ship.ang)*SHIP_THRUST*(1.0f/60.0f); ship.vy += std::sin(ship.ang)*SHIP_THRUST*(1.0f/60.0f); }
+    // disparo
+    if(fire && ship.cooldown<=0 && ship.alive){ Bullet b; b.x=ship.x; b.y=ship.y; b.vx=std::cos(ship.ang)*BULLET_SPEED; b.vy=std::sin(ship.ang)*BULLET_SPEED; b.ttl=BULLET_TTL; bullets.push_back(b); ship.cooldown=9; }
+  }
+
+  void stepBullets(float dt){ for(size_t i=0;i<bullets.size();){ Bullet &b=bullets[i]; b.x+=b.vx*dt; b.y+=b.vy*dt; wrap(b.x,b.y); b.ttl-=dt; if(b.ttl<=0){ bullets[i]=bullets.back(); bullets.pop_back(); } else { ++i; } } }
+  void stepAst(float dt){ for(auto &a:asts){ a.x+=a.vx*dt; a.y+=a.vy*dt; wrap(a.x,a.y);} }
+
+  inline int cellOf(float v) const { int c=(int)(v*G); return c<0? 0 : c>=G? G-1 : c; }
+  // fn(celda con anillo, dx, dy) para la entrada real y cada copia fantasma del asteroide
+  template<class F> inline void forCopies(const Ast &a, F fn) const { const int cx=cellOf(a.x)+1, cy=cellOf(a.y)+1;
+    for(int sy=-1;sy<=1;sy++){ const int py=cy+sy*G; if(py<0||py>=GP) continue; for(int sx=-1;sx<=1;sx++){ const int px=cx+sx*G; if(px<0||px>=GP) continue; fn(py*GP+px, (float)sx, (float)sy); } }
+  }
+  void buildGrid(){
+    float maxR=0; for(const auto &a:asts) maxR=std::max(maxR,a.r);
+    const float minCell=std::max(2.0f*maxR, maxR+SHIP_R);
+    G=std::max(1, std::min(256, (int)(1.0f/minCell))); GP=G+2;
+    cellStart.assign(GP*GP+1, 0);
+    for(const auto &a:asts) forCopies(a, [&](int c,float,float){ cellStart[c+1]++; });
+    for(int c=0;c<GP*GP;c++) cellStart[c+1]+=cellStart[c];
+    const int n=cellStart[GP*GP]; gx.resize(n); gy.resize(n); gr.resize(n); gi.resize(n);
+    cellFill.assign(cellStart.begin(), cellStart.end()-1);
+    for(int i=0;i<(int)asts.size();i++){ const Ast &a=asts[i]; forCopies(a, [&](int c,float sx,float sy){ const int k=cellFill[c]++; gx[k]=a.x+sx; gy[k]=a.y+sy; gr[k]=a.r; gi[k]=i; }); }
+  }
+  template<class F> inline void forNear(float x,float y,F fn) const { const int cx=cellOf(x)+1, cy=cellOf(y)+1;
+    for(int py=cy-1;py<=cy+1;py++) for(int px=cx-1;px<=cx+1;px++){ const int c=py*GP+px; for(int k=cellStart[c], e=cellStart[c+1]; k<e; k++) fn(k); }
+  }
+
+  void splitAst(const Ast &a){ score+= (a.r>0.045f? 20 : a.r>0.025f? 50 : 100);
+    if(a.r>AST_MIN_R*2.0f){ int pieces=2 + (rng.next()%2); for(int i=0;i<pieces;i++){ Ast c; c.r=a.r*0.55f; float ang=rng.f()*6.2831853f; float sp=0.08f+0.12f*rng.f(); c.vx=std::cos(ang)*sp; c.vy=std::sin(ang)*sp; c.x=a.x; c.y=a.y; spawned.push_back(c);} }
+  }
+
+  void collisions(){
+    buildGrid(); pairTests=0;
+    astHit.assign(asts.size(), 0); hitList.clear();
+    // bullets vs asts: cada bala rompe la primera roca todavía entera que toque; muere con ttl=0
+    for(auto &b: bullets){ int hit=-1;
+      forNear(b.x, b.y, [&](int k){ pairTests++; if(hit>=0 || astHit[gi[k]]) return; const float dx=b.x-gx[k], dy=b.y-gy[k]; if(dx*dx+dy*dy < gr[k]*gr[k]) hit=gi[k]; });
+      if(hit>=0){ astHit[hit]=1; hitList.push_back(hit); b.ttl=0; }
+    }
+    // ship vs asts
+    if(ship.alive){ bool dead=false;
+      forNear(ship.x, ship.y, [&](int k){ pairTests++; const float dx=ship.x-gx[k], dy=ship.y-gy[k], R=gr[k]+SHIP_R; if(dx*dx+dy*dy < R*R) dead=true; });
+      if(dead){ ship.lives--; ship.alive=false; }
+    }
+    // asts vs asts: choque elástico con masa ~ r^2; cada par una vez (j>i), las rocas ya rotas no chocan
+    for(int i=0;i<(int)asts.size();i++){ if(astHit[i]) continue; Ast &a=asts[i];
+      forNear(a.x, a.y, [&](int k){ const int j=gi[k]; if(j<=i || astHit[j]) return; pairTests++;
+        const float dx=gx[k]-a.x, dy=gy[k]-a.y, R=gr[k]+a.r, d2=dx*dx+dy*dy; if(d2>=R*R || d2<1e-12f) return;
+        Ast &b=asts[j]; const float d=std::sqrt(d2), nx=dx/d, ny=dy/d, ma=a.r*a.r, mb=b.r*b.r, inv=1.0f/(ma+mb);
+        const float pen=R-d; a.x-=nx*pen*mb*inv; a.y-=ny*pen*mb*inv; b.x+=nx*pen*ma*inv; b.y+=ny*pen*ma*inv; wrap(a.x,a.y); wrap(b.x,b.y);
+        const float vn=(b.vx-a.vx)*nx+(b.vy-a.vy)*ny; if(vn<0){ const float J=2.0f*vn*inv; a.vx+=J*mb*nx; a.vy+=J*mb*ny; b.vx-=J*ma*nx; b.vy-=J*ma*ny; }
+      });
+    }
+  }
+
+  // fin del step: saca balas usadas y rocas rotas (compactación estable) y recién ahí agrega los fragmentos
+  void applyEvents(){
+    bullets.erase(std::remove_if(bullets.begin(), bullets.end(), [](const Bullet &b){ return b.ttl<=0; }), bullets.end());
+    if(hitList.empty()) return;
+    spawned.clear(); for(int i: hitList) splitAst(asts[i]);
+    size_t w=0; for(size_t i=0;i<asts.size();i++) if(!astHit[i]) asts[w++]=asts[i];
+    asts.resize(w); asts.insert(asts.end(), spawned.begin(), spawned.end());
+  }
+
+  void step(float dt){ if(ship.cooldown>0) ship.cooldown--; if(ship.alive){ ship.vx*=SHIP_DAMP; ship.vy*=SHIP_DAMP; ship.x+=ship.vx*dt; ship.y+=ship.vy*dt; wrap(ship.x,ship.y);} stepBullets(dt); stepAst(dt); collisions(); applyEvents(); if(asts.empty()){ wave++; spawnWave(); ship.alive=true; }
+  }
 
-static void collisions(){ // bullets vs asts
-  for(size_t i=0;i<bullets.size();){ bool hit=false; for(size_t j=0;j<asts.size();++j){ float dx=wrap01(bullets[i].x-asts[j].x); if(dx>0.5f) dx-=1.0f; float dy=wrap01(bullets[i].y-asts[j].y); if(dy>0.5f) dy-=1.0f; float d2=dx*dx+dy*dy; if(d2 < asts[j].r*asts[j].r){ splitAst(j); bullets[i]=bullets.back(); bullets.pop_back(); hit=true; break; } } if(!hit) ++i; }
-  // ship vs asts
-  if(ship.alive){ for(auto &a:asts){ float dx=wrap01(ship.x-a.x); if(dx>0.5f) dx-=1.0f; float dy=wrap01(ship.y-a.y); if(dy>0.5f) dy-=1.0f; float d2=dx*dx+dy*dy; if(d2 < (a.r+0.012f)*(a.r+0.012f)){ ship.lives--; ship.alive=false; break; } } }
+  void respawn(){ if(ship.lives>0){ ship.alive=true; ship.x=0.5f; ship.y=0.5f; ship.vx=ship.vy=0; ship.ang=0; } }
+};
+
+// Mundos en un solo vector (slots contiguos, reusados por free list). El 0 es el que juega app.js;
+// los demás se crean con createWorld() para correr partidas headless (bots).
+static std::vector<World> worlds(1); static std::vector<int> freeWorlds;
+static const size_t WORLD_BULLETS=64, WORLD_ASTS=256; // reserva inicial: una ola normal no realoca
+
+int createWorld(int seed){
+  int id; if(!freeWorlds.empty()){ id=freeWorlds.back(); freeWorlds.pop_back(); } else { id=(int)worlds.size(); worlds.emplace_back(); }
+  World &w=worlds[id]; w.used=true; w.rng.seed((uint32_t)seed); w.bullets.reserve(WORLD_BULLETS); w.asts.reserve(WORLD_ASTS); w.start();
+  return id;
 }
+void destroyWorld(int id){ if(id<=0 || id>=(int)worlds.size() || !worlds[id].used) return; worlds[id]=World(); worlds[id].used=false; freeWorlds.push_back(id); }
+int getWorldCount(){ return (int)(worlds.size()-freeWorlds.size()); }
+
+// Avanza `count` mundos `frames` pasos de 1/60 s con la entrada fija de cada uno (3 floats: thrust, rot, fire).
+// Cada mundo corre todos sus frames seguidos (su estado queda en caché); en nativo el lote se reparte en
+// hilos por rangos contiguos de ids. Los ids del lote no deben repetirse.
+static int batchThreads=0; // 0 = std::thread::hardware_concurrency()
+void setBatchThreads(int n){ batchThreads=std::max(0,n); }
 
-void step(float dt){ if(ship.cooldown>0) ship.cooldown--; if(ship.alive){ ship.vx*=SHIP_DAMP; ship.vy*=SHIP_DAMP; ship.x+=ship.vx*dt; ship.y+=ship.vy*dt; wrap(ship.x,ship.y);} stepBullets(dt); stepAst(dt); collisions(); if(asts.empty()){ wave++; spawnWave(); ship.alive=true; }
+static void stepRange(const int *ids, const float *in, int b, int e, int frames){
+  for(int k=b;k<e;k++){ World &w=worlds[ids[k]]; const bool thrust=in[k*3]!=0, fire=in[k*3+2]!=0; const float rot=in[k*3+1];
+    for(int f=0;f<frames;f++){ w.input(thrust, rot, fire); w.step(1.0f/60.0f); } }
 }
+void stepBatch(const int *ids, const float *in, int count, int frames){
+#ifdef __EMSCRIPTEN__
+  stepRange(ids, in, 0, count, frames);
+#else
+  int T=batchThreads? batchThreads : (int)std::thread::hardware_concurrency(); T=std::max(1, std::min(T, count));
+  if(T==1){ stepRange(ids, in, 0, count, frames); return; }
+  std::vector<std::thread> pool; pool.reserve(T-1);
+  for(int t=1;t<T;t++) pool.emplace_back(stepRange, ids, in, (int)((long)count*t/T), (int)((long)count*(t+1)/T), frames);
+  stepRange(ids, in, 0, (int)((long)count/T), frames);
+  for(auto &th: pool) th.join();
+#endif
+}
+
+// API del mundo 0 (la partida visible)
+void reset(){ worlds[0].reset(); }
+void start(){ worlds[0].start(); }
+void stress(){ worlds[0].stress(); }
+void input(bool thrust, float rot, bool fire){ worlds[0].input(thrust, rot, fire); }
+void step(float dt){ worlds[0].step(dt); }
+int getScore(){ return worlds[0].score; }
+int getLives(){ return worlds[0].ship.lives; }
+int getWave(){ return worlds[0].wave; }
+bool isAlive(){ return worlds[0].ship.alive; }
+int getAstCount(){ return (int)worlds[0].asts.size(); }
+double getPairTests(){ return worlds[0].pairTests; }
+void respawn(){ worlds[0].respawn(); }
 
+#ifdef __EMSCRIPTEN__
 // getters para render
-val getShip(){ static float s[3]; s[0]=ship.x; s[1]=ship.y; s[2]=ship.ang; return val(typed_memory_view(3,s)); }
-val getBullets(){ static std::vector<float> buf; buf.resize(bullets.size()*2); for(size_t i=0;i<bullets.size();++i){ buf[i*2]=bullets[i].x; buf[i*2+1]=bullets[i].y; } return val(typed_memory_view(buf.size(), buf.data())); }
-val getAsts(){ static std::vector<float> buf; buf.resize(asts.size()*3); for(size_t i=0;i<asts.size();++i){ buf[i*3]=asts[i].x; buf[i*3+1]=asts[i].y; buf[i*3+2]=asts[i].r; } return val(typed_memory_view(buf.size(), buf.data())); }
-int getScore(){ return score; }
-int getLives(){ return ship.lives; }
-int getWave(){ return wave; }
-bool isAlive(){ return ship.alive; }
-void respawn(){ if(ship.lives>0){ ship.alive=true; ship.x=0.5f; ship.y=0.5f; ship.vx=ship.vy=0; ship.ang=0; } }
+val getShip(){ const Ship &ship=worlds[0].ship; static float s[3]; s[0]=ship.x; s[1]=ship.y; s[2]=ship.ang; return val(typed_memory_view(3,s)); }
+val getBullets(){ const auto &bullets=worlds[0].bullets; static std::vector<float> buf; buf.resize(bullets.size()*2); for(size_t i=0;i<bullets.size();++i){ buf[i*2]=bullets[i].x; buf[i*2+1]=bullets[i].y; } return val(typed_memory_view(buf.size(), buf.data())); }
+val getAsts(){ const auto &asts=worlds[0].asts; static std::vector<float> buf; buf.resize(asts.size()*3); for(size_t i=0;i<asts.size();++i){ buf[i*3]=asts[i].x; buf[i*3+1]=asts[i].y; buf[i*3+2]=asts[i].r; } return val(typed_memory_view(buf.size(), buf.data())); }
+
+static bool worldLive(int id){ return id>=0 && id<(int)worlds.size() && worlds[id].used; }
+// Lotes desde JS: ids (Int32Array/array) e inputs (Float32Array, 3 por mundo)
+static std::vector<int> batchIds; static std::vector<float> batchIn;
+void stepBatchJS(val ids, val inputs, int frames){ batchIds=convertJSArrayToNumberVector<int>(ids); batchIn=convertJSArrayToNumberVector<float>(inputs);
+  if(batchIn.size()<batchIds.size()*3) batchIn.resize(batchIds.size()*3, 0.0f);
+  for(int id: batchIds) if(!worldLive(id)) return;
+  stepBatch(batchIds.data(), batchIn.data(), (int)batchIds.size(), frames);
+}
+// estado de un mundo para el bot: score, vidas, ola, viva, rocas, x, y, ángulo (vista vacía si el id no es un mundo vivo)
+val getWorldState(int id){ static float s[8]; if(!worldLive(id)) return val(typed_memory_view(0,s)); const World &w=worlds[id]; s[0]=(float)w.score; s[1]=(float)w.ship.lives; s[2]=(float)w.wave; s[3]=w.ship.alive? 1.0f : 0.0f; s[4]=(float)w.asts.size(); s[5]=w.ship.x; s[6]=w.ship.y; s[7]=w.ship.ang; return val(typed_memory_view(8,s)); }
+void respawnWorld(int id){ if(worldLive(id)) worlds[id].respawn(); }
 
 EMSCRIPTEN_BINDINGS(ast_bind){
   function("start", &start);
   function("reset", &reset);
+  function("stress", &stress);
   function("input", &input);
   function("step", &step);
   function("getShip", &getShip);
@@ -75,5 +208,65 @@ EMSCRIPTEN_BINDINGS(ast_bind){
   function("getLives", &getLives);
   function("getWave", &getWave);
   function("isAlive", &isAlive);
+  function("getAstCount", &getAstCount);
+  function("getPairTests", &getPairTests);
   function("respawn", &respawn);
+  function("createWorld", &createWorld);
+  function("destroyWorld", &destroyWorld);
+  function("getWorldCount", &getWorldCount);
+  function("stepBatch", &stepBatchJS);
+  function("getWorldState", &getWorldState);
+  function("respawnWorld", &respawnWorld);
+}
+#endif
+
+#ifdef ASTEROIDS_BENCH
+// Benchmark nativo (./build.sh native):
+//  1) campo de asteroides de stress() con 1K/5K/10K rocas: ms por step, pares probados y que la energía
+//     cinética no crezca con los choques elásticos
+//  2) lotes de partidas headless con stepBatch: frames simulados por segundo con 1 hilo y con todos,
+//     y que el resultado no dependa de la cantidad de hilos
+#include <chrono>
+#include <cstdio>
+
+static double kinetic(const World &w){ double e=0; for(const auto &a:w.asts) e+=0.5*a.r*a.r*(a.vx*a.vx+a.vy*a.vy); return e; }
+static double msSince(std::chrono::steady_clock::time_point t){ return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now()-t).count(); }
+
+int main(){
+  World &f=worlds[0];
+  for(int n : {1000, 5000, 10000}){
+    for(int shots=0; shots<2; shots++){ // sin balas (la energía sólo puede bajar por redondeo) y con el anillo de 2000
+      f.rng.seed(1); f.stress(); f.asts.resize(n); f.ship.alive=false; if(!shots) f.bullets.clear();
+      const double e0=kinetic(f); const int frames=300; double tests=0;
+      auto t0=std::chrono::steady_clock::now();
+      for(int k=0;k<frames;k++){ f.step(1.0f/60.0f); tests+=f.pairTests; }
+      const double ms=msSince(t0)/frames;
+      std::printf("rocas %5d -> %5d  balas %4d  grilla %3dx%-3d  %8.0f pares/step  %6.3f ms/step  energía %.3f -> %.3f\n",
+                  n, (int)f.asts.size(), shots? 2000 : 0, f.G, f.G, tests/frames, ms, e0*1e6, kinetic(f)*1e6);
+    }
+  }
+
+  // bots: giran y disparan (cada uno con su sentido y thrust); 600 frames = 10 s de juego por mundo
+  const int hw=std::max(4, (int)std::thread::hardware_concurrency()); // al menos 4: también prueba el reparto en máquinas chicas
+  for(int count : {64, 1024, 4096}){
+    long ref=-1;
+    for(int T : {1, hw}){
+      for(size_t i=1;i<worlds.size();i++) destroyWorld((int)i);
+      std::vector<int> ids(count); std::vector<float> in(count*3);
+      for(int k=0;k<count;k++){ ids[k]=createWorld(k+1); in[k*3]=(float)(k%3==0); in[k*3+1]=(k&1)? 0.6f : -0.4f; in[k*3+2]=1; }
+      setBatchThreads(T); const int frames=600;
+      auto t0=std::chrono::steady_clock::now();
+      for(int chunk=0; chunk<frames; chunk+=60){ // un llamado por segundo de juego; el bot revive la nave entre llamados
+        stepBatch(ids.data(), in.data(), count, 60);
+        for(int id: ids) worlds[id].respawn();
+      }
+      const double ms=msSince(t0);
+      long sum=0; for(int id: ids) sum+=worlds[id].score*31L+worlds[id].wave;
+      if(ref<0) ref=sum;
+      std::printf("mundos %5d  hilos %2d  %8.1f ms  %10.0f frames/s%s\n", count, T, ms, (double)count*frames/(ms/1000.0),
+                  sum==ref? "" : "  (DIFIERE)");
+    }
+  }
+  return 0;
 }
+#endif
@@ -75,10 +75,26 @@ class Game{
   bindUI(){
     const ropeEl=id=>document.getElementById(id);
     const fpsEl=ropeEl('fps'), stepEl=ropeEl('step'), itEl=ropeEl('iters'), ropeCountEl=ropeEl('ropeCount'), stEl=ropeEl('state');
+    const solverEl=ropeEl('solver'), stretchEl=ropeEl('stretch'), solverBtn=ropeEl('solverToggle');
+    const drawnEl=ropeEl('ropeDrawn'), lodBtn=ropeEl('lodToggle');
+    const solverName=()=>this.mod.getSolver()===1?'tridiagonal':'gauss-seidel';
     ropeEl('attach').onclick=()=>{ this.mod.attach(); this.state='attached'; stEl.textContent=this.state; };
     ropeEl('detach').onclick=()=>{ this.mod.detach(); this.state='detached'; stEl.textContent=this.state; };
     ropeEl('reset').onclick=()=>{ this.mod.init(); this.state='detached'; stEl.textContent=this.state; };
-    ropeEl('stress').onclick=()=>{ this.mod.setIterations(256); };
+    const lodLabel=()=>{ lodBtn.textContent='LOD: '+(this.mod.getRopeLod()?'on':'off'); };
+    // stress: cuerda a resolución máxima (2000 nodos); carga los dos solvers, no sólo Gauss–Seidel.
+    // Con LOD la recta arranca en ~125 nodos y fusiona lo que no dobla: se apaga mientras dura y se restaura
+    const stressBtn=ropeEl('stress'), baseSegLen=this.mod.getRopeSegLen(); let stress=false, lodBefore=true;
+    stressBtn.onclick=()=>{
+      stress=!stress;
+      if(stress){ lodBefore=this.mod.getRopeLod(); this.mod.setRopeSegLen(0.0004); this.mod.setRopeLod(false); }
+      else { this.mod.setRopeSegLen(baseSegLen); this.mod.setRopeLod(lodBefore); }
+      if(this.state==='attached') this.mod.attach(); // rearmar con la resolución nueva
+      stressBtn.textContent='Stress: '+(stress?'2000 nodos':'off'); lodLabel();
+    };
+    solverBtn.onclick=()=>{ this.mod.setSolver(1-this.mod.getSolver()); solverBtn.textContent='Solver: '+solverName(); };
+    solverBtn.textContent='Solver: '+solverName();
+    lodBtn.onclick=()=>{ this.mod.setRopeLod(!this.mod.getRopeLod()); lodLabel(); };
     // mouse
     this.canvas.addEventListener('mousemove',(e)=>{
       const r=this.canvas.getBoundingClientRect();
@@ -88,9 +104,9 @@ class Game{
     this.canvas.addEventListener('mousedown',()=>{ this.mod.attach(); this.state='attached'; stEl.textContent=this.state; });
     this.canvas.addEventListener('mouseup',()=>{ /* keep attached until space */ });
     addEventListener('keydown',(e)=>{ if(e.code==='Space'){ if(this.state==='attached'){ this.mod.detach(); this.state='detached'; } else { this.mod.attach(); this.state='attached'; } stEl.textContent=this.state; } });
-    this.updateHUD=(stepMs)=>{
-      this.frame++; if(this.frame%30===0){ const now=performance.now(), d=now-(this.lastFps||now); this.fps=Math.round(30000/d); this.lastFps=now; fpsEl.textContent=this.fps; itEl.textContent=this.mod.getIterations(); }
-      stepEl.textContent=stepMs.toFixed(2); ropeCountEl.textContent=this.mod.getRopeCount(); stEl.textContent=this.state;
+    this.updateHUD=(stepMs,drawn)=>{
+      this.frame++; if(this.frame%30===0){ const now=performance.now(), d=now-(this.lastFps||now); this.fps=Math.round(30000/d); this.lastFps=now; fpsEl.textContent=this.fps; itEl.textContent=this.mod.getSolverPasses(); solverEl.textContent=solverName(); stretchEl.textContent=(this.mod.getMaxStretch()*100).toFixed(2); }
+      stepEl.textContent=stepMs.toFixed(2); ropeCountEl.textContent=this.mod.getRopeCount(); drawnEl.textContent=drawn; stEl.textContent=this.state;
     };
   }
   loop(){
@@ -105,7 +121,7 @@ class Game{
     // player point
     points[(N+1)*2]=player[0]; points[(N+1)*2+1]=player[1]; sizes[N+1]=8.0; colors[(N+1)*3]=0.5; colors[(N+1)*3+1]=1.0; colors[(N+1)*3+2]=0.6;
     this.gl.draw(points,sizes,colors);
-    this.updateHUD(stepMs);
+    this.updateHUD(stepMs,N);
     requestAnimationFrame(this.loop);
   }
 }
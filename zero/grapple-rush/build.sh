@@ -1,6 +1,17 @@
 #!/bin/bash
 set -euo pipefail
 
+# ./build.sh          -> physics.js (WASM)
+# ./build.sh native   -> grapple-bench (benchmark nativo: Gauss–Seidel vs solver tridiagonal)
+MODE="${1:-wasm}"
+
+if [ "$MODE" = "native" ]; then
+  echo "🔨 Compilando benchmark nativo (Grapple Rush)..."
+  ${CXX:-c++} physics.cpp -O3 -std=c++17 -DGRAPPLE_BENCH -o grapple-bench
+  echo "✅ Compilación OK → ./grapple-bench"
+  exit 0
+fi
+
 echo "🔨 Compilando Grapple Rush (WASM) ..."
 
 emcc physics.cpp \
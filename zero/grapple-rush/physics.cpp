@@ -1,8 +1,11 @@
+#ifdef __EMSCRIPTEN__
 #include <emscripten/bind.h>
+using namespace emscripten;
+#endif
 #include <vector>
 #include <cmath>
 #include <cstdint>
-using namespace emscripten;
+#include <algorithm>
 
 struct Vec2 { float x, y; };
 
@@ -21,12 +24,36 @@ static bool ropeActive=false;
 static Vec2 anchor{0.5f,0.5f};
 static std::vector<Vec2> rope;          // nodos de la cuerda
 static std::vector<Vec2> ropePrev;      // para integración verlet
-static float ropeSegLen=0.008f;         // largo de cada segmento
+static std::vector<float> ropeRest;     // largo en reposo de cada segmento (varía con el LOD)
+static float ropeSegLen=0.008f;         // resolución máxima: largo del segmento más fino
 static int ropeIter=48;                 // iteraciones PBD por substep
 static int substeps=4;                  // substeps por frame
 static float gravity=0.0f;              // casi nula, feel arcade
 static float airDamp=0.9992f;           // damping leve
 
+// Solver de la cuerda: SOLVER_ITERATIVE = ropeIter pasadas Gauss–Seidel (PBD),
+// SOLVER_DIRECT = XPBD resolviendo el sistema tridiagonal de la cadena con Thomas, O(n) por pasada
+enum { SOLVER_ITERATIVE=0, SOLVER_DIRECT=1 };
+static int ropeSolver=SOLVER_DIRECT;
+static float ropeCompliance=0.0f;       // XPBD: 0 = inextensible (m/N)
+static int directMaxPasses=64;          // tope de relinealizaciones por substep (Newton), casi nunca se alcanza
+static float directTol=1e-3f;           // corta cuando max C/rest < directTol
+static int lastPasses=0;                // pasadas del último substep (HUD/bench)
+static float lastMaxStretch=0.0f;       // (largo/rest - 1) máximo tras el último step
+static std::vector<Vec2> segN;          // normal de cada segmento
+static std::vector<float> segC, segLambda, thomasC, thomasD; // scratch del solver directo
+
+// LOD de la cuerda: una vez por frame se fusionan nodos donde la cuerda va recta y sin tensión y se
+// parten segmentos donde dobla o toca un borde, sin pasar de ropeBudget nodos. El largo total se conserva.
+static bool ropeLod=true;
+static int ropeBudget=2000;             // nodos máximos (incluye player y anchor)
+static float lodMaxSeg=16.0f;           // segmento más largo, en ropeSegLen
+static float lodMergeCos=0.9962f;       // fusionar si el giro en el nodo es < 5°
+static float lodSplitCos=0.9659f;       // partir si el giro es > 15° (histéresis con el de fusión)
+static float lodTension=0.002f;         // no fusionar segmentos estirados más que esto
+static std::vector<Vec2> lodP, lodPrev; // scratch del remuestreo
+static std::vector<float> lodRest;
+
 static std::vector<float> ropeBuffer;   // para exponer a JS
 
 static inline void clampToBounds(Vec2 &p, Vec2 &v){
@@ -35,12 +62,15 @@ static inline void clampToBounds(Vec2 &p, Vec2 &v){
 }
 
 static void buildRopeTo(const Vec2 &src,const Vec2 &dst){
-  rope.clear(); ropePrev.clear();
+  rope.clear(); ropePrev.clear(); ropeRest.clear();
   Vec2 d=sub(dst,src); float L=len(d); if(L<1e-5f){ ropeActive=false; return; }
   int n = (int)std::ceil(L/ropeSegLen);
   if(n<2) n=2; if(n>2000) n=2000; // límite prudente
+  const float total = n*ropeSegLen; // largo en reposo, igual con o sin LOD
+  // recta: con LOD arranca con segmentos largos y se refina donde doble
+  if(ropeLod) n = std::min(n, std::max(2, std::max((int)std::ceil(n/lodMaxSeg), (int)std::ceil(2.0f*n/ropeBudget))));
   Vec2 step = mul(norm(d), L/(float)n);
-  rope.reserve(n+1); ropePrev.reserve(n+1);
+  rope.reserve(n+1); ropePrev.reserve(n+1); ropeRest.assign(n, total/(float)n);
   Vec2 cur=src;
   for(int i=0;i<=n;i++){ rope.push_back(cur); ropePrev.push_back(cur); cur=add(cur,step);} 
   anchor = dst; ropeActive=true;
@@ -66,8 +96,8 @@ static inline void satisfyDistance(std::vector<Vec2>&p,int i,int j,float rest){
 }
 
 static inline void playerConstraint(){
-  // primer segmento entre player y rope[1], mantener distancia ropeSegLen
-  if(rope.size()>=2){ satisfyDistance(rope, 0, 1, ropeSegLen); }
+  // primer segmento entre player y rope[1], mantener su largo en reposo
+  if(rope.size()>=2){ satisfyDistance(rope, 0, 1, ropeRest[0]); }
 }
 
 static inline void anchorConstraint(){
@@ -85,13 +115,125 @@ static inline void solveRope(){
   // aplicar constraints varias veces para rigidez
   for(int it=0; it<ropeIter; ++it){
     // distancia entre puntos consecutivos
-    for(size_t i=0;i+1<rope.size();++i){ satisfyDistance(rope, (int)i, (int)i+1, ropeSegLen); }
+    for(size_t i=0;i+1<rope.size();++i){ satisfyDistance(rope, (int)i, (int)i+1, ropeRest[i]); }
     playerConstraint();
     anchorConstraint();
     boundsConstraint(rope);
   }
 }
 
+// Restricciones C_i = |x_{i+1}-x_i| - rest. J W J^T es tridiagonal en una cadena:
+//   diag_i = w_i + w_{i+1} + alpha~,  off_{i,i+1} = -w_{i+1} (n_i . n_{i+1})
+// con w = 0 en los extremos (player y anchor fijos). Se resuelve (J W J^T + alpha~) dl = -C - alpha~ l
+// exacto con Thomas y se aplica dx = W J^T dl; cada pasada relinealiza las normales y corta al converger.
+// Con la cadena recta (recién enganchada) el sistema es singular: dl constante no cambia ninguna longitud
+// ni mueve nodos, el piso de alpha~ sólo lo acota. Una cadena recta tampoco puede acortarse: si el anchor
+// se acerca quedan segmentos comprimidos (igual que con Gauss–Seidel), por eso se corta mirando sólo el
+// estiramiento. Con la cuerda cayendo el movimiento perpendicular no aparece en la linealización y hacen
+// falta varias pasadas.
+static inline void solveRopeDirect(float h){
+  const int m=(int)rope.size()-1; if(m<1) return;
+  segN.resize(m); segC.resize(m); thomasC.resize(m); thomasD.resize(m);
+  segLambda.assign(m, 0.0f);
+  const float alpha = std::max(ropeCompliance/(h*h), 1e-6f); // piso: cadena recta tirante entre extremos fijos
+  auto w=[m](int k){ return (k==0 || k==m)? 0.0f : 1.0f; }; // masa inversa por nodo
+  lastPasses=0;
+  for(int pass=0; pass<directMaxPasses; ++pass){
+    float worst=0.0f;
+    for(int i=0;i<m;++i){
+      Vec2 d=sub(rope[i+1], rope[i]); float L=len(d);
+      segC[i] = L - ropeRest[i]; worst=std::max(worst, segC[i]/ropeRest[i]);
+      segN[i] = L>1e-8f? mul(d,1.0f/L) : Vec2{0,0};
+    }
+    if(worst < directTol) break;
+    lastPasses++;
+    // forward: c'_i = c_i/den, d'_i = (r_i - a_i d'_{i-1})/den, con a_i = off_{i-1,i}
+    float cPrev=0.0f, dPrev=0.0f, offPrev=0.0f;
+    for(int i=0;i<m;++i){
+      float diag = w(i) + w(i+1) + alpha;
+      float off  = i+1<m ? -w(i+1)*dot(segN[i], segN[i+1]) : 0.0f;
+      float r    = -segC[i] - alpha*segLambda[i];
+      float den  = diag - offPrev*cPrev;
+      cPrev = off/den; dPrev = (r - offPrev*dPrev)/den;
+      thomasC[i]=cPrev; thomasD[i]=dPrev; offPrev=off;
+    }
+    // backward + aplicar dx_i -= w_i n_i dl_i, dx_{i+1} += w_{i+1} n_i dl_i
+    float next=0.0f;
+    for(int i=m-1;i>=0;--i){
+      float dl = thomasD[i] - thomasC[i]*next; next=dl;
+      segLambda[i] += dl;
+      if(i!=0) rope[i]   = sub(rope[i],   mul(segN[i], dl));
+      if(i+1!=m) rope[i+1] = add(rope[i+1], mul(segN[i], dl));
+    }
+  }
+  anchorConstraint();
+  boundsConstraint(rope);
+}
+
+static inline float measureMaxStretch(){
+  float mx=0.0f;
+  for(size_t i=0;i+1<rope.size();++i) mx=std::max(mx, len(sub(rope[i+1],rope[i]))/ropeRest[i] - 1.0f);
+  return mx;
+}
+
+// Catmull-Rom uniforme entre p1 y p2
+static inline Vec2 catmullRom(const Vec2&p0,const Vec2&p1,const Vec2&p2,const Vec2&p3,float t){
+  const float t2=t*t, t3=t2*t;
+  const float a=-0.5f*t3+t2-0.5f*t, b=1.5f*t3-2.5f*t2+1.0f, c=-1.5f*t3+2.0f*t2+0.5f*t, e=0.5f*t3-0.5f*t2;
+  return {a*p0.x+b*p1.x+c*p2.x+e*p3.x, a*p0.y+b*p1.y+c*p2.y+e*p3.y};
+}
+static inline Vec2 splineAt(const std::vector<Vec2>&p,int i,float t){ // tramo i..i+1, extremos repetidos
+  const int last=(int)p.size()-1;
+  return catmullRom(p[std::max(i-1,0)], p[i], p[i+1], p[std::min(i+2,last)], t);
+}
+
+static inline float bendCos(int i){ // coseno del giro en el nodo interior i
+  return dot(norm(sub(rope[i],rope[i-1])), norm(sub(rope[i+1],rope[i])));
+}
+static inline bool onWall(const Vec2&p){ return p.x<=0.0f || p.x>=1.0f || p.y<=0.0f || p.y>=1.0f; }
+static inline float segStretch(int i){ return len(sub(rope[i+1],rope[i]))/ropeRest[i] - 1.0f; }
+
+// Nodo nuevo al medio del segmento i: del lado hacia donde curva la spline y a rest/2 de cada extremo,
+// así partir no estira ni comprime la cuerda (el punto de la spline queda más lejos que la cuerda)
+static inline Vec2 splitPoint(const std::vector<Vec2>&p,int i){
+  const Vec2 mid = mul(add(p[i],p[i+1]), 0.5f);
+  const Vec2 d = sub(p[i+1],p[i]); const Vec2 perp{-d.y, d.x};
+  const float side = dot(sub(splineAt(p, i, 0.5f), mid), perp) < 0.0f ? -1.0f : 1.0f;
+  const float half = 0.5f*ropeRest[i], c = 0.5f*len(d);
+  const float h = std::sqrt(std::max(0.0f, half*half - c*c));
+  return add(mid, mul(norm(perp), side*h));
+}
+
+// Una pasada lineal sobre la cadena: cada nodo interior se descarta (su segmento se suma al actual)
+// o se emite; un segmento original que no se fusionó se parte al medio sobre la spline si dobla o toca
+// un borde. Pasado de presupuesto se fusiona sin mirar curvatura ni tensión.
+static void resampleRope(){
+  const int n=(int)rope.size(); if(n<3) return;
+  float total=0.0f; for(float r : ropeRest) total+=r;
+  const bool over = n > ropeBudget;
+  const float maxSeg = std::max(lodMaxSeg*ropeSegLen, 2.0f*total/(float)ropeBudget);
+  int room = ropeBudget - n; // nodos que todavía se pueden agregar
+  lodP.clear(); lodPrev.clear(); lodRest.clear();
+  lodP.push_back(rope[0]); lodPrev.push_back(ropePrev[0]);
+  float acc=0.0f; bool merged=false;
+  for(int i=0;i+1<n;++i){
+    acc += ropeRest[i];
+    const int j=i+1;
+    if(j<n-1 && acc+ropeRest[j] <= maxSeg && !onWall(rope[j])){
+      const bool calm = bendCos(j) > lodMergeCos && segStretch(i) < lodTension && segStretch(j) < lodTension;
+      if(over || calm){ merged=true; continue; }
+    }
+    const bool bent = (i>0 && bendCos(i) < lodSplitCos) || (j<n-1 && bendCos(j) < lodSplitCos);
+    if(!merged && room>0 && ropeRest[i] >= 2.0f*ropeSegLen && (bent || onWall(rope[i]) || onWall(rope[j]))){
+      lodP.push_back(splitPoint(rope, i)); lodPrev.push_back(splitPoint(ropePrev, i));
+      lodRest.push_back(0.5f*acc); acc*=0.5f; room--;
+    }
+    lodP.push_back(rope[j]); lodPrev.push_back(ropePrev[j]); lodRest.push_back(acc);
+    acc=0.0f; merged=false;
+  }
+  rope.swap(lodP); ropePrev.swap(lodPrev); ropeRest.swap(lodRest);
+}
+
 static inline void updatePlayer(float dt){
   // player unido al nodo 0 de la cuerda
   if(ropeActive && !rope.empty()){
@@ -107,21 +249,42 @@ static inline void updatePlayer(float dt){
   clampToBounds(player.p, player.v);
 }
 
+// Para dibujar: cada segmento se subdivide sobre la spline a ~ropeSegLen (hasta 16 tramos),
+// así la cuerda se ve igual de suave con pocos nodos simulados
 static inline void fillRopeBuffer(){
-  ropeBuffer.resize(rope.size()*2);
-  for(size_t i=0;i<rope.size();++i){ ropeBuffer[i*2]=rope[i].x; ropeBuffer[i*2+1]=rope[i].y; }
+  ropeBuffer.clear();
+  if(rope.empty()) return;
+  for(size_t i=0;i+1<rope.size();++i){
+    const int k = std::min(16, std::max(1, (int)std::lround(ropeRest[i]/ropeSegLen)));
+    for(int s=0;s<k;++s){ Vec2 q = s==0? rope[i] : splineAt(rope, (int)i, s/(float)k); ropeBuffer.push_back(q.x); ropeBuffer.push_back(q.y); }
+  }
+  ropeBuffer.push_back(rope.back().x); ropeBuffer.push_back(rope.back().y);
 }
 
 // API
-void init(){ player=Player(); rope.clear(); ropePrev.clear(); ropeActive=false; ropeIter=64; substeps=4; }
+void init(){ player=Player(); rope.clear(); ropePrev.clear(); ropeRest.clear(); ropeActive=false; ropeIter=64; substeps=4; lastMaxStretch=0.0f; }
 void setMouse(float nx,float ny){ anchor = {nx,ny}; }
 void attach(){ buildRopeTo(player.p, anchor); }
-void detach(){ ropeActive=false; rope.clear(); ropePrev.clear(); }
+void detach(){ ropeActive=false; rope.clear(); ropePrev.clear(); ropeRest.clear(); }
 void setIterations(int it){ ropeIter = it<1?1:it; }
 int  getIterations(){ return ropeIter; }
+void setSolver(int s){ ropeSolver = s==SOLVER_DIRECT? SOLVER_DIRECT : SOLVER_ITERATIVE; }
+int  getSolver(){ return ropeSolver; }
+void setCompliance(float c){ ropeCompliance = c<0?0:c; }
+float getMaxStretch(){ return lastMaxStretch; }
+int  getSolverPasses(){ return ropeSolver==SOLVER_DIRECT? lastPasses : ropeIter; }
+void setRopeLod(bool on){ ropeLod=on; }
+bool getRopeLod(){ return ropeLod; }
+void setRopeBudget(int n){ ropeBudget = n<3?3:(n>2000?2000:n); }
+int  getRopeBudget(){ return ropeBudget; }
 int  getRopeCount(){ return (int)rope.size(); }
+// largo del segmento más fino (con LOD los demás son más largos): toma efecto en el próximo attach(). 0.0004 = 2000 nodos a 0.8
+void setRopeSegLen(float s){ ropeSegLen = s<0.0002f?0.0002f:(s>0.05f?0.05f:s); }
+float getRopeSegLen(){ return ropeSegLen; }
+#ifdef __EMSCRIPTEN__
 val  getRopePositions(){ fillRopeBuffer(); return val(typed_memory_view(ropeBuffer.size(), ropeBuffer.data())); }
 val  getPlayer(){ static float p[2]; p[0]=player.p.x; p[1]=player.p.y; return val(typed_memory_view(2, p)); }
+#endif
 
 void step(float dtMs){
   float dt = dtMs/1000.0f;
@@ -133,12 +296,15 @@ void step(float dtMs){
       rope[0]=player.p; ropePrev[0]=player.p; // fijo al player
       anchorConstraint();
       verletIntegrate(rope, ropePrev, h);
-      solveRope();
+      if(ropeSolver==SOLVER_DIRECT) solveRopeDirect(h); else solveRope();
     }
     updatePlayer(h);
   }
+  if(ropeActive && ropeLod) resampleRope();
+  lastMaxStretch = ropeActive? measureMaxStretch() : 0.0f;
 }
 
+#ifdef __EMSCRIPTEN__
 EMSCRIPTEN_BINDINGS(grapple_bindings){
   function("init", &init);
   function("setMouse", &setMouse);
@@ -146,8 +312,63 @@ EMSCRIPTEN_BINDINGS(grapple_bindings){
   function("detach", &detach);
   function("setIterations", &setIterations);
   function("getIterations", &getIterations);
+  function("setSolver", &setSolver);
+  function("getSolver", &getSolver);
+  function("setCompliance", &setCompliance);
+  function("getMaxStretch", &getMaxStretch);
+  function("getSolverPasses", &getSolverPasses);
+  function("setRopeLod", &setRopeLod);
+  function("getRopeLod", &getRopeLod);
+  function("setRopeBudget", &setRopeBudget);
+  function("getRopeBudget", &getRopeBudget);
   function("getRopeCount", &getRopeCount);
+  function("setRopeSegLen", &setRopeSegLen);
+  function("getRopeSegLen", &getRopeSegLen);
   function("getRopePositions", &getRopePositions);
   function("getPlayer", &getPlayer);
   function("step", &step);
 }
+#endif
+
+#ifdef GRAPPLE_BENCH
+// Benchmark nativo (./build.sh native): ms por step, nodos y estiramiento máximo,
+// Gauss–Seidel vs tridiagonal, con y sin LOD de la cuerda
+#include <chrono>
+#include <cstdio>
+
+int main(){
+  const float segs[] = {0.008f, 0.0004f}; // cuerda por defecto (~100 nodos) y al límite de 2000 nodos
+  const int frames = 600;
+  for(float seg : segs){
+    for(int cfg=0; cfg<4; ++cfg){
+      const int solver = cfg&1? SOLVER_DIRECT : SOLVER_ITERATIVE;
+      init(); ropeSegLen=seg; setSolver(solver); setRopeLod(cfg>=2);
+      // cuerda de 0.8 floja entre puntos a 0.7, como arco de círculo colgando: recién enganchada estaría
+      // recta y tirante, y con gravedad tendría que estirarse sí o sí
+      player.p = {0.1f,0.5f}; setMouse(0.8f,0.5f);
+      const int n = (int)std::lround(0.8f/seg);
+      float lo=1e-3f, hi=3.14f; // semiángulo t: sin(t)/t = cuerda/arco
+      for(int it=0; it<40; ++it){ float t=0.5f*(lo+hi); if(std::sin(t)/t > 0.7f/0.8f) lo=t; else hi=t; }
+      const float t=lo, R=0.35f/std::sin(t), cy=0.5f-R*std::cos(t);
+      rope.resize(n+1); ropePrev.resize(n+1); ropeRest.assign(n, seg);
+      for(int i=0;i<=n;++i){ float a=-t+2.0f*t*i/n; rope[i]={0.45f+R*std::sin(a), cy+R*std::cos(a)}; ropePrev[i]=rope[i]; }
+      ropeActive=true;
+      const float k = seg/0.008f; // misma escena medida en segmentos: anchor y gravedad escalados
+      gravity=0.01f*k;
+      float worst=0.0f, sum=0.0f; long passes=0, nodes=0;
+      auto t0=std::chrono::steady_clock::now();
+      for(int f=0; f<frames; ++f){
+        float a = 0.6f*std::sin(f*0.05f*k);
+        setMouse(0.1f+0.7f*std::cos(a), 0.5f+0.7f*std::sin(a));
+        step(16.6f);
+        worst=std::max(worst, lastMaxStretch); sum+=lastMaxStretch; passes+=getSolverPasses(); nodes+=getRopeCount();
+      }
+      double ms=std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now()-t0).count()/frames;
+      std::printf("nodos %4d→%6.1f  %-12s %-3s %5.1f pasadas  %7.3f ms/step  estiramiento max %7.3f%%  medio %7.3f%%\n",
+                  n+1, nodes/(double)frames, solver==SOLVER_DIRECT? "tridiagonal" : "gauss-seidel", cfg>=2? "lod" : "",
+                  passes/(double)frames, ms, worst*100.0f, sum/frames*100.0f);
+    }
+  }
+  return 0;
+}
+#endif
@@ -1,3 +1,5 @@
+import { createShared, RemoteSim, spawnTurrets } from './shared.mjs';
+
 const VS=`
 attribute vec2 a_position; attribute float a_size; attribute vec3 a_color; varying vec3 v_color; void main(){ gl_Position=vec4(a_position*2.0-1.0,0.0,1.0); gl_PointSize=a_size; v_color=a_color; }
 `; const FS=`
@@ -5,11 +7,17 @@ precision mediump float; varying vec3 v_color; void main(){ vec2 uv=gl_PointCoor
 `;
 class GL{ constructor(c){ this.c=c; this.g=c.getContext('webgl'); const g=this.g; const v=this._s(g.VERTEX_SHADER,VS), f=this._s(g.FRAGMENT_SHADER,FS); this.p=g.createProgram(); g.attachShader(this.p,v); g.attachShader(this.p,f); g.linkProgram(this.p); this.lPos=g.getAttribLocation(this.p,'a_position'); this.lSize=g.getAttribLocation(this.p,'a_size'); this.lCol=g.getAttribLocation(this.p,'a_color'); this.bPos=g.createBuffer(); this.bSize=g.createBuffer(); this.bCol=g.createBuffer(); g.enable(g.BLEND); g.blendFunc(g.SRC_ALPHA,g.ONE_MINUS_SRC_ALPHA); g.clearColor(0.02,0.02,0.03,1);} _s(t,src){ const g=this.g; const s=g.createShader(t); g.shaderSource(s,src); g.compileShader(s); return s;} resize(){ this.c.width=innerWidth; this.c.height=innerHeight; this.g.viewport(0,0,this.c.width,this.c.height);} draw(pts,sizes,cols){ const g=this.g; g.clear(g.COLOR_BUFFER_BIT); g.useProgram(this.p); g.bindBuffer(g.ARRAY_BUFFER,this.bPos); g.bufferData(g.ARRAY_BUFFER,pts,g.DYNAMIC_DRAW); g.enableVertexAttribArray(this.lPos); g.vertexAttribPointer(this.lPos,2,g.FLOAT,false,0,0); g.bindBuffer(g.ARRAY_BUFFER,this.bSize); g.bufferData(g.ARRAY_BUFFER,sizes,g.DYNAMIC_DRAW); g.enableVertexAttribArray(this.lSize); g.vertexAttribPointer(this.lSize,1,g.FLOAT,false,0,0); g.bindBuffer(g.ARRAY_BUFFER,this.bCol); g.bufferData(g.ARRAY_BUFFER,cols,g.DYNAMIC_DRAW); g.enableVertexAttribArray(this.lCol); g.vertexAttribPointer(this.lCol,3,g.FLOAT,false,0,0); g.drawArrays(g.POINTS,0,pts.length/2);} }
  class Game{ constructor(){ this.cv=document.getElementById('canvas'); this.gl=new GL(this.cv); this.fps=0; this.frame=0; this.last=performance.now(); this.mouse={x:0.5,y:0.5}; this.state='detached'; this.combo=1; this.score=0; this.timeLeft=60; this.stepTimes=[]; this.keys={}; this.aimSpeed=0.6; this.loop=this.loop.bind(this); this.init(); }
- async init(){ this.mod=await this.loadWASM(); this.mod.init(); this.gl.resize(); addEventListener('resize',()=>this.gl.resize()); this.bindUI(); requestAnimationFrame(this.loop); }
+ async init(){ this.mod=await this.loadSim(); this.mod.init(); this.gl.resize(); addEventListener('resize',()=>this.gl.resize()); this.bindUI(); requestAnimationFrame(this.loop); }
+ // Por defecto la física corre en el hilo principal. Con ?worker (y la página con COOP/COEP) corre en worker.mjs, que
+ // necesita physics.mjs de ./build.sh, y acá sólo se leen snapshots; si el worker no levanta se vuelve al modo directo
+ async loadSim(){ if(new URLSearchParams(location.search).has('worker') && self.crossOriginIsolated && typeof SharedArrayBuffer!=='undefined'){ try{ return await this.loadWorker(); } catch(e){ console.warn('worker no disponible, modo directo',e); } } this.remote=false; return this.loadWASM(); }
+ loadWorker(){ return new Promise((resolve,reject)=>{ const max=300000; const sab=createShared(max); const w=new Worker(new URL('./worker.mjs',import.meta.url),{type:'module'}); w.onmessage=(e)=>{ if(e.data.error||e.data.maxBullets!==max){ w.terminate(); reject(new Error(e.data.error||'maxBullets '+e.data.maxBullets)); return; } this.worker=w; this.remote=true; resolve(new RemoteSim(sab,max)); }; w.onerror=reject; w.postMessage({sab}); }); }
  loadWASM(){ return new Promise((resolve,reject)=>{ const s=document.createElement('script'); s.src='physics.js'; s.onload=async()=>{ try{ if(typeof Module==='function'){ const m=await Module({}); resolve(m);} else if(typeof Module==='object'){ Module.onRuntimeInitialized=()=>resolve(Module);} else reject(new Error('Module not found')); } catch(e){reject(e);} }; s.onerror=reject; document.body.appendChild(s); }); }
- bindUI(){ const $=id=>document.getElementById(id); this.$fps=$('fps'); this.$step=$('step'); this.$iters=$('iters'); this.$time=$('time'); this.$combo=$('combo'); this.$score=$('score'); this.$goals=$('goals'); this.$bullets=$('bullets');
+ bindUI(){ const $=id=>document.getElementById(id); this.$fps=$('fps'); this.$step=$('step'); this.$iters=$('iters'); this.$time=$('time'); this.$combo=$('combo'); this.$score=$('score'); this.$goals=$('goals'); this.$bullets=$('bullets'); this.$pairs=$('pairs'); this.$emitters=$('emitters'); const modeEl=$('mode'); if(modeEl){ modeEl.textContent=this.remote?'worker':'directo'; }
   const resetBtn=$('reset'); if(resetBtn){ resetBtn.addEventListener('click',()=>this.reset()); }
   const stressBtn=$('stress'); if(stressBtn){ stressBtn.addEventListener('click',()=>this.mod.setIterations(256)); }
+  const bpBtn=$('broadphase'); if(bpBtn){ bpBtn.addEventListener('click',()=>{ const on=!this.mod.getBroadphase(); this.mod.setBroadphase(on); bpBtn.textContent='Broadphase: '+(on?'grilla':'off'); }); }
+  const turretsBtn=$('turrets'); if(turretsBtn){ turretsBtn.addEventListener('click',()=>{ if(this.remote) this.mod.turrets(); else spawnTurrets(this.mod); }); }
   // Teclado
   addEventListener('keydown',(e)=>{ this.keys[e.code]=true; if(e.code==='Space'||e.code==='KeyJ'){ if(this.state==='attached'){ this.mod.detach(); this.state='detached'; } else { this.mod.attach(); this.state='attached'; } } if(e.code==='ShiftLeft'||e.code==='ShiftRight'||e.code==='KeyK'){ this.mod.dash(); } if(e.code==='KeyR'){ this.reset(); } });
   addEventListener('keyup',(e)=>{ this.keys[e.code]=false; });
@@ -27,7 +35,8 @@ class GL{ constructor(c){ this.c=c; this.g=c.getContext('webgl'); const g=this.g
    if(this.keys['KeyD']||this.keys['ArrowRight']) this.mouse.x += aim;
    this.mouse.x=Math.max(0,Math.min(1,this.mouse.x)); this.mouse.y=Math.max(0,Math.min(1,this.mouse.y));
    this.mod.setMouse(this.mouse.x,this.mouse.y);
-  const t0=performance.now(); this.mod.step(dt); const stepMs=performance.now()-t0; this.stepTimes.push(stepMs); if(this.stepTimes.length>100){ this.stepTimes.shift(); }
+  // en modo worker step() sólo toma el último snapshot: el tiempo de física lo mide el worker
+  const t0=performance.now(); this.mod.step(dt); const stepMs=this.remote?this.mod.getStepMs():performance.now()-t0; this.stepTimes.push(stepMs); if(this.stepTimes.length>100){ this.stepTimes.shift(); }
   const player=this.mod.getPlayer(); const rope=this.mod.getRope(); const bullets=this.mod.getBullets(); const goals=this.mod.getGoals();
   // build draw buffers
   const nR=rope.length/2, nB=bullets.length/2, nG=goals.length/3; const total=nR+2+nB+nG; const pts=new Float32Array(total*2); const sizes=new Float32Array(total); const cols=new Float32Array(total*3);
@@ -45,7 +54,7 @@ class GL{ constructor(c){ this.c=c; this.g=c.getContext('webgl'); const g=this.g
   // scoring simple: +10 por goal destruido reciente (proxy por diferencia)
   const alive=this.mod.getGoalsAlive(); this._lastAlive=this._lastAlive??alive; if(alive<this._lastAlive){ this.score+=10*(this.combo); this.combo=Math.min(this.combo+1,10); } this._lastAlive=alive;
   // HUD
-  this.frame++; if(this.frame%30===0){ const d=now-(this.lastFps||now); this.fps=Math.round(30000/d); this.lastFps=now; this.$fps.textContent=this.fps; this.$iters.textContent=this.mod.getIterations(); this.$bullets.textContent=this.mod.getBulletCount(); }
+  this.frame++; if(this.frame%30===0){ const d=now-(this.lastFps||now); this.fps=Math.round(30000/d); this.lastFps=now; this.$fps.textContent=this.fps; this.$iters.textContent=this.mod.getIterations(); this.$bullets.textContent=this.mod.getBulletCount(); this.$pairs.textContent=this.mod.getPairTests(); this.$emitters.textContent=this.mod.getEmitterCount(); }
   // p95 step
   const arr=[...this.stepTimes].sort((a,b)=>a-b); const p95=arr.length?arr[Math.floor(arr.length*0.95)]:0; this.$step.textContent=p95.toFixed(2);
   this.$time.textContent=this.timeLeft.toFixed(2); this.$combo.textContent='x'+this.combo; this.$score.textContent=this.score; this.$goals.textContent=(6-alive)+' / 6';
@@ -1,10 +1,22 @@
 #!/bin/bash
 set -euo pipefail
 
+# ./build.sh          -> physics.js (WASM, hilo principal) + physics.mjs (ES6, para worker.mjs)
+# ./build.sh native   -> hookstrike-bench (stress de balas: pares probados con y sin broadphase)
+MODE="${1:-wasm}"
+
+if [ "$MODE" = "native" ]; then
+  echo "🔨 Compilando benchmark nativo (Hookstrike)..."
+  ${CXX:-c++} physics.cpp -O3 -std=c++17 -DHOOKSTRIKE_BENCH -o hookstrike-bench
+  echo "✅ Compilación OK → ./hookstrike-bench"
+  exit 0
+fi
+
 echo "🔨 Compilando Hookstrike (WASM) ..."
 
 emcc physics.cpp \
   -O3 \
+  -msimd128 \
   --bind \
   -s WASM=1 \
   -s MODULARIZE=1 \
@@ -12,5 +24,18 @@ emcc physics.cpp \
   -s ALLOW_MEMORY_GROWTH=1 \
   -o physics.js
 
-echo "✅ Compilación OK"
-ls -la physics.js physics.wasm || true
+# Mismo código como módulo ES6 para worker.mjs (navegador o worker_threads de Node).
+# El modo worker necesita SharedArrayBuffer: servir con COOP same-origin + COEP require-corp.
+emcc physics.cpp \
+  -O3 \
+  -msimd128 \
+  --bind \
+  -s WASM=1 \
+  -s MODULARIZE=1 \
+  -s EXPORT_ES6=1 \
+  -s ENVIRONMENT=web,worker,node \
+  -s ALLOW_MEMORY_GROWTH=1 \
+  -o physics.mjs
+
+echo "✅ Compilación OK (test headless del worker: node worker-node.mjs)"
+ls -la physics.js physics.mjs physics.wasm || true
@@ -1,9 +1,12 @@
+#ifdef __EMSCRIPTEN__
 #include <emscripten/bind.h>
+using namespace emscripten;
+#endif
 #include <vector>
 #include <cmath>
 #include <cstdint>
 #include <algorithm>
-using namespace emscripten;
+#include <chrono>
 
 struct Vec2{ float x,y; };
 static inline Vec2 add(const Vec2&a,const Vec2&b){ return {a.x+b.x,a.y+b.y}; }
@@ -22,12 +25,30 @@ static bool ropeActive=false; static Vec2 anchor{0.5f,0.5f};
 static std::vector<Vec2> rope, ropePrev; static float ropeSegLen=0.008f; static int ropeIter=64; static int substeps=4;
 static float airDamp=0.9992f; static float dashSpeed=0.6f; static int dashCooldown=0; // ms
 
-// Bullets SoA
+// Bullets SoA: pool de capacidad fija, se dimensiona una vez en init() y no vuelve a crecer.
+// Vivas en [0,bullets); las que salen de [0,1]^2 se compactan una vez por frame en stepBullets().
 static std::vector<float> bx, by, bvx, bvy; static int bullets=0; static const int MAXB=300000;
 
+// Emisores: patrones de disparo por datos. Cada ráfaga dispara count balas a speed:
+//  EMIT_RING   en círculo; con spin rota la fase entre ráfagas (espiral)
+//  EMIT_FAN    abanico de spread radianes centrado en angle, o apuntado al player si aimed
+// rate = ráfagas por segundo, bursts = ráfagas restantes (-1 infinitas), delay = segundos antes de la primera.
+enum { EMIT_RING=0, EMIT_FAN=1 };
+struct Emitter{ bool alive; int type; Vec2 p; int count; float speed, rate, angle, spin, spread, delay, t; int bursts; bool aimed; };
+static const int MAX_EMITTERS=64; static Emitter emitters[MAX_EMITTERS];
+
 // Goals (objetivos a romper)
 struct Goal{ Vec2 p; float r; bool alive; }; static std::vector<Goal> goals;
 
+// Broadphase: grilla uniforme sobre [0,1]^2 con los segmentos de la cuerda en CSR, rearmada en cada
+// checkCollisions(). Cada segmento entra en las celdas de su AABB inflada por PARRY_R en orden de índice,
+// así en la celda de la bala el primer segmento que pega es el mismo que en el barrido completo.
+// Las balas no se reordenan: la celda de cada una se calcula al pasar y decide qué pares se prueban.
+static const int GRID=64; static const float PARRY_R=0.005f;
+static bool broadphase=true; static long long pairTests=0; // pares probados en el último frame (rope + player)
+static double collideMs=0; // ms de checkCollisions() en el último step()
+static std::vector<int> cellStart(GRID*GRID+1), cellFill(GRID*GRID), cellSegs;
+
 // HUD buffers
 static std::vector<float> ropeBuf, playerBuf, bulletBuf, goalBuf;
 
@@ -50,22 +71,85 @@ static inline void solveRope(){ for(int it=0;it<ropeIter;++it){ for(size_t i=0;i
 
 static inline void updatePlayer(float dt){ if(ropeActive && !rope.empty()){ Vec2 prev=player.p; player.p=rope[0]; player.v=mul(sub(player.p,prev),1.0f/std::max(dt,1e-6f)); } else { player.v=mul(player.v,0.998f); player.p=add(player.p,mul(player.v,dt)); } clamp(player.p,player.v); }
 
-static inline void spawnBullet(Vec2 p, Vec2 v){ if(bullets>=MAXB) return; bx.push_back(p.x); by.push_back(p.y); bvx.push_back(v.x); bvy.push_back(v.y); bullets++; }
+static inline void allocBullets(){ bx.resize(MAXB); by.resize(MAXB); bvx.resize(MAXB); bvy.resize(MAXB); }
 
-static inline void stepBullets(float dt){ for(int i=0;i<bullets;i++){ bx[i]+=bvx[i]*dt; by[i]+=bvy[i]*dt; if(bx[i]<0||bx[i]>1||by[i]<0||by[i]>1){ bx[i]=bx[bullets-1]; by[i]=by[bullets-1]; bvx[i]=bvx[bullets-1]; bvy[i]=bvy[bullets-1]; bullets--; i--; } } }
+// Las balas no interactúan entre sí ni dentro de los substeps: se integran una vez por frame con el dt
+// completo. Una pasada sin saltos que el compilador vectoriza (-msimd128 en wasm), y después una
+// compactación estable sin ramas sólo si alguna salió del mundo.
+static inline void stepBullets(float dt){
+  // un puntero restrict por array, el mismo en las dos pasadas
+  float * __restrict x=bx.data(); float * __restrict y=by.data(); float * __restrict vx=bvx.data(); float * __restrict vy=bvy.data();
+  const int n=bullets; int out=0;
+  for(int i=0;i<n;i++){ x[i]+=vx[i]*dt; y[i]+=vy[i]*dt; out += (x[i]<0.0f)|(x[i]>1.0f)|(y[i]<0.0f)|(y[i]>1.0f); }
+  if(out==0) return;
+  int w=0;
+  for(int i=0;i<n;i++){ const float px=x[i], py=y[i]; x[w]=px; y[w]=py; vx[w]=vx[i]; vy[w]=vy[i]; w += (px>=0.0f)&(px<=1.0f)&(py>=0.0f)&(py<=1.0f); }
+  bullets=w;
+}
 
-static inline void spawnTurretRing(Vec2 center,int count,float speed){ for(int i=0;i<count;i++){ float a= (6.2831853f*(float)i)/(float)count; Vec2 v={std::cos(a)*speed, std::sin(a)*speed}; spawnBullet(center,v); } }
+// count balas desde c en ángulos a0 + i*da, recortado a la capacidad del pool
+static inline void spawnArc(Vec2 c,int count,float speed,float a0,float da){
+  const int n=std::min(count, MAXB-bullets); float *x=&bx[bullets], *y=&by[bullets], *vx=&bvx[bullets], *vy=&bvy[bullets];
+  for(int i=0;i<n;i++){ const float a=a0+da*(float)i; x[i]=c.x; y[i]=c.y; vx[i]=std::cos(a)*speed; vy[i]=std::sin(a)*speed; }
+  bullets+=n;
+}
 
-static inline void initGoals(){ goals.clear(); goals.push_back({{0.2f,0.2f},0.02f,true}); goals.push_back({{0.8f,0.2f},0.02f,true}); goals.push_back({{0.2f,0.8f},0.02f,true}); goals.push_back({{0.8f,0.8f},0.02f,true}); goals.push_back({{0.5f,0.5f},0.03f,true}); goals.push_back({{0.5f,0.2f},0.02f,true}); }
+static inline void spawnTurretRing(Vec2 center,int count,float speed){ spawnArc(center, count, speed, 0.0f, 6.2831853f/(float)count); }
 
-static inline void checkCollisions(){ // player-bullets
-  for(int i=0;i<bullets;i++){ float dx=bx[i]-player.p.x; float dy=by[i]-player.p.y; float rr=player.r*player.r; if(dx*dx+dy*dy<rr){ /* penalización por ahora: eliminar bala */ bx[i]=bx[bullets-1]; by[i]=by[bullets-1]; bvx[i]=bvx[bullets-1]; bvy[i]=bvy[bullets-1]; bullets--; i--; }
+static inline void fireBurst(Emitter &e){
+  if(e.type==EMIT_RING){ spawnArc(e.p, e.count, e.speed, e.angle, 6.2831853f/(float)e.count); }
+  else { const float c = e.aimed? std::atan2(player.p.y-e.p.y, player.p.x-e.p.x) : e.angle;
+    if(e.count<=1) spawnArc(e.p, 1, e.speed, c, 0.0f); else spawnArc(e.p, e.count, e.speed, c-0.5f*e.spread, e.spread/(float)(e.count-1)); }
+}
+
+static inline void updateEmitters(float dt){
+  for(auto &e: emitters){ if(!e.alive) continue;
+    if(e.delay>0){ e.delay-=dt; if(e.delay>0) continue; e.t=1.0f/e.rate; } // la primera ráfaga sale al terminar el delay
+    else e.t+=dt;
+    const float period=1.0f/e.rate;
+    while(e.t>=period && e.bursts!=0){ fireBurst(e); e.t-=period; e.angle+=e.spin*period; if(e.bursts>0) e.bursts--; }
+    if(e.bursts==0) e.alive=false;
   }
-  // rope parry: si la distancia bala-seg ≤ 0.005 y velocidad relativa adecuada, reflejar
-  for(int i=0;i<bullets;i++){
-    for(size_t s=0;s+1<rope.size();++s){ Vec2 a=rope[s], b=rope[s+1]; Vec2 ab=sub(b,a); float t = dot(sub(Vec2{bx[i],by[i]},a),ab)/std::max(1e-6f,dot(ab,ab)); t=std::max(0.0f,std::min(1.0f,t)); Vec2 closest=add(a,mul(ab,t)); float dx=bx[i]-closest.x, dy=by[i]-closest.y; float d2=dx*dx+dy*dy; if(d2<0.000025f){ // 0.005^2
-      // reflect about segment normal
-      Vec2 n=norm(Vec2{-ab.y, ab.x}); float vn = bvx[i]*n.x + bvy[i]*n.y; bvx[i]-=2*vn*n.x; bvy[i]-=2*vn*n.y; break; }
+}
+
+static inline void initGoals(){ goals.clear(); goals.push_back({{0.2f,0.2f},0.02f,true}); goals.push_back({{0.8f,0.2f},0.02f,true}); goals.push_back({{0.2f,0.8f},0.02f,true}); goals.push_back({{0.8f,0.8f},0.02f,true}); goals.push_back({{0.5f,0.5f},0.03f,true}); goals.push_back({{0.5f,0.2f},0.02f,true}); }
+
+static inline bool hitsPlayer(int i){ float dx=bx[i]-player.p.x; float dy=by[i]-player.p.y; float rr=player.r*player.r; return dx*dx+dy*dy<rr; }
+static inline void removeBullet(int i){ bx[i]=bx[bullets-1]; by[i]=by[bullets-1]; bvx[i]=bvx[bullets-1]; bvy[i]=bvy[bullets-1]; bullets--; }
+// rope parry: si la distancia bala-seg ≤ 0.005 y velocidad relativa adecuada, reflejar
+static inline bool parry(int i,size_t s){ Vec2 a=rope[s], b=rope[s+1]; Vec2 ab=sub(b,a); float t = dot(sub(Vec2{bx[i],by[i]},a),ab)/std::max(1e-6f,dot(ab,ab)); t=std::max(0.0f,std::min(1.0f,t)); Vec2 closest=add(a,mul(ab,t)); float dx=bx[i]-closest.x, dy=by[i]-closest.y; float d2=dx*dx+dy*dy; if(d2<PARRY_R*PARRY_R){
+    // reflect about segment normal
+    Vec2 n=norm(Vec2{-ab.y, ab.x}); float vn = bvx[i]*n.x + bvy[i]*n.y; bvx[i]-=2*vn*n.x; bvy[i]-=2*vn*n.y; return true; }
+  return false; }
+
+static inline int cellOf(float v){ int c=(int)(v*GRID); return c<0?0:(c>=GRID?GRID-1:c); }
+static void buildRopeGrid(){ // conteo, prefijo y llenado en orden de segmento
+  std::fill(cellFill.begin(), cellFill.end(), 0);
+  auto range=[](size_t s,int &x0,int &x1,int &y0,int &y1){ const Vec2 &a=rope[s], &b=rope[s+1];
+    x0=cellOf(std::min(a.x,b.x)-PARRY_R); x1=cellOf(std::max(a.x,b.x)+PARRY_R); y0=cellOf(std::min(a.y,b.y)-PARRY_R); y1=cellOf(std::max(a.y,b.y)+PARRY_R); };
+  int x0,x1,y0,y1;
+  for(size_t s=0;s+1<rope.size();++s){ range(s,x0,x1,y0,y1); for(int y=y0;y<=y1;y++) for(int x=x0;x<=x1;x++) cellFill[y*GRID+x]++; }
+  cellStart[0]=0; for(int c=0;c<GRID*GRID;c++){ cellStart[c+1]=cellStart[c]+cellFill[c]; cellFill[c]=cellStart[c]; }
+  cellSegs.resize(cellStart[GRID*GRID]);
+  for(size_t s=0;s+1<rope.size();++s){ range(s,x0,x1,y0,y1); for(int y=y0;y<=y1;y++) for(int x=x0;x<=x1;x++) cellSegs[cellFill[y*GRID+x]++]=(int)s; }
+}
+
+static inline void checkCollisions(){
+  pairTests=0;
+  if(!broadphase){ // barrido completo: todas las balas contra el player y contra todos los segmentos
+    for(int i=0;i<bullets;i++){ pairTests++; if(hitsPlayer(i)){ /* penalización por ahora: eliminar bala */ removeBullet(i); i--; } }
+    for(int i=0;i<bullets;i++){ for(size_t s=0;s+1<rope.size();++s){ pairTests++; if(parry(i,s)) break; } }
+  } else {
+    // una sola pasada por las balas: el player sólo se prueba si la bala cae en una celda de su AABB y la
+    // cuerda sólo con los segmentos de la celda de la bala. Sacar una bala no toca las velocidades,
+    // así que el resultado es el mismo que con las dos pasadas del barrido completo.
+    buildRopeGrid();
+    const int px0=cellOf(player.p.x-player.r), px1=cellOf(player.p.x+player.r), py0=cellOf(player.p.y-player.r), py1=cellOf(player.p.y+player.r);
+    for(int i=0;i<bullets;i++){
+      const int cx=cellOf(bx[i]), cy=cellOf(by[i]);
+      if(cx>=px0 && cx<=px1 && cy>=py0 && cy<=py1){ pairTests++; if(hitsPlayer(i)){ removeBullet(i); i--; continue; } }
+      const int c=cy*GRID+cx;
+      for(int k=cellStart[c];k<cellStart[c+1];k++){ pairTests++; if(parry(i,(size_t)cellSegs[k])) break; }
     }
   }
   // player-goal
@@ -73,7 +157,7 @@ static inline void checkCollisions(){ // player-bullets
 }
 
 // API
-void init(){ player=Player(); rope.clear(); ropePrev.clear(); ropeActive=false; bx.clear(); by.clear(); bvx.clear(); bvy.clear(); bullets=0; initGoals(); }
+void init(){ player=Player(); rope.clear(); ropePrev.clear(); ropeActive=false; allocBullets(); bullets=0; bulletBuf.reserve(MAXB*2); for(auto &e: emitters) e.alive=false; initGoals(); }
 void setMouse(float x,float y){ anchor={x,y}; }
 void attach(){ buildRopeTo(player.p, anchor); }
 void detach(){ ropeActive=false; rope.clear(); ropePrev.clear(); }
@@ -81,18 +165,42 @@ void dash(){ if(dashCooldown>0) return; Vec2 dir=norm(sub(anchor,player.p)); pla
 void setIterations(int it){ ropeIter= std::max(1,it); }
 int  getIterations(){ return ropeIter; }
 int  getBulletCount(){ return bullets; }
+int  getMaxBullets(){ return MAXB; }
+// devuelve el id del emisor o -1 si no hay lugar
+int  createEmitter(int type,float x,float y,int count,float speed,float rate,int bursts){
+  for(int i=0;i<MAX_EMITTERS;i++){ if(emitters[i].alive) continue;
+    emitters[i]={true, type==EMIT_FAN?EMIT_FAN:EMIT_RING, {x,y}, std::max(1,count), speed, std::max(1e-3f,rate), 0.0f, 0.0f, 0.5f, 0.0f, 0.0f, bursts, false};
+    emitters[i].t=1.0f/emitters[i].rate; // primera ráfaga en el próximo step
+    return i; }
+  return -1;
+}
+static inline bool validEmitter(int id){ return id>=0 && id<MAX_EMITTERS && emitters[id].alive; }
+void destroyEmitter(int id){ if(validEmitter(id)) emitters[id].alive=false; }
+void setEmitterAngle(int id,float a,float spin){ if(validEmitter(id)){ emitters[id].angle=a; emitters[id].spin=spin; } }
+void setEmitterSpread(int id,float spread,bool aimed){ if(validEmitter(id)){ emitters[id].spread=spread; emitters[id].aimed=aimed; } }
+void setEmitterDelay(int id,float s){ if(validEmitter(id)) emitters[id].delay=s; }
+int  getEmitterCount(){ int c=0; for(auto &e: emitters) if(e.alive) c++; return c; }
 int  getGoalsAlive(){ int c=0; for(auto &g:goals) if(g.alive) c++; return c; }
+void setBroadphase(bool on){ broadphase=on; }
+bool getBroadphase(){ return broadphase; }
+double getPairTests(){ return (double)pairTests; }
+double getCollideMs(){ return collideMs; }
 
+#ifdef __EMSCRIPTEN__
 val getPlayer(){ static float p[2]; p[0]=player.p.x; p[1]=player.p.y; return val(typed_memory_view(2,p)); }
 val getRope(){ ropeBuf.resize(rope.size()*2); for(size_t i=0;i<rope.size();++i){ ropeBuf[i*2]=rope[i].x; ropeBuf[i*2+1]=rope[i].y; } return val(typed_memory_view(ropeBuf.size(), ropeBuf.data())); }
 val getBullets(){ bulletBuf.resize(bullets*2); for(int i=0;i<bullets;i++){ bulletBuf[i*2]=bx[i]; bulletBuf[i*2+1]=by[i]; } return val(typed_memory_view(bulletBuf.size(), bulletBuf.data())); }
 val getGoals(){ goalBuf.clear(); for(auto &g:goals){ if(!g.alive) continue; goalBuf.push_back(g.p.x); goalBuf.push_back(g.p.y); goalBuf.push_back(g.r); } return val(typed_memory_view(goalBuf.size(), goalBuf.data())); }
+#endif
 
 void step(float dtMs){ float dt=dtMs/1000.0f; float h=dt/(float)substeps; if(dashCooldown>0) dashCooldown-= (int)std::round(dtMs);
   for(int s=0;s<substeps;++s){ if(ropeActive){ if(rope.empty()) buildRopeTo(player.p, anchor); rope[0]=player.p; ropePrev[0]=player.p; anchorC(); verlet(rope,ropePrev,h); for(int it=0;it<ropeIter;++it){ for(size_t i=0;i+1<rope.size();++i) satisfy(rope,(int)i,(int)i+1,ropeSegLen); anchorC(); } }
-    updatePlayer(h); stepBullets(h); }
-  checkCollisions(); }
+    updatePlayer(h); }
+  updateEmitters(dt); stepBullets(dt);
+  auto t0=std::chrono::steady_clock::now(); checkCollisions();
+  collideMs=std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now()-t0).count(); }
 
+#ifdef __EMSCRIPTEN__
 EMSCRIPTEN_BINDINGS(hookstrike){
   function("init", &init);
   function("setMouse", &setMouse);
@@ -102,10 +210,74 @@ EMSCRIPTEN_BINDINGS(hookstrike){
   function("setIterations", &setIterations);
   function("getIterations", &getIterations);
   function("getBulletCount", &getBulletCount);
+  function("getMaxBullets", &getMaxBullets);
+  function("createEmitter", &createEmitter);
+  function("destroyEmitter", &destroyEmitter);
+  function("setEmitterAngle", &setEmitterAngle);
+  function("setEmitterSpread", &setEmitterSpread);
+  function("setEmitterDelay", &setEmitterDelay);
+  function("getEmitterCount", &getEmitterCount);
   function("getGoalsAlive", &getGoalsAlive);
+  function("setBroadphase", &setBroadphase);
+  function("getBroadphase", &getBroadphase);
+  function("getPairTests", &getPairTests);
+  function("getCollideMs", &getCollideMs);
   function("getPlayer", &getPlayer);
   function("getRope", &getRope);
   function("getBullets", &getBullets);
   function("getGoals", &getGoals);
   function("step", &step);
 }
+#endif
+
+#ifdef HOOKSTRIKE_BENCH
+// Benchmark nativo (./build.sh native):
+//  1) anillos de torretas con la cuerda enganchada: pares probados y ms por frame con barrido completo
+//     vs grilla, y que el estado final coincida
+//  2) emisores sosteniendo el pool lleno (300K): ms por frame y de colisiones, y que ningún buffer
+//     se realoque en régimen
+#include <cstdio>
+
+static void stressScene(float seg){
+  init(); ropeSegLen=seg; player.p={0.1f,0.5f}; setMouse(0.9f,0.55f); attach();
+  for(int k=0;k<10;k++) spawnTurretRing({0.15f+0.07f*k, 0.3f+0.04f*k}, 30000, 0.05f+0.01f*k);
+}
+static double msSince(std::chrono::steady_clock::time_point t){ return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now()-t).count(); }
+
+int main(){
+  for(float seg : {0.008f, 0.0004f}){ // cuerda por defecto (~100 segmentos) y al límite de 2000
+    std::vector<float> ref[4];
+    for(int bp=0; bp<2; bp++){
+      stressScene(seg); setBroadphase(bp==1);
+      const int frames=8; double tests=0;
+      auto t0=std::chrono::steady_clock::now();
+      for(int f=0;f<frames;f++){ step(16.6f); tests+=pairTests; }
+      double ms=msSince(t0)/frames;
+      bool same=true;
+      std::vector<float> cur[4]={ {bx.begin(),bx.begin()+bullets}, {by.begin(),by.begin()+bullets}, {bvx.begin(),bvx.begin()+bullets}, {bvy.begin(),bvy.begin()+bullets} };
+      if(bp==0){ for(int k=0;k<4;k++) ref[k]=cur[k]; }
+      else for(int k=0;k<4;k++) same = same && cur[k]==ref[k];
+      std::printf("segmentos %4d  %-8s balas %6d  %12.0f pares/frame  %9.3f ms/frame%s\n", (int)rope.size()-1,
+                  bp? "grilla" : "completo", bullets, tests/frames, ms, bp? (same? "  (mismo estado)" : "  (DIFIERE)") : "");
+    }
+  }
+
+  // pool lleno: 4 espirales + 4 abanicos apuntados, ~190K balas/s; cada una vive ~1-2 s
+  init(); ropeSegLen=0.008f; player.p={0.5f,0.5f}; setMouse(0.9f,0.2f); attach();
+  for(int k=0;k<4;k++){ int e=createEmitter(EMIT_RING, 0.2f+0.6f*(k&1), 0.2f+0.6f*(k>>1), 400, 0.3f, 60.0f, -1); setEmitterAngle(e, 0.0f, 1.5f+k); }
+  for(int k=0;k<4;k++){ int e=createEmitter(EMIT_FAN, 0.5f+0.45f*std::cos(k*1.57f), 0.5f+0.45f*std::sin(k*1.57f), 400, 0.35f, 60.0f, -1); setEmitterSpread(e, 1.2f, true); }
+  for(int f=0;f<180;f++) step(16.6f); // llenar
+  const float *p0=bx.data(); const size_t cap0=bulletBuf.capacity()+cellSegs.capacity();
+  double collideSum=0, frameMs=0; long alive=0; const int frames=300;
+  for(int f=0;f<frames;f++){
+    auto t0=std::chrono::steady_clock::now();
+    step(16.6f);
+    frameMs+=msSince(t0); collideSum+=collideMs; // colisiones medidas dentro del mismo step()
+    alive+=bullets;
+  }
+  std::printf("pool %d/%d balas  frame %.3f ms  (colisiones %.3f ms)  realocaciones: %s\n",
+              (int)(alive/frames), MAXB, frameMs/frames, collideSum/frames,
+              (p0==bx.data() && cap0==bulletBuf.capacity()+cellSegs.capacity())? "ninguna" : "SI");
+  return 0;
+}
+#endif
@@ -0,0 +1,143 @@
+// Estado compartido entre el hilo principal y el worker de física (SharedArrayBuffer).
+//
+// Un solo SAB con tres regiones:
+//  - control: índice del slot "del medio" del triple buffer + bit FRESH, y contadores
+//  - cola de comandos: ring SPSC sin locks (main escribe, worker lee), registros de 4 words
+//  - 3 slots de snapshot: el worker escribe siempre en su slot "back" y lo intercambia con el del medio;
+//    el renderer toma el del medio sólo si hay uno nuevo. Nunca comparten un slot: el frame leído
+//    siempre está completo (frame en cabecera == frame en el trailer).
+//
+// El mismo archivo lo usan app.js (RemoteSim), worker.mjs (SimHost) y worker-node.mjs (test headless).
+
+export const OP = { SET_MOUSE: 1, ATTACH: 2, DETACH: 3, DASH: 4, RESET: 5, SET_ITERATIONS: 6, SET_BROADPHASE: 7, TURRETS: 8 };
+
+const CTRL_WORDS = 16, C_MIDDLE = 0, C_PUBLISHED = 1, C_DROPPED = 2;
+const FRESH = 4;
+const RING_CAP = 256, RING_HDR = 2, REC = 4; // head, tail; registro: op, a, b, c
+const HDR = 16; // cabecera de cada slot en words
+export const H = { FRAME: 0, ROPE: 1, BULLETS: 2, GOALS: 3, ALIVE: 4, ITERS: 5, BROAD: 6, EMITTERS: 7, STEP_MS: 8, PAIRS: 9, PX: 10, PY: 11 };
+export const ROPE_MAX = 2001, GOALS_MAX = 16;
+
+export function layout(maxBullets) {
+  const ring = CTRL_WORDS, slots = ring + RING_HDR + RING_CAP * REC;
+  const rope = HDR, bullets = rope + ROPE_MAX * 2, goals = bullets + maxBullets * 2, trailer = goals + GOALS_MAX * 3;
+  const slotWords = trailer + 1;
+  return { ring, slots, rope, bullets, goals, trailer, slotWords, bytes: (slots + 3 * slotWords) * 4 };
+}
+
+export function createShared(maxBullets) {
+  const L = layout(maxBullets);
+  const sab = new SharedArrayBuffer(L.bytes);
+  new Int32Array(sab)[C_MIDDLE] = 1; // writer arranca con back=0, reader con front=2
+  return sab;
+}
+
+class Views {
+  constructor(sab, maxBullets) {
+    this.L = layout(maxBullets); this.i32 = new Int32Array(sab); this.f32 = new Float32Array(sab);
+  }
+  slotBase(s) { return this.L.slots + s * this.L.slotWords; }
+}
+
+// 4 espirales en las esquinas + 4 abanicos apuntados al player: llenan el pool de 300K balas
+export function spawnTurrets(mod) {
+  for (let k = 0; k < 4; k++) { const e = mod.createEmitter(0, 0.2 + 0.6 * (k & 1), 0.2 + 0.6 * (k >> 1), 400, 0.3, 60, -1); mod.setEmitterAngle(e, 0, 1.5 + k); }
+  for (let k = 0; k < 4; k++) { const e = mod.createEmitter(1, 0.5 + 0.45 * Math.cos(k * Math.PI / 2), 0.5 + 0.45 * Math.sin(k * Math.PI / 2), 400, 0.35, 60, -1); mod.setEmitterSpread(e, 1.2, true); mod.setEmitterDelay(e, 0.5); }
+}
+
+// Lado worker: drena comandos hacia el módulo y publica snapshots
+export class SimHost extends Views {
+  constructor(sab, mod) { super(sab, mod.getMaxBullets()); this.mod = mod; this.back = 0; this.frame = 0; }
+
+  drainCommands() {
+    const { i32, f32 } = this, r = this.L.ring, m = this.mod;
+    let tail = i32[r + 1]; const head = Atomics.load(i32, r);
+    for (; tail !== head; tail = (tail + 1) | 0) {
+      const o = r + RING_HDR + (tail % RING_CAP) * REC, a = f32[o + 1], b = f32[o + 2];
+      switch (i32[o]) {
+        case OP.SET_MOUSE: m.setMouse(a, b); break;
+        case OP.ATTACH: m.attach(); break;
+        case OP.DETACH: m.detach(); break;
+        case OP.DASH: m.dash(); break;
+        case OP.RESET: m.init(); break;
+        case OP.SET_ITERATIONS: m.setIterations(a | 0); break;
+        case OP.SET_BROADPHASE: m.setBroadphase(a !== 0); break;
+        case OP.TURRETS: spawnTurrets(m); break;
+      }
+    }
+    Atomics.store(i32, r + 1, tail);
+  }
+
+  publish(stepMs) {
+    const { i32, f32, L } = this, m = this.mod, base = this.slotBase(this.back), frame = ++this.frame;
+    i32[base + H.FRAME] = frame;
+    const rope = m.getRope(), ropeN = Math.min(rope.length >> 1, ROPE_MAX);
+    f32.set(rope.subarray(0, ropeN * 2), base + L.rope);
+    const bullets = m.getBullets(); f32.set(bullets, base + L.bullets);
+    const goals = m.getGoals(), goalN = Math.min(goals.length / 3, GOALS_MAX);
+    f32.set(goals.subarray(0, goalN * 3), base + L.goals);
+    const p = m.getPlayer();
+    i32[base + H.ROPE] = ropeN; i32[base + H.BULLETS] = bullets.length >> 1; i32[base + H.GOALS] = goalN;
+    i32[base + H.ALIVE] = m.getGoalsAlive(); i32[base + H.ITERS] = m.getIterations(); i32[base + H.BROAD] = m.getBroadphase() ? 1 : 0;
+    i32[base + H.EMITTERS] = m.getEmitterCount();
+    f32[base + H.STEP_MS] = stepMs; f32[base + H.PAIRS] = m.getPairTests(); f32[base + H.PX] = p[0]; f32[base + H.PY] = p[1];
+    i32[base + L.trailer] = frame;
+    // publicar: el back pasa a ser el del medio y nos quedamos con el que estaba ahí
+    const prev = Atomics.exchange(i32, C_MIDDLE, this.back | FRESH);
+    if (prev & FRESH) Atomics.add(i32, C_DROPPED, 1); // el renderer no llegó a leer el anterior
+    this.back = prev & 3;
+    Atomics.add(i32, C_PUBLISHED, 1);
+  }
+}
+
+// Lado renderer: misma API que usa app.js del módulo, pero step() sólo toma el último frame publicado
+// y los getters son vistas sobre ese slot (sin copias). Los comandos van por la cola.
+export class RemoteSim extends Views {
+  constructor(sab, maxBullets) { super(sab, maxBullets); this.front = 2; this.base = this.slotBase(2); this.maxBullets = maxBullets; }
+
+  send(op, a = 0, b = 0, c = 0) {
+    const { i32, f32 } = this, r = this.L.ring;
+    const head = i32[r];
+    if (((head - Atomics.load(i32, r + 1)) | 0) >= RING_CAP) return false; // llena: el worker está trabado
+    const o = r + RING_HDR + (head % RING_CAP) * REC;
+    i32[o] = op; f32[o + 1] = a; f32[o + 2] = b; f32[o + 3] = c;
+    Atomics.store(i32, r, (head + 1) | 0);
+    return true;
+  }
+
+  // toma el slot del medio si el worker publicó uno nuevo; devuelve el número de frame visible
+  latest() {
+    const i32 = this.i32;
+    if (Atomics.load(i32, C_MIDDLE) & FRESH) {
+      this.front = Atomics.exchange(i32, C_MIDDLE, this.front) & 3;
+      this.base = this.slotBase(this.front);
+    }
+    return i32[this.base + H.FRAME];
+  }
+  complete() { return this.i32[this.base + H.FRAME] === this.i32[this.base + this.L.trailer]; }
+  published() { return Atomics.load(this.i32, C_PUBLISHED); }
+  dropped() { return Atomics.load(this.i32, C_DROPPED); }
+
+  // API del módulo
+  init() { this.send(OP.RESET); }
+  setMouse(x, y) { this.send(OP.SET_MOUSE, x, y); }
+  attach() { this.send(OP.ATTACH); }
+  detach() { this.send(OP.DETACH); }
+  dash() { this.send(OP.DASH); }
+  setIterations(n) { this.send(OP.SET_ITERATIONS, n); }
+  setBroadphase(on) { this.send(OP.SET_BROADPHASE, on ? 1 : 0); }
+  turrets() { this.send(OP.TURRETS); }
+  step() { this.latest(); }
+  getStepMs() { return this.f32[this.base + H.STEP_MS]; }
+  getPlayer() { return this.f32.subarray(this.base + H.PX, this.base + H.PY + 1); }
+  getRope() { const o = this.base + this.L.rope; return this.f32.subarray(o, o + this.i32[this.base + H.ROPE] * 2); }
+  getBullets() { const o = this.base + this.L.bullets; return this.f32.subarray(o, o + this.i32[this.base + H.BULLETS] * 2); }
+  getGoals() { const o = this.base + this.L.goals; return this.f32.subarray(o, o + this.i32[this.base + H.GOALS] * 3); }
+  getGoalsAlive() { return this.i32[this.base + H.ALIVE]; }
+  getIterations() { return this.i32[this.base + H.ITERS]; }
+  getBroadphase() { return this.i32[this.base + H.BROAD] !== 0; }
+  getBulletCount() { return this.i32[this.base + H.BULLETS]; }
+  getPairTests() { return this.f32[this.base + H.PAIRS]; }
+  getEmitterCount() { return this.i32[this.base + H.EMITTERS]; }
+  getMaxBullets() { return this.maxBullets; }
+}
@@ -0,0 +1,42 @@
+// Test headless del modo worker: node worker-node.mjs [segundos] [modulo.mjs]
+// Levanta worker.mjs con worker_threads, manda input por la cola y lee snapshots como lo haría el renderer.
+// Falla (exit 1) si no llegan frames, si algún frame leído está incompleto o si el input no llega.
+import { Worker } from 'node:worker_threads';
+import { createShared, RemoteSim } from './shared.mjs';
+
+const secs = Number(process.argv[2] ?? 2);
+const url = process.argv[3] ? new URL(process.argv[3], `file://${process.cwd()}/`).href : undefined;
+
+const MAXB = 300000; // igual que MAXB en physics.cpp; el worker lo confirma en ready
+const sab = createShared(MAXB);
+const w = new Worker(new URL('./worker.mjs', import.meta.url));
+const ready = await new Promise((res, rej) => { w.once('message', res); w.once('error', rej); w.postMessage({ sab, url }); });
+if (ready.error) { console.error(ready.error); process.exit(1); }
+if (ready.maxBullets !== MAXB) { console.error(`maxBullets ${ready.maxBullets} != ${MAXB}`); process.exit(1); }
+
+const sim = new RemoteSim(sab, MAXB);
+sim.setMouse(0.5, 0.1); sim.attach(); sim.turrets();
+
+let reads = 0, torn = 0, lastFrame = 0, stale = 0, maxBullets = 0, maxRope = 0, worst = 0;
+const t0 = performance.now();
+await new Promise((res) => {
+  const read = () => {
+    const frame = sim.latest(); reads++;
+    if (frame === lastFrame) stale++;
+    if (frame < lastFrame || !sim.complete()) torn++;
+    lastFrame = frame;
+    maxBullets = Math.max(maxBullets, sim.getBulletCount()); maxRope = Math.max(maxRope, sim.getRope().length >> 1); worst = Math.max(worst, sim.getStepMs());
+    // el mouse se mueve como en el juego: un comando por frame de render
+    const t = (performance.now() - t0) / 1000; sim.setMouse(0.5 + 0.3 * Math.cos(t), 0.3 + 0.2 * Math.sin(t));
+    if (t < secs) setTimeout(read, 16); else res();
+  };
+  read();
+});
+await w.terminate();
+
+const published = sim.published(), fps = published / secs;
+console.log(`frames publicados ${published} (${fps.toFixed(1)}/s) · descartados ${sim.dropped()} · lecturas ${reads} (repetidas ${stale}) · incompletas ${torn}`);
+console.log(`balas máx ${maxBullets} · nodos de cuerda máx ${maxRope} · step peor ${worst.toFixed(2)} ms`);
+const ok = published > 0 && torn === 0 && maxRope > 0 && maxBullets > 0;
+console.log(ok ? 'OK' : 'FALLO');
+process.exit(ok ? 0 : 1);
@@ -0,0 +1,36 @@
+// Worker de física: corre la simulación a paso fijo fuera del hilo principal.
+// Sirve como module worker del navegador y como worker_threads de Node (worker-node.mjs).
+//
+// Mensaje inicial: { sab, url? } con el SAB creado por createShared(); responde { ready, maxBullets }.
+// Desde ahí no hay más postMessage: comandos por la cola y snapshots por el triple buffer.
+import { SimHost } from './shared.mjs';
+
+const HZ = 60, DT = 1000 / HZ, MAX_CATCHUP = 4; // pasos máximos por tick si el worker se atrasa
+
+const isNode = typeof self === 'undefined';
+const port = isNode ? (await import('node:worker_threads')).parentPort : self;
+const on = (fn) => isNode ? port.on('message', fn) : port.addEventListener('message', (e) => fn(e.data));
+
+on(async ({ sab, url }) => {
+  // physics.mjs es el build ES6 de build.sh; el test headless puede pasar otro módulo
+  let mod;
+  try { const { default: factory } = await import(url ?? './physics.mjs'); mod = await factory({}); mod.init(); }
+  catch (e) { port.postMessage({ error: String(e) }); return; }
+  const host = new SimHost(sab, mod);
+  port.postMessage({ ready: true, maxBullets: mod.getMaxBullets() });
+
+  let next = performance.now();
+  const tick = () => {
+    const now = performance.now();
+    let steps = 0, stepMs = 0;
+    while (now >= next && steps < MAX_CATCHUP) {
+      host.drainCommands();
+      const t0 = performance.now(); mod.step(DT); stepMs = performance.now() - t0;
+      next += DT; steps++;
+    }
+    if (steps) host.publish(stepMs); // un snapshot por tick: los pasos de recuperación no se copian
+    if (now - next > DT * MAX_CATCHUP) next = now; // muy atrasado: soltamos el tiempo perdido en vez de espiralar
+    setTimeout(tick, Math.max(0, next - performance.now()));
+  };
+  tick();
+});
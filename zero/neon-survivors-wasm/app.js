@@ -7,7 +7,7 @@ class GL{ constructor(c){ this.c=c; this.g=c.getContext('webgl'); const g=this.g
 class Game{ constructor(){ this.cv=document.getElementById('canvas'); this.gl=new GL(this.cv); this.fps=0; this.last=performance.now(); this.keys={}; this.loop=this.loop.bind(this); this.init(); }
  async init(){ this.mod=await this.loadWASM(); this.mod.reset(); this.gl.resize(); addEventListener('resize',()=>this.gl.resize()); this.bindInput(); requestAnimationFrame(this.loop); }
  loadWASM(){ return new Promise((resolve,reject)=>{ const s=document.createElement('script'); s.src='physics.js'; s.onload=async()=>{ try{ if(typeof Module==='function'){ const m=await Module({}); resolve(m);} else if(typeof Module==='object'){ Module.onRuntimeInitialized=()=>resolve(Module);} else reject(new Error('Module not found')); } catch(e){reject(e);} }; s.onerror=reject; document.body.appendChild(s); }); }
- bindInput(){ addEventListener('keydown',(e)=>{ this.keys[e.code]=true; if(e.code==='KeyR'){ this.mod.reset(); } if(e.code==='KeyT'){ this.mod.stress(); } }); addEventListener('keyup',(e)=>{ this.keys[e.code]=false; }); }
+ bindInput(){ addEventListener('keydown',(e)=>{ this.keys[e.code]=true; if(e.code==='KeyR'){ this.mod.reset(); } if(e.code==='KeyT'){ this.mod.stress(); } if(e.code==='KeyG'){ this.mod.setGridMode(this.mod.getGridMode()?0:1); } }); addEventListener('keyup',(e)=>{ this.keys[e.code]=false; }); }
  loop(){ const now=performance.now(); const dt=(now-this.last)/1000; this.last=now;
   // input: WASD movimiento; J dispara; K dash
   const ax = (this.keys['KeyA']?-1:0) + (this.keys['KeyD']?1:0);
@@ -17,14 +17,16 @@ class Game{ constructor(){ this.cv=document.getElementById('canvas'); this.gl=ne
   this.mod.input(ax,ay,fire,dash);
   const t0=performance.now(); this.mod.step(dt); const stepMs=performance.now()-t0;
   const all=this.mod.getAll(); const en=this.mod.getCountByType(1); const bu=this.mod.getCountByType(2); const sc=this.mod.getScore();
-  const lv=this.mod.getLevel(); const kl=this.mod.getKeysLeft(); const kt=this.mod.getKeysTotal(); const hp=this.mod.getPlayerHP();
+  const lv=this.mod.getLevel(); const kl=this.mod.getKeysLeft(); const kt=this.mod.getKeysTotal(); const hp=this.mod.getPlayerHP(); const ne=this.mod.getEntityCount(); const gm=this.mod.getGridMode();
   // build draw buffers
-  const n=all.length/4; const pts=new Float32Array(n*2); const sizes=new Float32Array(n); const cols=new Float32Array(n*3);
+  const fx=this.mod.getFx(); const n=all.length/4, nf=fx.length/4; const pts=new Float32Array((n+nf)*2); const sizes=new Float32Array(n+nf); const cols=new Float32Array((n+nf)*3);
   for(let i=0;i<n;i++){ const x=all[i*4], y=all[i*4+1], r=all[i*4+2], t=all[i*4+3]|0; pts[i*2]=x; pts[i*2+1]=y; let scale= (t===0? 1800.0 : t===6? 800.0 : 600.0); let minSize=(t===0? 20.0 : 6.0); sizes[i]=Math.max(minSize,r*scale); if(t===0){ cols[i*3]=1.0; cols[i*3+1]=0.9; cols[i*3+2]=0.4; } else if(t===1){ cols[i*3]=0.9; cols[i*3+1]=0.95; cols[i*3+2]=1.0; } else if(t===2){ cols[i*3]=1.0; cols[i*3+1]=0.6; cols[i*3+2]=0.4; } else if(t===4){ cols[i*3]=0.6; cols[i*3+1]=1.0; cols[i*3+2]=0.6; } else if(t===5){ cols[i*3]=0.8; cols[i*3+1]=0.6; cols[i*3+2]=1.0; } else { cols[i*3]=0.6; cols[i*3+1]=0.7; cols[i*3+2]=0.9; } }
+  // partículas cosméticas del emisor: x,y,alpha,type (3=partícula r 0.01, 6=beam r 0.02), color atenuado por alpha
+  for(let k=0;k<nf;k++){ const i=n+k; const a=fx[k*4+2], t=fx[k*4+3]|0; pts[i*2]=fx[k*4]; pts[i*2+1]=fx[k*4+1]; sizes[i]=(t===6? Math.max(6.0,0.02*800.0) : 6.0); cols[i*3]=0.6*a; cols[i*3+1]=0.7*a; cols[i*3+2]=0.9*a; }
   this.gl.draw(pts,sizes,cols);
-  this.updateHUD(stepMs,en,bu,sc,lv,kl,kt,hp);
+  this.updateHUD(stepMs,en,bu,sc,lv,kl,kt,hp,ne,gm);
   requestAnimationFrame(this.loop); }
- updateHUD(stepMs,en,bu,sc,lv,kl,kt,hp){ const fpsEl=document.getElementById('fps'); const stepEl=document.getElementById('step'); const enEl=document.getElementById('en'); const buEl=document.getElementById('bu'); const scEl=document.getElementById('sc'); const lvEl=document.getElementById('lv'); const klEl=document.getElementById('kl'); const ktEl=document.getElementById('kt'); const hpEl=document.getElementById('hp'); this._frames=(this._frames||0)+1; if(this._frames%30===0){ const now=performance.now(); const d=now-(this._lastFps||now); this._fps=Math.round(30000/d); this._lastFps=now; fpsEl.textContent=this._fps; } stepEl.textContent=stepMs.toFixed(2); enEl.textContent=en; buEl.textContent=bu; scEl.textContent=sc; lvEl.textContent=lv; klEl.textContent=kl; ktEl.textContent=kt; hpEl.textContent=hp; }
+ updateHUD(stepMs,en,bu,sc,lv,kl,kt,hp,ne,gm){ const fpsEl=document.getElementById('fps'); const stepEl=document.getElementById('step'); const enEl=document.getElementById('en'); const buEl=document.getElementById('bu'); const scEl=document.getElementById('sc'); const lvEl=document.getElementById('lv'); const klEl=document.getElementById('kl'); const ktEl=document.getElementById('kt'); const hpEl=document.getElementById('hp'); const neEl=document.getElementById('ne'); const gmEl=document.getElementById('gm'); this._frames=(this._frames||0)+1; if(this._frames%30===0){ const now=performance.now(); const d=now-(this._lastFps||now); this._fps=Math.round(30000/d); this._lastFps=now; fpsEl.textContent=this._fps; } stepEl.textContent=stepMs.toFixed(2); enEl.textContent=en; buEl.textContent=bu; scEl.textContent=sc; lvEl.textContent=lv; klEl.textContent=kl; ktEl.textContent=kt; hpEl.textContent=hp; neEl.textContent=ne; gmEl.textContent=(gm?'plana':'legacy'); }
 }
 
 document.addEventListener('DOMContentLoaded',()=>new Game());
@@ -8,106 +8,248 @@ using namespace emscripten;
 static inline float rnd(){ return (float)rand()/(float)RAND_MAX; }
 
 // type: 0=player,1=enemy,2=bullet,3=particle,4=key,5=gate,6=beamVisual
-struct Ent { float x,y,vx,vy,r; uint8_t type; uint8_t hp; };
-static std::vector<Ent> ents; static int playerIdx=-1; static int score=0;
+// Cada tipo vive en su propio pool SoA (x,y,vx,vy,hp) con radio constante por tipo, así cada loop de step()
+// recorre un solo tipo sin ramas por e.type y los conteos son O(1). El player vive fuera de los pools:
+// su handle es fijo y no se mueve al compactar o reordenar. Partículas (3) y visuales del beam (6) son cosméticos:
+// no tienen pool, viven como registros del emisor analítico (ver más abajo) y no entran al step ni a la grilla.
+enum Kind : uint8_t { PLAYER=0, ENEMY=1, BULLET=2, PARTICLE=3, KEY=4, GATE=5, BEAMVIS=6, NKINDS=7 };
+static const float KIND_R[NKINDS]={ 0.035f, 0.02f, 0.012f, 0.01f, 0.025f, 0.04f, 0.02f };
 
 // Spatial hash grid
-static const int GW=128, GH=128; static std::vector<int> grid[GW*GH];
+// gridMode 1 (default): grilla plana por counting sort (conteo por celda, prefix sum, scatter) y el pool reordenado
+// en orden de celda, así cada celda es el rango contiguo [cellStart[c], cellStart[c+1]) del pool.
+// gridMode 0: grilla legacy de un std::vector por celda, se deja para comparar step times (setGridMode).
+// Solo los enemigos van a la grilla (los consultan balas, beam y player).
+static const int GW=128, GH=128; static int gridMode=1;
 static inline int cell(float v){ int c=(int)floorf(v*(float)GW); if(c<0) c=0; if(c>=GW) c=GW-1; return c; }
 static inline int idxCell(int cx,int cy){ if(cx<0) cx=0; if(cx>=GW) cx=GW-1; if(cy<0) cy=0; if(cy>=GH) cy=GH-1; return cy*GW+cx; }
-static inline void clearGrid(){ for(int i=0;i<GW*GH;i++) grid[i].clear(); }
-static inline void addToGrid(int i){ int cx=cell(ents[i].x), cy=cell(ents[i].y); grid[idxCell(cx,cy)].push_back(i); }
+
+struct Pool {
+  uint8_t type=0; float r=0; bool gridded=false;
+  std::vector<float> x,y,vx,vy; std::vector<uint8_t> hp;
+  std::vector<int> cellStart, cellOf; std::vector<std::vector<int>> legacy;
+  std::vector<float> tx,ty,tvx,tvy; std::vector<uint8_t> thp; // scratch del scatter
+  int size() const { return (int)x.size(); }
+  void clear(){ x.clear(); y.clear(); vx.clear(); vy.clear(); hp.clear(); clearGrid(); }
+  void push(float px,float py,float pvx,float pvy){ x.push_back(px); y.push_back(py); vx.push_back(pvx); vy.push_back(pvy); hp.push_back(1); }
+  void clearGrid(){ if(!gridded) return; for(auto &v: legacy) v.clear(); std::fill(cellStart.begin(), cellStart.end(), 0); }
+  void buildLegacyGrid(){ for(auto &v: legacy) v.clear(); for(int i=0;i<size();i++) legacy[idxCell(cell(x[i]),cell(y[i]))].push_back(i); }
+  void buildFlatGrid(){ // count -> prefix sum -> scatter (reordena el pool por celda)
+    const int n=size(); cellOf.resize(n); tx.resize(n); ty.resize(n); tvx.resize(n); tvy.resize(n); thp.resize(n);
+    std::fill(cellStart.begin(), cellStart.end(), 0);
+    for(int i=0;i<n;i++){ int c=idxCell(cell(x[i]), cell(y[i])); cellOf[i]=c; cellStart[c+1]++; }
+    for(int c=0;c<GW*GH;c++) cellStart[c+1]+=cellStart[c];
+    // scatter estable: cellStart[c] hace de cursor y al final se corre una posición para restaurarlo
+    for(int i=0;i<n;i++){ int d=cellStart[cellOf[i]]++; tx[d]=x[i]; ty[d]=y[i]; tvx[d]=vx[i]; tvy[d]=vy[i]; thp[d]=hp[i]; }
+    for(int c=GW*GH;c>0;c--) cellStart[c]=cellStart[c-1];
+    cellStart[0]=0; x.swap(tx); y.swap(ty); vx.swap(tvx); vy.swap(tvy); hp.swap(thp);
+  }
+};
+static Pool pools[NKINDS];
+static Pool &enemies=pools[ENEMY], &bullets=pools[BULLET], &keys=pools[KEY], &gates=pools[GATE];
+
+struct Player { float x=0.5f,y=0.5f,vx=0,vy=0; uint8_t hp=3; };
+static Player player; static bool hasPlayer=false; static int score=0;
+
+static void initPools(){ static bool done=false; if(done) return; done=true;
+  for(int k=1;k<NKINDS;k++){ pools[k].type=(uint8_t)k; pools[k].r=KIND_R[k]; }
+  enemies.gridded=true; enemies.cellStart.assign(GW*GH+1, 0); enemies.legacy.resize(GW*GH);
+}
+static inline void clearGrids(){ for(int k=1;k<NKINDS;k++) pools[k].clearGrid(); }
+static inline int totalCount(){ int n=hasPlayer?1:0; for(int k=1;k<NKINDS;k++) n+=pools[k].size(); return n; }
+
+// visita los índices del pool P en la celda c con la grilla activa
+template<class F> static inline void forCell(Pool &P,int c,F fn){
+  if(gridMode){ for(int j=P.cellStart[c], e=P.cellStart[c+1]; j<e; j++) fn(j); }
+  else { for(int j: P.legacy[c]) fn(j); } }
+// visita los índices del pool P en las 3x3 celdas alrededor de (x,y)
+template<class F> static inline void forNeighbors(Pool &P,float x,float y,F fn){ int cx=cell(x), cy=cell(y);
+  for(int oy=-1;oy<=1;oy++) for(int ox=-1;ox<=1;ox++) forCell(P, idxCell(cx+ox,cy+oy), fn); }
+
+// Consultas de área para armas (beam y futuras): recorren solo las celdas que cubre la forma, con wrap toroidal.
+// La forma es una caja orientada que arranca en (ox,oy) con eje (nx,ny) normalizado: t en [t0,t1] a lo largo
+// del eje y |perp|<=hw. Se rasteriza fila por fila (rango x del polígono dentro de cada franja de celdas) y
+// cada celda se visita una sola vez por consulta (stamp), aunque la forma se solape consigo misma por el wrap.
+static std::vector<uint32_t> cellStamp(GW*GH, 0); static uint32_t queryStamp=0;
+static inline int wrapCell(int c,int n){ c%=n; return c<0? c+n : c; }
+template<class F> static void forCellsInBox(Pool &P,float ox,float oy,float nx,float ny,float t0,float t1,float hw,F fn){
+  if(++queryStamp==0){ std::fill(cellStamp.begin(), cellStamp.end(), 0u); queryStamp=1; }
+  const float px[4]={ ox+nx*t0-ny*hw, ox+nx*t1-ny*hw, ox+nx*t1+ny*hw, ox+nx*t0+ny*hw };
+  const float py[4]={ oy+ny*t0+nx*hw, oy+ny*t1+nx*hw, oy+ny*t1-nx*hw, oy+ny*t0-nx*hw };
+  float ymin=std::min(std::min(py[0],py[1]),std::min(py[2],py[3])), ymax=std::max(std::max(py[0],py[1]),std::max(py[2],py[3]));
+  int cy0=(int)floorf(ymin*(float)GH), cy1=(int)floorf(ymax*(float)GH); // sin recortar a GH: la misma fila envuelta tiene otro rango x
+  for(int cy=cy0; cy<=cy1; cy++){ float ya=(float)cy/(float)GH, yb=(float)(cy+1)/(float)GH; float x0=1e9f, x1=-1e9f;
+    for(int k=0;k<4;k++){ int l=(k+1)&3; float ax=px[k], ay=py[k], bx=px[l], by=py[l];
+      if(ay>=ya && ay<=yb){ x0=std::min(x0,ax); x1=std::max(x1,ax); }
+      for(float yy: {ya,yb}) if((ay-yy)*(by-yy)<0){ float x=ax+(bx-ax)*(yy-ay)/(by-ay); x0=std::min(x0,x); x1=std::max(x1,x); } }
+    if(x0>x1) continue;
+    int cx0=(int)floorf(x0*(float)GW), cx1=(int)floorf(x1*(float)GW); if(cx1-cx0>=GW) cx1=cx0+GW-1;
+    int wy=wrapCell(cy,GH);
+    for(int cx=cx0; cx<=cx1; cx++){ int c=wy*GW+wrapCell(cx,GW); if(cellStamp[c]==queryStamp) continue; cellStamp[c]=queryStamp; forCell(P, c, fn); } }
+}
+// recorre los candidatos de un pool: por grilla si la tiene, si no lineal (llaves, puertas, balas: pocos)
+template<class F> static inline void forCandidates(Pool &P,float ox,float oy,float nx,float ny,float t0,float t1,float hw,F fn){
+  if(P.gridded){ const float m=P.r+0.5f/(float)GW; forCellsInBox(P,ox,oy,nx,ny,t0-m,t1+m,hw+m,fn); }
+  else { for(int j=0;j<P.size();j++) fn(j); } }
+// vector más corto en el torus desde (ox,oy) hasta (x,y)
+static inline void wrapDelta(float x,float y,float ox,float oy,float &rx,float &ry){ rx=x-ox; ry=y-oy; if(rx>0.5f) rx-=1.0f; if(rx<-0.5f) rx+=1.0f; if(ry>0.5f) ry-=1.0f; if(ry<-0.5f) ry+=1.0f; }
+// entidades (pools filtrados por typeMask, bit = type) cuyo círculo toca la franja [0,len] x [-hw,hw] del eje (nx,ny); fn(pool, índice)
+template<class F> static void queryOrientedBox(float ox,float oy,float nx,float ny,float len,float hw,uint32_t typeMask,F fn){
+  for(int k=1;k<NKINDS;k++){ if(!(typeMask & (1u<<k))) continue; Pool &P=pools[k]; const float rr=hw+P.r;
+    forCandidates(P,ox,oy,nx,ny,0.0f,len,hw,[&](int j){ float rx,ry; wrapDelta(P.x[j],P.y[j],ox,oy,rx,ry);
+      float t=rx*nx+ry*ny; if(t<0 || t>len) return; float cx=rx-nx*t, cy=ry-ny*t; if(cx*cx+cy*cy<rr*rr) fn(P,j); }); }
+}
+// entidades cuyo círculo toca la cápsula de radio rad alrededor del segmento (ox,oy)->(ox,oy)+(nx,ny)*len
+template<class F> static void queryCapsule(float ox,float oy,float nx,float ny,float len,float rad,uint32_t typeMask,F fn){
+  for(int k=1;k<NKINDS;k++){ if(!(typeMask & (1u<<k))) continue; Pool &P=pools[k]; const float rr=rad+P.r;
+    forCandidates(P,ox,oy,nx,ny,-rad,len+rad,rad,[&](int j){ float rx,ry; wrapDelta(P.x[j],P.y[j],ox,oy,rx,ry);
+      float t=std::max(0.0f, std::min(len, rx*nx+ry*ny)); float cx=rx-nx*t, cy=ry-ny*t; if(cx*cx+cy*cy<rr*rr) fn(P,j); }); }
+}
+
+// Emisor analítico de partículas cosméticas: cada emisión es un único registro (origen, forma, seed, t0, count)
+// en un ring buffer. Posición y alpha de la partícula i se calculan en forma cerrada desde la edad al llenar el
+// buffer de render: vel inicial y vida salen de un hash (seed,i), la velocidad decae exponencialmente
+// (x = x0 + v0*(1-e^{-k*age})/k, el 0.98 por frame de antes) y la vida es exponencial con la misma tasa
+// que tenía el descarte al azar por frame (2%/frame partículas, 20%/frame beam), truncada a FX_MAX_LIFE.
+enum FxShape : uint8_t { FX_POINT=0, FX_LINE=1, FX_AREA=2 };
+struct FxRec { float x,y,ax,ay,len,width,t0; uint32_t seed; uint32_t count; uint8_t shape, type; };
+static const int FX_CAP=8192; static FxRec fxRing[FX_CAP]; static int fxHead=0, fxSize=0; static float fxTime=0.0f; static uint32_t fxSeed=1;
+static std::vector<float> fxBuf; static int fxLive[NKINDS]={0};
+static const float FX_DECAY_K=-60.0f*std::log(0.98f); // 1/s
+static const float FX_MAX_LIFE[NKINDS]={ 0, 0, 0, 4.0f, 0, 0, 0.5f };
+static const float FX_RATE[NKINDS]={ 0, 0, 0, 0.02f*60.0f, 0, 0, 0.2f*60.0f }; // 1/s
+static inline uint32_t fxHash(uint32_t a){ a^=a>>16; a*=0x7feb352dU; a^=a>>15; a*=0x846ca68bU; a^=a>>16; return a; }
+static inline float fxU(uint32_t &h){ h=fxHash(h+0x9e3779b9U); return (float)(h>>8)*(1.0f/16777216.0f); } // [0,1)
+static inline void emitFx(uint8_t shape,uint8_t type,float x,float y,float ax,float ay,float len,float width,uint32_t count){
+  FxRec &r=fxRing[fxHead]; r={ x,y,ax,ay,len,width,fxTime,fxHash(fxSeed++),count,shape,type }; // si está lleno pisa el más viejo
+  fxHead=(fxHead+1)%FX_CAP; if(fxSize<FX_CAP) fxSize++; }
+static inline void expireFx(){ // los registros se emiten en orden de t0: se sueltan desde el más viejo
+  while(fxSize>0){ const FxRec &r=fxRing[(fxHead-fxSize+FX_CAP)%FX_CAP]; if(fxTime-r.t0 <= FX_MAX_LIFE[r.type]) break; fxSize--; } }
+static void fillFx(){ // x,y,alpha,type por partícula viva
+  size_t cap=0; for(int k=0;k<fxSize;k++) cap+=fxRing[(fxHead-fxSize+k+FX_CAP)%FX_CAP].count; fxBuf.resize(cap*4);
+  size_t o=0; fxLive[PARTICLE]=0; fxLive[BEAMVIS]=0;
+  for(int k=0;k<fxSize;k++){ const FxRec &r=fxRing[(fxHead-fxSize+k+FX_CAP)%FX_CAP]; const float age=fxTime-r.t0; const float maxLife=FX_MAX_LIFE[r.type], rate=FX_RATE[r.type];
+    if(age>maxLife) continue;
+    const float drift=(1.0f-std::exp(-FX_DECAY_K*age))/FX_DECAY_K;
+    for(uint32_t i=0;i<r.count;i++){ uint32_t h=r.seed^(i*0x9e3779b1U); float life=std::min(maxLife, -std::log(1.0f-fxU(h))/rate); if(age>=life) continue;
+      float x,y,vx=0,vy=0;
+      if(r.shape==FX_LINE){ float s=((float)i/(float)r.count)*r.len; float ox=(fxU(h)-0.5f)*r.width; x=r.x + r.ax*s - r.ay*ox; y=r.y + r.ay*s + r.ax*ox; }
+      else { if(r.shape==FX_AREA){ x=fxU(h); y=fxU(h); } else { x=r.x; y=r.y; } vx=(fxU(h)-0.5f)*0.3f; vy=(fxU(h)-0.5f)*0.3f; }
+      x+=vx*drift; y+=vy*drift; x-=std::floor(x); y-=std::floor(y);
+      fxBuf[o]=x; fxBuf[o+1]=y; fxBuf[o+2]=1.0f-age/life; fxBuf[o+3]=(float)r.type; o+=4; fxLive[r.type]++; } }
+  fxBuf.resize(o);
+}
 
 static int levelNum=1; static int keysTotal=0; static int keysLeft=0; static bool gateActive=false;
 // Beam state
 static int beamCooldown=0; static int beamTicks=0; static float beamNx=0.0f, beamNy=-1.0f; static float beamWidth=0.18f; static float beamLen=1.2f;
 
-static inline void spawnKey(){ Ent k; k.x=rnd(); k.y=rnd(); k.vx=0; k.vy=0; k.r=0.025f; k.type=4; k.hp=1; ents.push_back(k); }
+static inline void spawnKey(){ keys.push(rnd(), rnd(), 0, 0); }
 
 static void buildLevel(){ // limpia todo menos player
-  std::vector<Ent> keep; keep.reserve(1);
-  if(playerIdx>=0 && playerIdx<(int)ents.size()){ keep.push_back(ents[playerIdx]); }
-  ents.swap(keep); playerIdx=0; clearGrid(); gateActive=false;
+  initPools(); for(int k=1;k<NKINDS;k++) pools[k].clear(); fxSize=0; gateActive=false;
   // enemigos segun nivel
   int baseEnemies = 150 + levelNum*80;
-  for(int i=0;i<baseEnemies;i++){ Ent e; e.x=rnd(); e.y=rnd(); float ang=rnd()*6.2831853f; float sp=0.05f+0.23f*rnd(); e.vx=cosf(ang)*sp; e.vy=sinf(ang)*sp; e.r=0.02f; e.type=1; e.hp=1; ents.push_back(e);} 
+  for(int i=0;i<baseEnemies;i++){ float x=rnd(), y=rnd(); float ang=rnd()*6.2831853f; float sp=0.05f+0.23f*rnd(); enemies.push(x, y, cosf(ang)*sp, sinf(ang)*sp); }
   // llaves
   keysTotal = std::min(6, 2 + levelNum);
   keysLeft = keysTotal;
   for(int i=0;i<keysTotal;i++) spawnKey();
 }
 
-void reset(){ ents.clear(); score=0; playerIdx=-1; clearGrid(); levelNum=1; gateActive=false;
+void reset(){ initPools(); score=0; levelNum=1; gateActive=false;
   // player
-  Ent p; p.x=0.5f; p.y=0.5f; p.vx=0; p.vy=0; p.r=0.035f; p.type=0; p.hp=3; ents.push_back(p); playerIdx=0;
+  player=Player(); hasPlayer=true;
   buildLevel(); }
 
-static inline void spawnEnemy(){ Ent e; e.x=rnd(); e.y=rnd(); float ang=rnd()*6.2831853f; float sp=0.05f+0.25f*rnd(); e.vx=cosf(ang)*sp; e.vy=sinf(ang)*sp; e.r=0.02f; e.type=1; e.hp=1; ents.push_back(e); }
-static inline void spawnBullet(float x,float y,float vx,float vy){ Ent b{ x,y,vx,vy,0.012f,2,1 }; ents.push_back(b); }
-static inline void spawnParticle(float x,float y){ Ent q{ x,y,(rnd()-0.5f)*0.3f,(rnd()-0.5f)*0.3f,0.01f,3,1 }; ents.push_back(q); }
-static inline void spawnGate(){ Ent g; g.x=rnd(); g.y=rnd(); g.vx=0; g.vy=0; g.r=0.04f; g.type=5; g.hp=1; ents.push_back(g); gateActive=true; }
+static inline void spawnEnemy(){ float x=rnd(), y=rnd(); float ang=rnd()*6.2831853f; float sp=0.05f+0.25f*rnd(); enemies.push(x, y, cosf(ang)*sp, sinf(ang)*sp); }
+static inline void spawnBullet(float x,float y,float vx,float vy){ bullets.push(x, y, vx, vy); }
+static inline void spawnParticle(float x,float y){ emitFx(FX_POINT, PARTICLE, x, y, 0, 0, 0, 0, 1); }
+static inline void spawnGate(){ gates.push(rnd(), rnd(), 0, 0); gateActive=true; }
 
 void stress(){ // mete muchos enemigos y balas cosméticas
+  initPools();
   for(int i=0;i<5000;i++) spawnEnemy();
-  for(int i=0;i<50000;i++) spawnParticle(rnd(), rnd());
+  emitFx(FX_AREA, PARTICLE, 0, 0, 0, 0, 0, 0, 50000);
 }
 
-void input(float ax,float ay,bool fire,bool dash){ if(playerIdx<0) return; Ent &p=ents[playerIdx]; float acc=0.9f; p.vx += ax*acc*(1.0f/60.0f); p.vy += ay*acc*(1.0f/60.0f); float dmp=0.96f; p.vx*=dmp; p.vy*=dmp;
+void input(float ax,float ay,bool fire,bool dash){ if(!hasPlayer) return; Player &p=player; float acc=0.9f; p.vx += ax*acc*(1.0f/60.0f); p.vy += ay*acc*(1.0f/60.0f); float dmp=0.96f; p.vx*=dmp; p.vy*=dmp;
   // Massive beam instead of bullets
   if(beamCooldown>0) beamCooldown--;
   if(fire && beamCooldown<=0){ float nx = (ax!=0||ay!=0)? ax: 0.0f; float ny = (ax!=0||ay!=0)? ay: -1.0f; float L = std::sqrt(nx*nx+ny*ny); if(L<1e-6f){ nx=0.0f; ny=-1.0f; } else { nx/=L; ny/=L; }
     beamNx=nx; beamNy=ny; beamTicks=3; beamCooldown=10; // ~150ms
     // spawn visual cloud (type 6)
-    int samples=800; for(int i=0;i<samples;i++){ float t=(float)i/(float)samples; float s=t*beamLen; float ox=(rnd()-0.5f)*beamWidth; float oy=(rnd()-0.5f)*beamWidth; Ent v; v.x=p.x + beamNx*s + (-beamNy)*ox; v.y=p.y + beamNy*s + ( beamNx)*ox; v.vx=0; v.vy=0; v.r=0.02f; v.type=6; v.hp=1; ents.push_back(v); }
+    emitFx(FX_LINE, BEAMVIS, p.x, p.y, beamNx, beamNy, beamLen, beamWidth, 800);
   }
   if(dash){ p.vx*=1.8f; p.vy*=1.8f; }
 }
 
-void step(float dt){ clearGrid(); for(size_t i=0;i<ents.size();++i){ Ent &e=ents[i];
-    // enemigos orientados levemente al jugador
-    if(e.type==1 && playerIdx>=0){ Ent &p=ents[playerIdx]; float dx=p.x-e.x, dy=p.y-e.y; float L=std::sqrt(dx*dx+dy*dy)+1e-6f; float accel=0.2f; e.vx += (dx/L)*accel*dt; e.vy += (dy/L)*accel*dt; float sp=0.35f; float s=std::sqrt(e.vx*e.vx+e.vy*e.vy); if(s>sp){ e.vx*=sp/s; e.vy*=sp/s; } }
-    e.x+=e.vx*dt; e.y+=e.vy*dt; if(e.x<0) e.x+=1; if(e.x>1) e.x-=1; if(e.y<0) e.y+=1; if(e.y>1) e.y-=1; addToGrid(i); }
+// Kernels de step especializados por tipo en compilación: enemigos hacen steering, el resto solo integra. Sin ramas por tipo dentro del loop (el wrap y el clamp de velocidad son selects), vectorizables.
+template<Kind K> static void stepKernel(Pool &P,float dt){
+  const int n=P.size(); float *__restrict x=P.x.data(), *__restrict y=P.y.data(), *__restrict vx=P.vx.data(), *__restrict vy=P.vy.data();
+  const float px=player.x, py=player.y; const bool steer=hasPlayer;
+  for(int i=0;i<n;i++){ float ex=x[i], ey=y[i], evx=vx[i], evy=vy[i];
+    if constexpr(K==ENEMY){ // enemigos orientados levemente al jugador
+      if(steer){ float dx=px-ex, dy=py-ey; float L=std::sqrt(dx*dx+dy*dy)+1e-6f; float accel=0.2f; evx += (dx/L)*accel*dt; evy += (dy/L)*accel*dt; float sp=0.35f; float s=std::sqrt(evx*evx+evy*evy); float k=(s>sp)? sp/s : 1.0f; evx*=k; evy*=k; } }
+    ex+=evx*dt; ey+=evy*dt; ex+=(ex<0)?1.0f:0.0f; ex-=(ex>1)?1.0f:0.0f; ey+=(ey<0)?1.0f:0.0f; ey-=(ey>1)?1.0f:0.0f;
+    x[i]=ex; y[i]=ey; vx[i]=evx; vy[i]=evy; }
+}
+// limpiar muertos en una pasada por pool
+static void compact(Pool &P){ const int n=P.size(); int w=0;
+  for(int i=0;i<n;i++){
+    if(!P.hp[i]) continue;
+    P.x[w]=P.x[i]; P.y[w]=P.y[i]; P.vx[w]=P.vx[i]; P.vy[w]=P.vy[i]; P.hp[w]=P.hp[i]; w++; }
+  P.x.resize(w); P.y.resize(w); P.vx.resize(w); P.vy.resize(w); P.hp.resize(w);
+}
+
+void step(float dt){ initPools(); fxTime+=dt; expireFx();
+  if(hasPlayer){ Player &p=player; p.x+=p.vx*dt; p.y+=p.vy*dt; if(p.x<0) p.x+=1; if(p.x>1) p.x-=1; if(p.y<0) p.y+=1; if(p.y>1) p.y-=1; }
+  // llaves, puertas y visuales del beam no se mueven: no tienen kernel
+  stepKernel<ENEMY>(enemies,dt); stepKernel<BULLET>(bullets,dt);
+  if(gridMode) enemies.buildFlatGrid(); else enemies.buildLegacyGrid();
   // colisiones balas-enemigos
-  for(size_t i=0;i<ents.size();++i){ if(ents[i].type!=2) continue; Ent &b=ents[i]; int cx=cell(b.x), cy=cell(b.y); for(int oy=-1;oy<=1;oy++) for(int ox=-1;ox<=1;ox++){ auto &v=grid[idxCell(cx+ox,cy+oy)]; for(int j: v){ if(ents[j].type!=1) continue; float dx=ents[j].x-b.x, dy=ents[j].y-b.y; if(dx*dx+dy*dy < (ents[j].r+b.r)*(ents[j].r+b.r)){ ents[j].hp=0; b.hp=0; score+=1; spawnParticle(ents[j].x,ents[j].y); } } }
+  for(int i=0;i<bullets.size();++i){ float bxp=bullets.x[i], byp=bullets.y[i]; const float rr=(enemies.r+bullets.r)*(enemies.r+bullets.r);
+    forNeighbors(enemies,bxp,byp,[&](int j){ float dx=enemies.x[j]-bxp, dy=enemies.y[j]-byp; if(dx*dx+dy*dy < rr){ enemies.hp[j]=0; bullets.hp[i]=0; score+=1; spawnParticle(enemies.x[j],enemies.y[j]); } });
   }
-  // Beam kill: wide stripe ahead of player
-  if(beamTicks>0 && playerIdx>=0){ Ent &p=ents[playerIdx]; float nx=beamNx, ny=beamNy; float half=beamWidth*0.5f; for(size_t j=0;j<ents.size();++j){ if(ents[j].type!=1 && ents[j].type!=3) continue; Ent &e=ents[j]; float rx=e.x-p.x, ry=e.y-p.y; // wrap shortest vector
-      if(rx>0.5f) rx-=1.0f; if(rx<-0.5f) rx+=1.0f; if(ry>0.5f) ry-=1.0f; if(ry<-0.5f) ry+=1.0f; float tproj = rx*nx + ry*ny; if(tproj<0 || tproj>beamLen) continue; float cx = rx - nx*tproj; float cy = ry - ny*tproj; float dist2 = cx*cx + cy*cy; if(dist2 < (half+e.r)*(half+e.r)){ e.hp=0; if(ents[j].type==1){ score+=1; spawnParticle(e.x,e.y); } } }
+  // Beam kill: wide stripe ahead of player (solo las celdas que cubre el beam)
+  if(beamTicks>0 && hasPlayer){ const float px=player.x, py=player.y;
+    queryOrientedBox(px,py,beamNx,beamNy,beamLen,beamWidth*0.5f,(1u<<ENEMY),[&](Pool &P,int j){ P.hp[j]=0; score+=1; spawnParticle(P.x[j],P.y[j]); });
     beamTicks--; }
   // player con llaves/puerta y daño con enemigos
-  if(playerIdx>=0){ Ent &p=ents[playerIdx];
-    int cx=cell(p.x), cy=cell(p.y);
-    for(int oy=-1;oy<=1;oy++) for(int ox=-1;ox<=1;ox++){
-      auto &v=grid[idxCell(cx+ox,cy+oy)];
-      for(int j: v){ if(j==playerIdx) continue; Ent &e=ents[j]; float dx=e.x-p.x, dy=e.y-p.y; float rr=(e.r+p.r)*(e.r+p.r); if(dx*dx+dy*dy>rr) continue;
-        if(e.type==1){ // enemigo daña
-          if(p.hp>0){ p.hp--; p.vx -= dx*2.0f; p.vy -= dy*2.0f; }
-        } else if(e.type==4){ // key
-          if(e.hp){ e.hp=0; keysLeft = std::max(0, keysLeft-1); score+=5; spawnParticle(e.x,e.y); }
-        } else if(e.type==5){ // gate
-          if(gateActive){ levelNum++; if(p.hp<5) p.hp++; buildLevel(); return; }
-        }
-      }
-    }
+  if(hasPlayer){ Player &p=player;
+    { const float rr=(enemies.r+KIND_R[PLAYER])*(enemies.r+KIND_R[PLAYER]);
+      forNeighbors(enemies,p.x,p.y,[&](int j){ float dx=enemies.x[j]-p.x, dy=enemies.y[j]-p.y; if(dx*dx+dy*dy>rr) return;
+        if(p.hp>0){ p.hp--; p.vx -= dx*2.0f; p.vy -= dy*2.0f; } }); } // enemigo daña
+    { const float rr=(keys.r+KIND_R[PLAYER])*(keys.r+KIND_R[PLAYER]);
+      for(int j=0;j<keys.size();j++){ float dx=keys.x[j]-p.x, dy=keys.y[j]-p.y; if(dx*dx+dy*dy>rr) continue;
+        if(keys.hp[j]){ keys.hp[j]=0; keysLeft = std::max(0, keysLeft-1); score+=5; spawnParticle(keys.x[j],keys.y[j]); } } }
+    { const float rr=(gates.r+KIND_R[PLAYER])*(gates.r+KIND_R[PLAYER]);
+      for(int j=0;j<gates.size();j++){ float dx=gates.x[j]-p.x, dy=gates.y[j]-p.y; if(dx*dx+dy*dy>rr) continue;
+        if(gateActive){ levelNum++; if(p.hp<5) p.hp++; buildLevel(); return; } } }
   }
-  // limpiar muertos y limitar partículas
-  size_t w=0; for(size_t i=0;i<ents.size();++i){ if(ents[i].type==3 || ents[i].type==6){ // decay fast for visuals
-      ents[i].vx*=0.98f; ents[i].vy*=0.98f; if(rnd()< (ents[i].type==6? 0.2f:0.02f)) continue; }
-    if(ents[i].hp>0 || (int)i==playerIdx){ ents[w++]=ents[i]; }
-  } ents.resize(w);
+  // limpiar muertos
+  compact(enemies); compact(bullets); compact(keys); compact(gates);
   // si no hay llaves y no hay puerta, crearla
   if(keysLeft==0 && !gateActive) spawnGate();
   // spawner suave
-  if((int)ents.size()<8000){ if(rnd()<0.5f) spawnEnemy(); }
+  if(totalCount()<8000){ if(rnd()<0.5f) spawnEnemy(); }
 }
 
 // getters para render/HUD
-val getAll(){ static std::vector<float> buf; buf.resize(ents.size()*4); for(size_t i=0;i<ents.size();++i){ buf[i*4]=ents[i].x; buf[i*4+1]=ents[i].y; buf[i*4+2]=ents[i].r; buf[i*4+3]=ents[i].type; } return val(typed_memory_view(buf.size(), buf.data())); }
-int getCountByType(int t){ int c=0; for(auto &e:ents) if(e.type==t) c++; return c; }
+val getAll(){ static std::vector<float> buf; buf.resize((size_t)totalCount()*4); size_t o=0;
+  if(hasPlayer){ buf[0]=player.x; buf[1]=player.y; buf[2]=KIND_R[PLAYER]; buf[3]=PLAYER; o=4; }
+  for(int k=1;k<NKINDS;k++){ const Pool &P=pools[k]; for(int i=0;i<P.size();i++){ buf[o]=P.x[i]; buf[o+1]=P.y[i]; buf[o+2]=P.r; buf[o+3]=(float)k; o+=4; } }
+  return val(typed_memory_view(buf.size(), buf.data())); }
+val getFx(){ fillFx(); return val(typed_memory_view(fxBuf.size(), fxBuf.data())); } // x,y,alpha,type
+int getFxRecords(){ return fxSize; }
+int getEntityCount(){ return totalCount(); }
+void setGridMode(int m){ gridMode = m?1:0; initPools(); clearGrids(); }
+int getGridMode(){ return gridMode; }
+int getCountByType(int t){ if(t==PLAYER) return hasPlayer?1:0; if(t<0 || t>=NKINDS) return 0; if(t==PARTICLE || t==BEAMVIS) return fxLive[t]; return pools[t].size(); } // cosméticos: vivos en el último getFx()
 int getScore(){ return score; }
 int getLevel(){ return levelNum; }
 int getKeysLeft(){ return keysLeft; }
 int getKeysTotal(){ return keysTotal; }
-int getPlayerHP(){ if(playerIdx>=0) return ents[playerIdx].hp; return 0; }
+int getPlayerHP(){ if(hasPlayer) return player.hp; return 0; }
 
-EMSCRIPTEN_BINDINGS(ns){ function("reset", &reset); function("stress", &stress); function("input", &input); function("step", &step); function("getAll", &getAll); function("getCountByType", &getCountByType); function("getScore", &getScore); function("getLevel", &getLevel); function("getKeysLeft", &getKeysLeft); function("getKeysTotal", &getKeysTotal); function("getPlayerHP", &getPlayerHP); }
+EMSCRIPTEN_BINDINGS(ns){ function("reset", &reset); function("stress", &stress); function("input", &input); function("step", &step); function("getAll", &getAll); function("getCountByType", &getCountByType); function("getScore", &getScore); function("getLevel", &getLevel); function("getKeysLeft", &getKeysLeft); function("getKeysTotal", &getKeysTotal); function("getPlayerHP", &getPlayerHP); function("getEntityCount", &getEntityCount); function("getFx", &getFx); function("getFxRecords", &getFxRecords); function("setGridMode", &setGridMode); function("getGridMode", &getGridMode); }
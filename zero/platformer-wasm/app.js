@@ -7,27 +7,43 @@ class GL{ constructor(c){ this.c=c; this.g=c.getContext('webgl'); const g=this.g
 class Game{ constructor(){ this.cv=document.getElementById('canvas'); this.gl=new GL(this.cv); this.fps=0; this.last=performance.now(); this.keys={}; this.loop=this.loop.bind(this); this.init(); }
  async init(){ this.mod=await this.loadWASM(); this.mod.reset(); this.gl.resize(); addEventListener('resize',()=>this.gl.resize()); this.bindInput(); requestAnimationFrame(this.loop); }
  loadWASM(){ return new Promise((resolve,reject)=>{ const s=document.createElement('script'); s.src='physics.js'; s.onload=async()=>{ try{ if(typeof Module==='function'){ const m=await Module({}); resolve(m);} else if(typeof Module==='object'){ Module.onRuntimeInitialized=()=>resolve(Module);} else reject(new Error('Module not found')); } catch(e){reject(e);} }; s.onerror=reject; document.body.appendChild(s); }); }
- bindInput(){ addEventListener('keydown',(e)=>{ this.keys[e.code]=true; if(['ArrowUp','ArrowLeft','ArrowRight'].includes(e.code)) e.preventDefault(); if(e.code==='KeyR'){ this.mod.reset(); } }); addEventListener('keyup',(e)=>{ this.keys[e.code]=false; }); }
+ bindInput(){ addEventListener('keydown',(e)=>{ this.keys[e.code]=true; if(['ArrowUp','ArrowLeft','ArrowRight'].includes(e.code)) e.preventDefault(); if(e.code==='KeyR'){ this.plv=null; this.mod.reset(); } if(e.code==='KeyG'){ this.plv=null; this.mod.genLevel(100000, (Math.random()*1e9)|0); } if(e.code==='KeyL'){ this.openLevel('level.plv'); } if(e.code==='KeyB'){ this.mod.setBroadphase(!this.mod.getBroadphase()); } if(e.code==='KeyT'){ this.mod.stress(); } }); addEventListener('keyup',(e)=>{ this.keys[e.code]=false; }); }
+ // L: nivel .plv por chunks (./platformer-level nivel.json level.plv). El archivo queda como ArrayBuffer en JS;
+ // al wasm sólo se copian la cabecera y los chunks que pide alrededor del jugador.
+ // Un archivo corto (truncado o de otra versión) se rechaza antes de levelOpen(), como openBytes() en el nativo:
+ // si no, serveChunks() leería fuera del ArrayBuffer y el RangeError cortaría loop(). chunks = u32 en el byte 24.
+ async openLevel(url){ try{ const buf=await (await fetch(url)).arrayBuffer(); if(buf.byteLength<64) throw new Error(`${url}: ${buf.byteLength} B, no entra la cabecera`);
+  const need=64+new DataView(buf).getUint32(24,true)*this.mod.getChunkBytes(); if(buf.byteLength<need) throw new Error(`${url}: ${buf.byteLength} B, la cabecera pide ${need} B`);
+  this.mod.levelHeaderView().set(new Uint8Array(buf,0,64)); const err=this.mod.levelOpen(); if(err){ throw new Error(`${url}: levelOpen ${err}`); } this.plv=buf; this.chunks=new Map(); } catch(e){ console.error(e); this.plv=null; } }
+ serveChunks(){ const cb=this.mod.getChunkBytes(); for(let k; (k=this.mod.nextWantedChunk())>=0; ){ this.mod.chunkView(k).set(new Uint8Array(this.plv, 64+k*cb, cb)); this.mod.chunkLoaded(k); } }
+ // tiles por chunk residente: sólo llegan los de chunks nuevos, los descargados se sueltan
+ syncChunks(){ for(const k of this.mod.getDroppedChunks()) this.chunks.delete(k); const a=this.mod.getNewTiles(); for(let i=0;i<a.length;){ const n=a[i+1]; this.chunks.set(a[i], a.slice(i+2, i+2+n*4)); i+=2+n*4; }
+  let n=0; for(const t of this.chunks.values()) n+=t.length; const out=new Float32Array(n); n=0; for(const t of this.chunks.values()){ out.set(t,n); n+=t.length; } return out; }
  loop(){ const now=performance.now(); const dt=(now-this.last)/1000; this.last=now;
   const left = !!(this.keys['KeyA']||this.keys['ArrowLeft']);
   const right = !!(this.keys['KeyD']||this.keys['ArrowRight']);
   const jump = !!(this.keys['KeyW']||this.keys['ArrowUp']);
   const fire = !!(this.keys['KeyJ']||this.keys['KeyF']);
   this.mod.input(left,right,jump,fire);
+  if(this.plv) this.serveChunks();
   const t0=performance.now(); this.mod.step(dt); const stepMs=performance.now()-t0;
-  const p=this.mod.getPlayer(); const tiles=this.mod.getTiles(); const bullets=this.mod.getBullets(); const score=this.mod.getScore();
+  // cámara: ventana de 1x1 que sigue al jugador en x; sólo se piden los tiles que caen en ella
+  const p=this.mod.getPlayer(); const camX=Math.max(0, Math.min(this.mod.getLevelWidth()-1, p[0]+p[2]*0.5-0.5));
+  const tiles=this.plv? this.syncChunks() : this.mod.getTilesIn(camX,0,1,1); const bullets=this.mod.getBullets(); const enemies=this.mod.getEnemies(); const score=this.mod.getScore();
   // build draw buffers (rects como puntos para simplicidad)
-  const nRect=tiles.length/4; const total=nRect+1+(bullets.length/2); const pts=new Float32Array(total*2); const sizes=new Float32Array(total); const cols=new Float32Array(total*3);
+  const nRect=tiles.length/4; const nBul=bullets.length/3, nEn=enemies.length/2; const total=nRect+1+nEn+nBul; const pts=new Float32Array(total*2); const sizes=new Float32Array(total); const cols=new Float32Array(total*3);
   let k=0; // tiles
-  for(let i=0;i<nRect;i++,k++){ const x=tiles[i*4], y=tiles[i*4+1], w=tiles[i*4+2], h=tiles[i*4+3]; pts[k*2]=x+w*0.5; pts[k*2+1]=y+h*0.5; sizes[k]=Math.max(2.0, Math.min(12.0, Math.max(w,h)*250.0)); cols[k*3]=0.6; cols[k*3+1]=0.7; cols[k*3+2]=0.9; }
+  for(let i=0;i<nRect;i++,k++){ const x=tiles[i*4], y=tiles[i*4+1], w=tiles[i*4+2], h=tiles[i*4+3]; pts[k*2]=x+w*0.5-camX; pts[k*2+1]=y+h*0.5; sizes[k]=Math.max(2.0, Math.min(12.0, Math.max(w,h)*250.0)); cols[k*3]=0.6; cols[k*3+1]=0.7; cols[k*3+2]=0.9; }
   // player
-  pts[k*2]=p[0]+p[2]*0.5; pts[k*2+1]=p[1]+p[3]*0.5; sizes[k]=Math.max(4.0,p[3]*300.0); cols[k*3]=0.7; cols[k*3+1]=1.0; cols[k*3+2]=0.7; k++;
-  // bullets
-  for(let i=0;i<bullets.length/2;i++,k++){ pts[k*2]=bullets[i*2]; pts[k*2+1]=bullets[i*2+1]; sizes[k]=3.0; cols[k*3]=1.0; cols[k*3+1]=0.9; cols[k*3+2]=0.6; }
+  pts[k*2]=p[0]+p[2]*0.5-camX; pts[k*2+1]=p[1]+p[3]*0.5; sizes[k]=Math.max(4.0,p[3]*300.0); cols[k*3]=0.7; cols[k*3+1]=1.0; cols[k*3+2]=0.7; k++;
+  // enemigos (rect de 0.02 x 0.025)
+  for(let i=0;i<nEn;i++,k++){ pts[k*2]=enemies[i*2]+0.01-camX; pts[k*2+1]=enemies[i*2+1]+0.0125; sizes[k]=7.0; cols[k*3]=1.0; cols[k*3+1]=0.4; cols[k*3+2]=0.4; }
+  // balas: x, y, equipo (0 jugador, 1 enemigo)
+  for(let i=0;i<nBul;i++,k++){ pts[k*2]=bullets[i*3]-camX; pts[k*2+1]=bullets[i*3+1]; sizes[k]=3.0; if(bullets[i*3+2]){ cols[k*3]=1.0; cols[k*3+1]=0.5; cols[k*3+2]=0.9; } else { cols[k*3]=1.0; cols[k*3+1]=0.9; cols[k*3+2]=0.6; } }
   this.gl.draw(pts,sizes,cols);
-  this.updateHUD(stepMs, score);
+  this.updateHUD(stepMs, score, nRect);
   requestAnimationFrame(this.loop); }
- updateHUD(stepMs,score){ const fpsEl=document.getElementById('fps'); const stepEl=document.getElementById('step'); const sEl=document.getElementById('score'); this._frames=(this._frames||0)+1; if(this._frames%30===0){ const now=performance.now(); const d=now-(this._lastFps||now); this._fps=Math.round(30000/d); this._lastFps=now; fpsEl.textContent=this._fps; } stepEl.textContent=stepMs.toFixed(2); sEl.textContent=score; }
+ updateHUD(stepMs,score,visible){ const fpsEl=document.getElementById('fps'); const stepEl=document.getElementById('step'); const sEl=document.getElementById('score'); this._frames=(this._frames||0)+1; if(this._frames%30===0){ const now=performance.now(); const d=now-(this._lastFps||now); this._fps=Math.round(30000/d); this._lastFps=now; fpsEl.textContent=this._fps; } stepEl.textContent=stepMs.toFixed(2); sEl.textContent=score; const lvEl=document.getElementById('level'); if(lvEl) lvEl.textContent=`${this.mod.getTileCount()} tiles · ${visible} ${this.plv? `residentes (${this.chunks.size} chunks, ${this.mod.getResidentBytes()} B)` : 'en pantalla'} · ${this.mod.getTileTests()} tests/step · ${this.mod.getBroadphase()? 'grilla + árbol' : 'lineal'}`; const acEl=document.getElementById('actors'); if(acEl) acEl.textContent=`${this.mod.getBulletCount()}/${this.mod.getMaxBullets()} balas · ${this.mod.getEnemyCount()} enemigos · ${this.mod.getPairTests()} tests bala-enemigo · ${this.mod.getKills()} bajas · ${this.mod.getPlayerHits()} impactos recibidos`; }
 }
 
 document.addEventListener('DOMContentLoaded',()=>new Game());
@@ -1,6 +1,21 @@
 #!/bin/bash
 set -euo pipefail
 
+# ./build.sh          -> physics.js (WASM)
+# ./build.sh native   -> platformer-bench (niveles de 1K a 1M tiles: costo por step con índices vs lineal; JSON vs .plv;
+#                                          stress() con miles de balas y enemigos)
+#                        platformer-level (conversor: ./platformer-level nivel.json level.plv,
+#                                          nivel de prueba: ./platformer-level --gen 100000 7 nivel.json)
+MODE="${1:-wasm}"
+
+if [ "$MODE" = "native" ]; then
+  echo "🔨 Compilando benchmark nativo (Platformer)..."
+  ${CXX:-c++} physics.cpp -O3 -std=c++17 -DPLATFORMER_BENCH -o platformer-bench
+  ${CXX:-c++} physics.cpp -O2 -std=c++17 -DPLATFORMER_LEVELTOOL -o platformer-level
+  echo "✅ Compilación OK → ./platformer-bench ./platformer-level"
+  exit 0
+fi
+
 echo "🔨 Compilando Platformer WASM ..."
 
 emcc physics.cpp \
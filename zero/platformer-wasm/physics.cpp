@@ -1,15 +1,14 @@
+#ifdef __EMSCRIPTEN__
 #include <emscripten/bind.h>
+using namespace emscripten;
+#endif
 #include <vector>
 #include <cmath>
 #include <cstdint>
 #include <algorithm>
-using namespace emscripten;
+#include <cstring>
 
 struct Rect{ float x,y,w,h; };
-struct Bullet{ float x,y,vx,vy,ttl; };
-
-static std::vector<Rect> tiles;
-static std::vector<Bullet> bullets;
 
 struct Player{ float x=0.1f,y=0.1f,w=0.02f,h=0.04f,vx=0,vy=0; bool grounded=false; };
 static Player player;
@@ -17,22 +16,188 @@ static int score=0;
 
 static float GRAV=1.6f; static float MOVE=0.6f; static float JUMP=0.55f; static float FRICTION=0.85f; static float BULLET_SPD=1.2f; static float BULLET_TTL=1.0f;
 
-void reset(){ tiles.clear(); bullets.clear(); player=Player(); score=0;
-  // Crear tiles (plataformas) en coords normalizadas [0,1]
-  tiles.push_back({0.0f,0.95f,1.0f,0.05f}); // suelo
-  tiles.push_back({0.1f,0.75f,0.25f,0.03f});
-  tiles.push_back({0.45f,0.65f,0.25f,0.03f});
-  tiles.push_back({0.75f,0.55f,0.2f,0.03f});
-  tiles.push_back({0.2f,0.45f,0.2f,0.03f});
-  tiles.push_back({0.05f,0.32f,0.15f,0.03f});
-  tiles.push_back({0.4f,0.32f,0.2f,0.03f});
-  tiles.push_back({0.7f,0.25f,0.25f,0.03f});
+// Nivel: levelW x 1 en unidades de pantalla (x crece a la derecha, y hacia abajo). Dos índices estáticos:
+//  - grilla uniforme de TILE x TILE con un byte por celda para los tiles alineados (casi todo un nivel grande)
+//  - árbol AABB plano sobre los rects arbitrarios (tiles), armado top-down por mediana; cada hoja es un rango
+//    contiguo de tiles, que se reordena al armarlo
+// Jugador y balas consultan sólo las celdas bajo su rect y las ramas del árbol que lo cortan.
+static const float TILE=0.025f; static const int ROWS=40; static const int LEAF_MAX=4;
+static float levelW=1.0f; static int cols=40, gridTiles=0;
+static std::vector<uint8_t> solid(cols*ROWS); // fila mayor: solid[cy*cols+cx]
+static std::vector<Rect> tiles;
+struct Node{ float x0,y0,x1,y1; int left,right,first,count; }; // hoja si count>0
+static std::vector<Node> tree; static bool treeDirty=true;
+static bool broadphase=true; static long long tileTests=0; // rects probados en el último step (jugador + balas)
+
+// Formato binario de nivel (.plv, little-endian): cabecera de 64 bytes y después chunks de tamaño fijo, el
+// chunk k en PLV_HEADER + k*sizeof(Chunk). Un chunk son CHUNK columnas: una máscara de 64 bits por columna
+// (bit cy = celda sólida) y hasta CHUNK_RECTS rects sueltos que empiezan en él (el conversor parte los más
+// anchos que un chunk). Se copia tal cual del ArrayBuffer al heap: no hay nada que parsear por tile.
+// Un nivel abierto así (streamed) sólo tiene residentes los chunks a RESIDENT_RADIUS del jugador, en SLOTS
+// lugares fijos (el chunk k va al slot k%SLOTS): memoria y arranque no dependen del largo del nivel.
+static const uint32_t PLV_MAGIC=0x4C56504C, PLV_VERSION=1; // "PLVL"
+static const int CHUNK=32, CHUNK_RECTS=16, SLOTS=8, RESIDENT_RADIUS=2, PLV_HEADER=64;
+struct LevelHeader{ uint32_t magic, version, cols, rows, chunkCols, chunkRects, chunks, tiles; float tile; uint32_t reserved[7]; };
+struct Chunk{ uint64_t col[CHUNK]; uint32_t nrects, pad; Rect rects[CHUNK_RECTS]; };
+static_assert(sizeof(LevelHeader)==PLV_HEADER && sizeof(Chunk)==520, "layout del .plv");
+struct Slot{ int id=-1; Chunk c; };
+static Slot slots[SLOTS]; static LevelHeader levelHdr;
+static bool streamed=false; static int levelTiles=0, chunkLoads=0;
+static std::vector<int> freshChunks, droppedChunks; // para el renderer: cargados / descargados desde la última consulta
+
+static inline bool cellAt(int cx,int cy){
+  if(!streamed) return solid[(size_t)cy*cols+cx];
+  const Slot &s=slots[(cx/CHUNK)%SLOTS]; return s.id==cx/CHUNK && ((s.c.col[cx%CHUNK]>>cy)&1);
 }
 
 static bool overlap(const Rect&a,const Rect&b){ return !(a.x+a.w<b.x || b.x+b.w<a.x || a.y+a.h<b.y || b.y+b.h<a.y); }
 
+static int buildNode(int first,int count){
+  Node n{1e30f,1e30f,-1e30f,-1e30f,-1,-1,first,count};
+  for(int i=first;i<first+count;i++){ const Rect &t=tiles[i]; n.x0=std::min(n.x0,t.x); n.y0=std::min(n.y0,t.y); n.x1=std::max(n.x1,t.x+t.w); n.y1=std::max(n.y1,t.y+t.h); }
+  const int id=(int)tree.size(); tree.push_back(n);
+  if(count>LEAF_MAX){ // partir por la mediana del eje más largo
+    const bool byX= n.x1-n.x0 >= n.y1-n.y0; const int mid=first+count/2;
+    std::nth_element(tiles.begin()+first, tiles.begin()+mid, tiles.begin()+first+count, [byX](const Rect &a,const Rect &b){ return byX? a.x+a.w*0.5f < b.x+b.w*0.5f : a.y+a.h*0.5f < b.y+b.h*0.5f; });
+    const int l=buildNode(first, mid-first), r=buildNode(mid, first+count-mid);
+    tree[id].left=l; tree[id].right=r; tree[id].count=0;
+  }
+  return id;
+}
+static void buildTree(){ tree.clear(); if(!tiles.empty()) buildNode(0,(int)tiles.size()); treeDirty=false; }
+
+// Llama f(rect) por cada tile que puede tocar q (los bordes que se tocan cuentan, como en overlap()); si f
+// devuelve true corta. forCells mira sólo la grilla, forRects sólo el árbol. Sin broadphase recorre todo el
+// nivel como antes.
+template<class F> static bool forCells(const Rect &q, F &&f){
+  const int cx0=std::max(0,(int)std::floor(q.x/TILE)-1), cx1=std::min(cols-1,(int)std::floor((q.x+q.w)/TILE));
+  const int cy0=std::max(0,(int)std::floor(q.y/TILE)-1), cy1=std::min(ROWS-1,(int)std::floor((q.y+q.h)/TILE));
+  for(int cy=cy0;cy<=cy1;cy++) for(int cx=cx0;cx<=cx1;cx++) if(cellAt(cx,cy)){ tileTests++; if(f(Rect{cx*TILE,cy*TILE,TILE,TILE})) return true; }
+  return false;
+}
+template<class F> static bool forRects(const Rect &q, F &&f){
+  if(treeDirty) buildTree();
+  if(tree.empty()) return false;
+  int stack[64], sp=0; stack[sp++]=0;
+  while(sp){ const Node &n=tree[stack[--sp]];
+    if(q.x+q.w<n.x0 || n.x1<q.x || q.y+q.h<n.y0 || n.y1<q.y) continue;
+    if(n.count){ for(int i=n.first;i<n.first+n.count;i++){ tileTests++; if(f(tiles[i])) return true; } }
+    else { stack[sp++]=n.left; stack[sp++]=n.right; }
+  }
+  return false;
+}
+template<class F> static bool forTiles(const Rect &q, F &&f){
+  if(!broadphase){
+    for(const auto &t:tiles){ tileTests++; if(f(t)) return true; }
+    for(int cy=0;cy<ROWS;cy++) for(int cx=0;cx<cols;cx++) if(cellAt(cx,cy)){ tileTests++; if(f(Rect{cx*TILE,cy*TILE,TILE,TILE})) return true; }
+    return false;
+  }
+  return forCells(q,f) || forRects(q,f);
+}
+
+// Balas y enemigos en pools SoA de capacidad fija (se reservan una vez; vivos en [0,n), compactados al final
+// de cada step). bteam: 0 jugador, 1 enemigo. Los enemigos patrullan: caminan, giran ante una pared o un
+// borde y le disparan al jugador si lo tienen cerca. El pool de enemigos está ordenado por x, así los que
+// están cerca del jugador son un rango contiguo aunque el nivel tenga miles.
+static const int MAXB=16384, MAXE=4096;
+static std::vector<float> bx, by, bvx, bvy, bttl; static std::vector<uint8_t> bteam; static int nbullets=0;
+static std::vector<float> ex, ey, evx, evy, ecool; static std::vector<int8_t> ehp; static int nenemies=0;
+static const float BULLET_SIZE=0.006f, ENEMY_W=0.02f, ENEMY_H=0.025f, ENEMY_SPD=0.15f, ENEMY_RANGE=0.8f, ENEMY_FIRE=2.0f, ENEMY_SHOT_SPD=0.5f, ENEMY_SHOT_TTL=2.0f; static const int ENEMY_HP=3;
+static int kills=0, playerHits=0; static long long pairTests=0; // bala-enemigo en el último step
+static uint32_t rngState=1; static inline float frand(){ rngState^=rngState<<13; rngState^=rngState>>17; rngState^=rngState<<5; return (rngState&0xFFFFFF)/16777216.0f; }
+
+static inline void allocPools(){ if(!bx.empty()) return; for(auto *v: {&bx,&by,&bvx,&bvy,&bttl}) v->resize(MAXB); bteam.resize(MAXB); for(auto *v: {&ex,&ey,&evx,&evy,&ecool}) v->resize(MAXE); ehp.resize(MAXE); }
+static void resetActors(){ allocPools(); nbullets=0; nenemies=0; kills=0; playerHits=0; rngState=1; player=Player(); score=0; }
+static inline bool spawnBullet(float x,float y,float vx,float vy,float ttl,uint8_t team){ if(nbullets>=MAXB) return false; const int i=nbullets++; bx[i]=x; by[i]=y; bvx[i]=vx; bvy[i]=vy; bttl[i]=ttl; bteam[i]=team; return true; }
+static inline bool spawnEnemy(float x,float y,bool right){ if(nenemies>=MAXE) return false; const int i=nenemies++; ex[i]=x; ey[i]=y; evx[i]= right? ENEMY_SPD : -ENEMY_SPD; evy[i]=0; ecool[i]=frand()*ENEMY_FIRE; ehp[i]=ENEMY_HP; return true; }
+
+// Nivel vacío en memoria de c columnas (el nivel entero residente, como siempre)
+static void clearLevel(int c){ streamed=false; cols=std::max(1,c); levelW=cols*TILE; std::vector<uint8_t>((size_t)cols*ROWS,0).swap(solid); gridTiles=0; tiles.clear(); treeDirty=true; }
+void setCell(int cx,int cy,bool on){ if(streamed || cx<0 || cx>=cols || cy<0 || cy>=ROWS) return; uint8_t &c=solid[(size_t)cy*cols+cx]; gridTiles+= (int)on-(int)c; c=on? 1 : 0; }
+void addRect(float x,float y,float w,float h){ if(streamed) return; tiles.push_back({x,y,w,h}); treeDirty=true; }
+
+void reset(){ resetActors(); clearLevel(40);
+  // Crear tiles (plataformas) en coords normalizadas [0,1]
+  addRect(0.0f,0.95f,1.0f,0.05f); // suelo
+  addRect(0.1f,0.75f,0.25f,0.03f);
+  addRect(0.45f,0.65f,0.25f,0.03f);
+  addRect(0.75f,0.55f,0.2f,0.03f);
+  addRect(0.2f,0.45f,0.2f,0.03f);
+  addRect(0.05f,0.32f,0.15f,0.03f);
+  addRect(0.4f,0.32f,0.2f,0.03f);
+  addRect(0.7f,0.25f,0.25f,0.03f);
+  buildTree();
+  spawnEnemy(0.3f,0.05f,true); spawnEnemy(0.55f,0.05f,false); spawnEnemy(0.85f,0.05f,true);
+}
+
+// Nivel procedural de ~n tiles: suelo de dos filas con pozos, tiras de plataformas alineadas a la grilla y
+// de vez en cuando una plataforma suelta (va al árbol), más un enemigo cada ~2 unidades que cae desde arriba
+// a lo que tenga debajo. Misma semilla, mismo nivel.
+void genLevel(int n,int seed){
+  resetActors();
+  uint32_t s= seed? (uint32_t)seed : 1u; auto rnd=[&s]{ s^=s<<13; s^=s>>17; s^=s<<5; return s; };
+  clearLevel(std::max(40, n*40/150)); // ~150 tiles por unidad de ancho
+  for(int cx=0; cx<cols; cx++){
+    if(cx>8 && rnd()%23==0) cx+=2; // pozo de 2 celdas
+    for(int cy=ROWS-2; cy<ROWS; cy++) setCell(cx,cy,true);
+    if(rnd()%3==0){ const int cy=10+rnd()%24, run=3+rnd()%6; for(int k=0;k<run;k++) setCell(cx+k,cy,true); }
+    if(rnd()%40==0) addRect(cx*TILE+(rnd()%100)*0.0001f, 0.2f+(rnd()%500)*0.001f, 0.05f+(rnd()%100)*0.001f, 0.015f);
+  }
+  for(float x=1.0f; x+ENEMY_W<levelW; x+=1.5f+(rnd()%100)*0.01f) spawnEnemy(x, 0.05f, rnd()&1);
+  buildTree();
+}
+
+// Nivel en memoria -> .plv. Falla si algún chunk junta más de CHUNK_RECTS rects.
+static bool writeLevel(std::vector<uint8_t> &out){
+  if(streamed) return false;
+  const int chunks=(cols+CHUNK-1)/CHUNK;
+  LevelHeader h{}; h.magic=PLV_MAGIC; h.version=PLV_VERSION; h.cols=cols; h.rows=ROWS; h.chunkCols=CHUNK; h.chunkRects=CHUNK_RECTS; h.chunks=chunks; h.tile=TILE;
+  std::vector<Chunk> cs(chunks); std::memset(cs.data(), 0, cs.size()*sizeof(Chunk));
+  for(int cy=0;cy<ROWS;cy++) for(int cx=0;cx<cols;cx++) if(solid[(size_t)cy*cols+cx]){ cs[cx/CHUNK].col[cx%CHUNK]|=1ull<<cy; h.tiles++; }
+  for(const Rect &t:tiles){ float x=t.x; const float x1=t.x+t.w; // partido en los bordes de chunk
+    do{ const int k=std::min(chunks-1, std::max(0,(int)std::floor(x/(CHUNK*TILE)))); const float end=std::min(x1,(k+1)*CHUNK*TILE);
+      Chunk &c=cs[k]; if(c.nrects>=(uint32_t)CHUNK_RECTS) return false;
+      c.rects[c.nrects++]={x,t.y,(k==chunks-1? x1 : end)-x,t.h}; h.tiles++; x=end;
+    } while(x<x1 && x<levelW); }
+  out.resize(PLV_HEADER+cs.size()*sizeof(Chunk)); std::memcpy(out.data(), &h, PLV_HEADER); std::memcpy(out.data()+PLV_HEADER, cs.data(), cs.size()*sizeof(Chunk));
+  return true;
+}
+
+// Apertura de un .plv: quien carga copia la cabecera en levelHeaderBytes() y llama levelOpen(); después, en
+// cada frame, pide nextWantedChunk(), copia ese chunk del archivo en chunkSlot(id) y llama chunkLoaded(id).
+// levelOpen: 0 ok, -1 no es un .plv, -2 otra versión, -3 otro tamaño de chunk/grilla.
+static uint8_t *levelHeaderBytes(){ return (uint8_t*)&levelHdr; }
+int levelOpen(){ const LevelHeader &h=levelHdr;
+  if(h.magic!=PLV_MAGIC) return -1;
+  if(h.version!=PLV_VERSION) return -2;
+  if(h.rows!=(uint32_t)ROWS || h.chunkCols!=(uint32_t)CHUNK || h.chunkRects!=(uint32_t)CHUNK_RECTS || h.tile!=TILE || h.chunks!=(h.cols+CHUNK-1)/CHUNK) return -3;
+  resetActors();
+  streamed=true; cols=(int)h.cols; levelW=cols*TILE; levelTiles=(int)h.tiles; std::vector<uint8_t>().swap(solid); gridTiles=0; std::vector<Rect>().swap(tiles); std::vector<Node>().swap(tree); treeDirty=true;
+  for(auto &sl:slots) sl.id=-1;
+  freshChunks.clear(); droppedChunks.clear(); chunkLoads=0;
+  return 0;
+}
+static int playerChunk(){ return std::min(cols-1, std::max(0,(int)((player.x+player.w*0.5f)/TILE)))/CHUNK; }
+static bool resident(int k){ return slots[k%SLOTS].id==k; }
+// próximo chunk a cargar alrededor del jugador (primero el suyo, después alternando a los lados) o -1
+int nextWantedChunk(){ if(!streamed) return -1; const int c=playerChunk(), n=(int)levelHdr.chunks;
+  for(int d=0; d<=RESIDENT_RADIUS; d++) for(int k : {c+d, c-d}) if(k>=0 && k<n && !resident(k)) return k;
+  return -1; }
+static void residentRects(){ tiles.clear(); for(const auto &sl:slots) if(sl.id>=0) tiles.insert(tiles.end(), sl.c.rects, sl.c.rects+std::min(sl.c.nrects,(uint32_t)CHUNK_RECTS)); treeDirty=true; }
+// lugar donde copiar el chunk k: desaloja al que ocupaba su slot
+static uint8_t *chunkSlot(int k){ Slot &sl=slots[k%SLOTS]; if(sl.id>=0){ droppedChunks.push_back(sl.id); sl.id=-1; residentRects(); } return (uint8_t*)&sl.c; }
+void chunkLoaded(int k){ Slot &sl=slots[k%SLOTS]; sl.id=k; sl.c.nrects=std::min(sl.c.nrects,(uint32_t)CHUNK_RECTS); freshChunks.push_back(k); chunkLoads++; residentRects(); }
+int getChunkLoads(){ return chunkLoads; }
+int getResidentBytes(){ return (int)(sizeof(slots)+tiles.capacity()*sizeof(Rect)+tree.capacity()*sizeof(Node)+solid.capacity()); }
+bool isStreamed(){ return streamed; }
+
 static void collidePlayer(){ player.grounded=false; Rect pr{player.x,player.y,player.w,player.h};
-  for(const auto&t:tiles){ Rect r=t; if(!overlap(pr,r)) continue; // resolver mínimamente por ejes
+  // los empujes mueven al jugador a lo sumo hasta el borde de un tile que ya toca: alcanza con juntar los
+  // candidatos una vez con el rect inflado y resolver en orden
+  static std::vector<Rect> near; near.clear();
+  const float m=std::max(player.w,player.h);
+  forTiles(Rect{pr.x-m,pr.y-m,pr.w+2*m,pr.h+2*m}, [](const Rect &t){ near.push_back(t); return false; });
+  for(const auto&t:near){ Rect r=t; if(!overlap(pr,r)) continue; // resolver mínimamente por ejes
     float dx1 = (r.x + r.w) - pr.x; // empuje hacia izq
     float dx2 = (pr.x + pr.w) - r.x; // empuje hacia der
     float dy1 = (r.y + r.h) - pr.y; // empuje hacia arriba
@@ -49,28 +214,317 @@ static void collidePlayer(){ player.grounded=false; Rect pr{player.x,player.y,pl
   }
 }
 
+// Ventana activa: ACTIVE_X a cada lado del jugador (entra en los chunks residentes de un nivel .plv). Fuera de
+// ella los enemigos quedan quietos y las balas mueren. Consultas por lote: una sola consulta al árbol por step
+// con toda la ventana, y los rects que devuelve se reparten en franjas verticales de STRIP (conteo + prefijos);
+// cada bala o enemigo mira las celdas de la grilla bajo su rect y la franja de su x, sin recorrer el árbol.
+// Además, una grilla uniforme de ENEMY_CELL sobre la ventana con los enemigos activos para los impactos de bala.
+static const float ACTIVE_X=1.5f, WIN_PAD=0.1f, STRIP=0.1f, ENEMY_CELL=0.05f; static const int MAX_STRIPS=40, EGX_MAX=80, EGY=20;
+static float winX0=0, winX1=0; static int strips=0, egx=1;
+static std::vector<int> stripStart(MAX_STRIPS+1), stripFill(MAX_STRIPS); static std::vector<Rect> winRects, stripRects;
+static std::vector<int> cellStart(EGX_MAX*EGY+1), cellFill(EGX_MAX*EGY), cellEnemies(MAXE), enemyCell(MAXE);
+
+static inline bool activeX(float x){ return std::fabs(x-player.x)<=ACTIVE_X; }
+static inline void enemyRange(float x0,float x1,int &a,int &b){ a=(int)(std::lower_bound(ex.begin(), ex.begin()+nenemies, x0)-ex.begin()); b=(int)(std::upper_bound(ex.begin()+a, ex.begin()+nenemies, x1)-ex.begin()); }
+static inline void swapEnemies(int i,int j){ std::swap(ex[i],ex[j]); std::swap(ey[i],ey[j]); std::swap(evx[i],evx[j]); std::swap(evy[i],evy[j]); std::swap(ecool[i],ecool[j]); std::swap(ehp[i],ehp[j]); }
+// por inserción en [a,b): los enemigos se mueven poco por step, así que casi siempre es una pasada
+static void sortEnemies(int a,int b){ for(int i=a+1;i<b;i++) for(int j=i; j>a && ex[j]<ex[j-1]; j--) swapEnemies(j,j-1); }
+static inline void stripRange(float x0,float x1,int &s0,int &s1){ s0=std::max(0,(int)std::floor((x0-winX0)/STRIP)); s1=std::min(strips-1,(int)std::floor((x1-winX0)/STRIP)); }
+static void buildWindow(){
+  winX0=player.x-ACTIVE_X-WIN_PAD; winX1=player.x+ACTIVE_X+WIN_PAD+ENEMY_W;
+  strips=std::min(MAX_STRIPS,(int)std::ceil((winX1-winX0)/STRIP)); egx=std::min(EGX_MAX,(int)std::ceil((winX1-winX0)/ENEMY_CELL));
+  winRects.clear(); if(broadphase) forRects(Rect{winX0,0,winX1-winX0,1}, [](const Rect &t){ winRects.push_back(t); return false; });
+  std::fill(stripFill.begin(), stripFill.begin()+strips, 0); int s0,s1;
+  for(const Rect &t:winRects){ stripRange(t.x,t.x+t.w,s0,s1); for(int k=s0;k<=s1;k++) stripFill[k]++; }
+  stripStart[0]=0; for(int k=0;k<strips;k++){ stripStart[k+1]=stripStart[k]+stripFill[k]; stripFill[k]=stripStart[k]; }
+  stripRects.resize(stripStart[strips]);
+  for(const Rect &t:winRects){ stripRange(t.x,t.x+t.w,s0,s1); for(int k=s0;k<=s1;k++) stripRects[stripFill[k]++]=t; }
+}
+// ¿q toca algún tile? strict: los bordes que sólo se tocan no cuentan (un enemigo parado sobre un tile no lo
+// choca). Con top, junta el borde superior más alto de lo que toca.
+static bool tileHit(const Rect &q, bool strict, float *top=nullptr){
+  float best=1e30f;
+  auto f=[&](const Rect &t){ const bool hit= strict? (q.x<t.x+t.w && t.x<q.x+q.w && q.y<t.y+t.h && t.y<q.y+q.h) : overlap(q,t);
+    if(!hit) return false;
+    best=std::min(best,t.y); return !top; };
+  if(!broadphase) forTiles(q,f);
+  else if(!forCells(q,f)){ int s0,s1; stripRange(q.x,q.x+q.w,s0,s1); bool stop=false;
+    for(int k=s0;k<=s1 && !stop;k++) for(int j=stripStart[k];j<stripStart[k+1] && !stop;j++){ tileTests++; stop=f(stripRects[j]); } }
+  if(top) *top=best;
+  return best<1e30f;
+}
+
+static void stepEnemies(float dt){ int a,b; enemyRange(player.x-ACTIVE_X, player.x+ACTIVE_X, a, b);
+  for(int i=a;i<b;i++){ if(ehp[i]<=0) continue;
+    // vertical: cae hasta apoyarse (nunca sube por un empuje)
+    float top; bool grounded=false; evy[i]+=GRAV*dt; const float ny=ey[i]+evy[i]*dt;
+    if(evy[i]>0 && tileHit(Rect{ex[i],ny,ENEMY_W,ENEMY_H}, true, &top)){ ey[i]=std::max(ey[i], std::min(ny, top-ENEMY_H)); evy[i]=0; grounded=true; }
+    else ey[i]=ny;
+    if(ey[i]>1){ ehp[i]=0; continue; } // cayó a un pozo
+    // horizontal: gira ante una pared, el borde del nivel o (apoyado) el borde de la plataforma
+    const float nx=ex[i]+evx[i]*dt;
+    if(nx<0 || nx+ENEMY_W>levelW || tileHit(Rect{nx,ey[i],ENEMY_W,ENEMY_H}, true)) evx[i]=-evx[i];
+    else { ex[i]=nx; if(grounded && !tileHit(Rect{evx[i]>0? ex[i]+ENEMY_W : ex[i]-0.004f, ey[i]+ENEMY_H, 0.004f, 0.004f}, true)) evx[i]=-evx[i]; }
+    // disparo al centro del jugador
+    ecool[i]-=dt; const float dx=player.x+player.w*0.5f-(ex[i]+ENEMY_W*0.5f), dy=player.y+player.h*0.5f-(ey[i]+ENEMY_H*0.3f), d=std::sqrt(dx*dx+dy*dy);
+    if(ecool[i]<=0 && d<ENEMY_RANGE && d>1e-4f){ spawnBullet(ex[i]+ENEMY_W*0.5f, ey[i]+ENEMY_H*0.3f, dx/d*ENEMY_SHOT_SPD, dy/d*ENEMY_SHOT_SPD, ENEMY_SHOT_TTL, 1); ecool[i]=ENEMY_FIRE*(0.75f+0.5f*frand()); }
+  }
+  // los que se movieron sólo pueden haber cruzado vecinos cercanos: reordenar un poco más allá del rango
+  enemyRange(player.x-ACTIVE_X-WIN_PAD, player.x+ACTIVE_X+WIN_PAD, a, b); sortEnemies(std::max(0,a-1), std::min(nenemies,b+1));
+}
+
+static inline int enemyCellOf(float x,float y){ const int cx=std::min(egx-1,std::max(0,(int)((x-winX0)/ENEMY_CELL))), cy=std::min(EGY-1,std::max(0,(int)(y/ENEMY_CELL))); return cy*egx+cx; }
+static int ea=0, eb=0; // rango de enemigos activos en este step
+static void buildEnemyGrid(){ const int nc=egx*EGY; enemyRange(player.x-ACTIVE_X, player.x+ACTIVE_X, ea, eb);
+  std::fill(cellFill.begin(), cellFill.begin()+nc, 0);
+  for(int i=ea;i<eb;i++){ enemyCell[i]= ehp[i]>0? enemyCellOf(ex[i]+ENEMY_W*0.5f, ey[i]+ENEMY_H*0.5f) : -1; if(enemyCell[i]>=0) cellFill[enemyCell[i]]++; }
+  cellStart[0]=0; for(int c=0;c<nc;c++){ cellStart[c+1]=cellStart[c]+cellFill[c]; cellFill[c]=cellStart[c]; }
+  for(int i=ea;i<eb;i++) if(enemyCell[i]>=0) cellEnemies[cellFill[enemyCell[i]]++]=i;
+}
+static inline bool hitsEnemy(int b,int e){ pairTests++; return ehp[e]>0 && bx[b]<ex[e]+ENEMY_W && ex[e]<bx[b]+BULLET_SIZE && by[b]<ey[e]+ENEMY_H && ey[e]<by[b]+BULLET_SIZE; }
+// enemigo activo de menor índice que toca la bala b (o -1), el mismo que encuentra el recorrido lineal; las
+// 3x3 celdas alrededor alcanzan porque ENEMY_CELL > tamaño de enemigo + bala
+static int enemyAt(int b){
+  if(!broadphase){ for(int e=ea;e<eb;e++) if(hitsEnemy(b,e)) return e; return -1; }
+  const int c=enemyCellOf(bx[b]+BULLET_SIZE*0.5f, by[b]+BULLET_SIZE*0.5f), cx=c%egx, cy=c/egx; int best=-1;
+  for(int y=std::max(0,cy-1); y<=std::min(EGY-1,cy+1); y++) for(int x=std::max(0,cx-1); x<=std::min(egx-1,cx+1); x++){ const int k=y*egx+x;
+    for(int j=cellStart[k]; j<cellStart[k+1]; j++){ const int e=cellEnemies[j]; if((best<0 || e<best) && hitsEnemy(b,e)) best=e; } }
+  return best;
+}
+
+static void stepBullets(float dt){
+  { float * __restrict x=bx.data(); float * __restrict y=by.data(); float * __restrict t=bttl.data(); const float * __restrict vx=bvx.data(); const float * __restrict vy=bvy.data();
+    for(int i=0;i<nbullets;i++){ x[i]+=vx[i]*dt; y[i]+=vy[i]*dt; t[i]-=dt; } }
+  const Rect pr{player.x,player.y,player.w,player.h};
+  for(int i=0;i<nbullets;i++){
+    if(bttl[i]<=0 || bx[i]<winX0 || bx[i]+BULLET_SIZE>winX1 || by[i]<0 || by[i]>1 || tileHit(Rect{bx[i],by[i],BULLET_SIZE,BULLET_SIZE}, false)){ bttl[i]=0; continue; }
+    if(bteam[i]==0){ const int e=enemyAt(i); if(e>=0){ bttl[i]=0; if(--ehp[e]==0) kills++; } }
+    else if(overlap(pr, Rect{bx[i],by[i],BULLET_SIZE,BULLET_SIZE})){ bttl[i]=0; playerHits++; }
+  }
+}
+
+// compacta los pools en orden desde el primer muerto (sin huecos, sin reservar)
+static void compactActors(){
+  int n=0; while(n<nbullets && bttl[n]>0) n++;
+  for(int i=n;i<nbullets;i++) if(bttl[i]>0){ bx[n]=bx[i]; by[n]=by[i]; bvx[n]=bvx[i]; bvy[n]=bvy[i]; bttl[n]=bttl[i]; bteam[n]=bteam[i]; n++; }
+  nbullets=n;
+  n=0; while(n<nenemies && ehp[n]>0) n++;
+  for(int i=n;i<nenemies;i++) if(ehp[i]>0){ ex[n]=ex[i]; ey[n]=ey[i]; evx[n]=evx[i]; evy[n]=evy[i]; ecool[n]=ecool[i]; ehp[n]=ehp[i]; n++; }
+  nenemies=n;
+}
+
 void step(float dt){ // gravedad y movimiento
+  tileTests=0; pairTests=0;
+  if(streamed && !resident(playerChunk())) return; // todavía no llegó el chunk del jugador: esperar
   player.vy += GRAV*dt; player.y += player.vy*dt; collidePlayer();
   player.x += player.vx*dt; collidePlayer();
   // fricción horizontal cuando está en el suelo
-  if(player.grounded) player.vx *= FRICTION; 
+  if(player.grounded) player.vx *= FRICTION;
   // límites
-  if(player.x<0) { player.x=0; player.vx=0;} if(player.x+player.w>1){ player.x=1-player.w; player.vx=0; }
+  if(player.x<0) { player.x=0; player.vx=0;} if(player.x+player.w>levelW){ player.x=levelW-player.w; player.vx=0; }
   if(player.y+player.h>1){ player.y=1-player.h; player.vy=0; player.grounded=true; }
-  // bullets
-  for(size_t i=0;i<bullets.size();){ Bullet &b=bullets[i]; b.x+=b.vx*dt; b.y+=b.vy*dt; b.ttl-=dt; Rect br{b.x,b.y,0.006f,0.006f}; bool hit=false; for(const auto&t:tiles){ if(overlap(br,t)){ hit=true; break; } }
-    if(hit||b.ttl<=0||b.x<0||b.x>1||b.y<0||b.y>1){ bullets[i]=bullets.back(); bullets.pop_back(); } else { ++i; }
-  }
+  // enemigos y balas
+  buildWindow(); stepEnemies(dt); buildEnemyGrid(); stepBullets(dt); compactActors();
 }
 
 void input(bool left,bool right,bool jump,bool fire){ if(left) player.vx -= MOVE*(1.0f/60.0f); if(right) player.vx += MOVE*(1.0f/60.0f); if(jump && player.grounded){ player.vy = -JUMP; player.grounded=false; }
-  if(fire){ Bullet b; b.x=player.x+player.w*0.5f; b.y=player.y+player.h*0.4f; b.vx=BULLET_SPD; b.vy=0; b.ttl=BULLET_TTL; bullets.push_back(b); score+=1; }
+  if(fire && spawnBullet(player.x+player.w*0.5f, player.y+player.h*0.4f, BULLET_SPD, 0, BULLET_TTL, 0)) score+=1;
+}
+
+// Carga para medir: 2000 enemigos repartidos en la ventana activa (caen sobre lo que tengan debajo) y 8000
+// balas, la mitad un abanico del jugador y la mitad disparos enemigos hacia él.
+void stress(){ allocPools();
+  for(int i=0;i<2000;i++) spawnEnemy(std::min(levelW-ENEMY_W, std::max(0.0f, player.x-ACTIVE_X+2*ACTIVE_X*frand())), 0.02f+0.1f*frand(), frand()<0.5f);
+  const float cx=player.x+player.w*0.5f, cy=player.y+player.h*0.4f;
+  for(int i=0;i<4000;i++){ const float a=6.2831853f*i/4000.0f; spawnBullet(cx, cy, std::cos(a)*BULLET_SPD, std::sin(a)*BULLET_SPD, BULLET_TTL, 0); }
+  for(int i=0;i<4000 && nenemies>0;i++){ const int e=(int)(frand()*nenemies)%nenemies; const float x=ex[e]+ENEMY_W*0.5f, y=ey[e], dx=cx-x, dy=cy-y, d=std::max(1e-4f,std::sqrt(dx*dx+dy*dy));
+    spawnBullet(x, y, dx/d*ENEMY_SHOT_SPD, dy/d*ENEMY_SHOT_SPD, ENEMY_SHOT_TTL, 1); }
+  sortEnemies(0, nenemies);
 }
 
+void setBroadphase(bool on){ broadphase=on; }
+bool getBroadphase(){ return broadphase; }
+double getTileTests(){ return (double)tileTests; }
+float getLevelWidth(){ return levelW; }
+int getTileCount(){ return streamed? levelTiles : gridTiles+(int)tiles.size(); }
+int getBulletCount(){ return nbullets; }
+int getMaxBullets(){ return MAXB; }
+int getEnemyCount(){ return nenemies; }
+int getKills(){ return kills; }
+int getPlayerHits(){ return playerHits; }
+double getPairTests(){ return (double)pairTests; }
+
+#ifdef __EMSCRIPTEN__
 // getters
 val getPlayer(){ static float p[4]; p[0]=player.x; p[1]=player.y; p[2]=player.w; p[3]=player.h; return val(typed_memory_view(4,p)); }
-val getTiles(){ static std::vector<float> buf; buf.resize(tiles.size()*4); for(size_t i=0;i<tiles.size();++i){ buf[i*4]=tiles[i].x; buf[i*4+1]=tiles[i].y; buf[i*4+2]=tiles[i].w; buf[i*4+3]=tiles[i].h; } return val(typed_memory_view(buf.size(), buf.data())); }
-val getBullets(){ static std::vector<float> buf; buf.resize(bullets.size()*2); for(size_t i=0;i<bullets.size();++i){ buf[i*2]=bullets[i].x; buf[i*2+1]=bullets[i].y; } return val(typed_memory_view(buf.size(), buf.data())); }
+// tiles que tocan la ventana [x,x+w]x[y,y+h] (la cámara), sacados de los mismos índices que usa la física
+val getTilesIn(float x,float y,float w,float h){ static std::vector<float> buf; buf.clear(); const long long tests=tileTests; const bool bp=broadphase; broadphase=true; const Rect q{x,y,w,h};
+  forTiles(q, [&q](const Rect &t){ if(overlap(q,t)){ buf.push_back(t.x); buf.push_back(t.y); buf.push_back(t.w); buf.push_back(t.h); } return false; });
+  broadphase=bp; tileTests=tests; return val(typed_memory_view(buf.size(), buf.data())); }
+val getTiles(){ return getTilesIn(0,0,levelW,1); }
+// streamed: tiles de los chunks que entraron desde la última llamada, por chunk: id, n, n x (x,y,w,h)
+val getNewTiles(){ static std::vector<float> buf; buf.clear();
+  for(int k: freshChunks){ if(!resident(k)) continue; const Chunk &c=slots[k%SLOTS].c; buf.push_back((float)k); const size_t at=buf.size(); buf.push_back(0);
+    for(int i=0;i<CHUNK;i++) for(uint64_t m=c.col[i]; m; m&=m-1){ const int cy=__builtin_ctzll(m); buf.insert(buf.end(), { (k*CHUNK+i)*TILE, cy*TILE, TILE, TILE }); }
+    for(uint32_t i=0;i<c.nrects;i++) buf.insert(buf.end(), { c.rects[i].x, c.rects[i].y, c.rects[i].w, c.rects[i].h });
+    buf[at]=(float)((buf.size()-at-1)/4); }
+  freshChunks.clear(); return val(typed_memory_view(buf.size(), buf.data())); }
+val getDroppedChunks(){ static std::vector<int> buf; buf.swap(droppedChunks); droppedChunks.clear(); return val(typed_memory_view(buf.size(), buf.data())); }
+val levelHeaderView(){ return val(typed_memory_view(PLV_HEADER, levelHeaderBytes())); }
+val chunkView(int k){ return val(typed_memory_view(sizeof(Chunk), chunkSlot(k))); } // desaloja el slot: copiar y llamar chunkLoaded(k)
+int getChunkBytes(){ return (int)sizeof(Chunk); }
+// balas: x, y, equipo (0 jugador, 1 enemigo); enemigos: x, y (rect de ENEMY_W x ENEMY_H)
+val getBullets(){ static std::vector<float> buf(MAXB*3); for(int i=0;i<nbullets;i++){ buf[i*3]=bx[i]; buf[i*3+1]=by[i]; buf[i*3+2]=bteam[i]; } return val(typed_memory_view(nbullets*3, buf.data())); }
+val getEnemies(){ static std::vector<float> buf(MAXE*2); for(int i=0;i<nenemies;i++){ buf[i*2]=ex[i]; buf[i*2+1]=ey[i]; } return val(typed_memory_view(nenemies*2, buf.data())); }
 int getScore(){ return score; }
 
-EMSCRIPTEN_BINDINGS(platformer){ function("reset", &reset); function("step", &step); function("input", &input); function("getPlayer", &getPlayer); function("getTiles", &getTiles); function("getBullets", &getBullets); function("getScore", &getScore); }
+EMSCRIPTEN_BINDINGS(platformer){ function("reset", &reset); function("step", &step); function("input", &input); function("getPlayer", &getPlayer); function("getTiles", &getTiles); function("getTilesIn", &getTilesIn); function("getBullets", &getBullets); function("getScore", &getScore); function("genLevel", &genLevel); function("setCell", &setCell); function("addRect", &addRect); function("setBroadphase", &setBroadphase); function("getBroadphase", &getBroadphase); function("getTileTests", &getTileTests); function("getLevelWidth", &getLevelWidth); function("getTileCount", &getTileCount); function("getNewTiles", &getNewTiles); function("getDroppedChunks", &getDroppedChunks); function("levelHeaderView", &levelHeaderView); function("levelOpen", &levelOpen); function("nextWantedChunk", &nextWantedChunk); function("chunkView", &chunkView); function("chunkLoaded", &chunkLoaded); function("getChunkBytes", &getChunkBytes); function("getChunkLoads", &getChunkLoads); function("getResidentBytes", &getResidentBytes); function("isStreamed", &isStreamed); function("stress", &stress); function("getEnemies", &getEnemies); function("getBulletCount", &getBulletCount); function("getMaxBullets", &getMaxBullets); function("getEnemyCount", &getEnemyCount); function("getKills", &getKills); function("getPlayerHits", &getPlayerHits); function("getPairTests", &getPairTests); }
+#endif
+
+#if defined(PLATFORMER_BENCH) || defined(PLATFORMER_LEVELTOOL)
+// Nivel en JSON (fuente editable) <-> nivel en memoria; sólo en nativo, el juego carga el .plv.
+//   {"version":1, "cols":C, "grid":[ROWS strings de C caracteres, '#' sólido], "rects":[[x,y,w,h], ...]}
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+
+static std::string levelJson(){
+  std::string s="{\"version\":1,\"cols\":"+std::to_string(cols)+",\"grid\":[\n";
+  for(int cy=0;cy<ROWS;cy++){ s+='"'; for(int cx=0;cx<cols;cx++) s+= solid[(size_t)cy*cols+cx]? '#' : '.'; s+= cy+1<ROWS? "\",\n" : "\"\n"; }
+  s+="],\"rects\":[";
+  char b[96]; for(size_t i=0;i<tiles.size();i++){ const Rect &t=tiles[i]; std::snprintf(b,sizeof(b),"%s[%.9g,%.9g,%.9g,%.9g]", i? "," : "", t.x,t.y,t.w,t.h); s+=b; }
+  return s+"]}\n";
+}
+
+// lector mínimo: sólo lo que usa el formato (objetos, arrays, strings sin escapes raros, números)
+struct JsonIn{ const char *p, *e; bool ok=true;
+  void ws(){ while(p<e && (*p==' '||*p=='\n'||*p=='\r'||*p=='\t')) p++; }
+  bool eat(char c){ ws(); if(p<e && *p==c){ p++; return true; } return false; }
+  std::string str(){ std::string s; if(!eat('"')){ ok=false; return s; } while(p<e && *p!='"'){ if(*p=='\\' && p+1<e) p++; s+=*p++; } if(p<e) p++; else ok=false; return s; }
+  double num(){ ws(); char *end; const double v=std::strtod(p,&end); if(end==p) ok=false; p=end; return v; }
+  void skip(){ ws(); if(p>=e){ ok=false; return; }
+    if(*p=='"'){ str(); return; }
+    if(*p=='{' || *p=='['){ const char close= *p=='{'? '}' : ']'; p++; if(eat(close)) return;
+      do{ if(close=='}'){ str(); if(!eat(':')) ok=false; } skip(); } while(ok && eat(','));
+      if(!eat(close)) ok=false;
+      return; }
+    if(*p=='t' || *p=='f' || *p=='n'){ while(p<e && *p>='a' && *p<='z') p++; return; }
+    num(); }
+};
+static bool parseLevelJson(const std::string &txt){
+  JsonIn J{txt.c_str(), txt.c_str()+txt.size()}; int c=-1; std::vector<std::string> grid; std::vector<Rect> rects;
+  if(!J.eat('{')) return false;
+  if(!J.eat('}')){ do{ const std::string k=J.str(); if(!J.eat(':')) return false;
+      if(k=="cols") c=(int)J.num();
+      else if(k=="grid"){ if(!J.eat('[')) return false; if(!J.eat(']')){ do grid.push_back(J.str()); while(J.ok && J.eat(',')); if(!J.eat(']')) return false; } }
+      else if(k=="rects"){ if(!J.eat('[')) return false;
+        if(!J.eat(']')){ do{ Rect r; if(!J.eat('[')) return false; r.x=(float)J.num(); J.eat(','); r.y=(float)J.num(); J.eat(','); r.w=(float)J.num(); J.eat(','); r.h=(float)J.num(); if(!J.eat(']')) return false; rects.push_back(r); } while(J.ok && J.eat(','));
+          if(!J.eat(']')) return false; } }
+      else J.skip();
+    } while(J.ok && J.eat(','));
+    if(!J.eat('}')) return false; }
+  if(!J.ok || c<=0 || (int)grid.size()!=ROWS) return false;
+  for(const auto &row: grid) if((int)row.size()!=c) return false;
+  clearLevel(c); for(int cy=0;cy<ROWS;cy++) for(int cx=0;cx<c;cx++) if(grid[cy][cx]=='#') setCell(cx,cy,true);
+  for(const Rect &r: rects) addRect(r.x,r.y,r.w,r.h);
+  buildTree(); return true;
+}
+// abrir un .plv que está entero en memoria y servirle los chunks que pida, como hace app.js con el ArrayBuffer
+static bool openBytes(const std::vector<uint8_t> &f){ if(f.size()<(size_t)PLV_HEADER) return false; std::memcpy(levelHeaderBytes(), f.data(), PLV_HEADER); return levelOpen()==0 && f.size()>=PLV_HEADER+(size_t)levelHdr.chunks*sizeof(Chunk); }
+static void serveChunks(const std::vector<uint8_t> &f){ for(int k; (k=nextWantedChunk())>=0; ){ std::memcpy(chunkSlot(k), f.data()+PLV_HEADER+(size_t)k*sizeof(Chunk), sizeof(Chunk)); chunkLoaded(k); } }
+#endif
+
+#ifdef PLATFORMER_LEVELTOOL
+// Conversor offline (./build.sh native -> platformer-level):
+//   platformer-level nivel.json nivel.plv         JSON -> binario por chunks
+//   platformer-level --gen N semilla nivel.json   nivel procedural de ~N tiles en JSON (para probar)
+static bool readFile(const char *path, std::string &out){ FILE *f=std::fopen(path,"rb"); if(!f) return false; char b[65536]; size_t n; out.clear(); while((n=std::fread(b,1,sizeof(b),f))>0) out.append(b,n); std::fclose(f); return true; }
+static bool writeFile(const char *path, const void *data, size_t n){ FILE *f=std::fopen(path,"wb"); if(!f) return false; const bool ok=std::fwrite(data,1,n,f)==n; return std::fclose(f)==0 && ok; }
+int main(int argc,char **argv){
+  if(argc==5 && std::string(argv[1])=="--gen"){ genLevel(std::atoi(argv[2]), std::atoi(argv[3])); const std::string j=levelJson();
+    if(!writeFile(argv[4], j.data(), j.size())){ std::fprintf(stderr,"no se pudo escribir %s\n", argv[4]); return 1; }
+    std::printf("%s: %d tiles, %d columnas, %zu bytes\n", argv[4], getTileCount(), cols, j.size()); return 0; }
+  if(argc!=3){ std::fprintf(stderr,"uso: %s nivel.json nivel.plv | %s --gen N semilla nivel.json\n", argv[0], argv[0]); return 2; }
+  std::string txt; if(!readFile(argv[1], txt)){ std::fprintf(stderr,"no se pudo leer %s\n", argv[1]); return 1; }
+  if(!parseLevelJson(txt)){ std::fprintf(stderr,"%s: JSON de nivel inválido\n", argv[1]); return 1; }
+  std::vector<uint8_t> out; if(!writeLevel(out)){ std::fprintf(stderr,"%s: más de %d rects en un chunk\n", argv[1], CHUNK_RECTS); return 1; }
+  if(!openBytes(out)){ std::fprintf(stderr,"%s: el .plv generado no abre\n", argv[1]); return 1; }
+  serveChunks(out);
+  if(!writeFile(argv[2], out.data(), out.size())){ std::fprintf(stderr,"no se pudo escribir %s\n", argv[2]); return 1; }
+  LevelHeader h; std::memcpy(&h, out.data(), PLV_HEADER);
+  std::printf("%s: %u tiles, %u chunks de %zu bytes, %zu bytes (JSON %zu)\n", argv[2], h.tiles, h.chunks, sizeof(Chunk), out.size(), txt.size());
+  return 0;
+}
+#endif
+
+#ifdef PLATFORMER_BENCH
+// Benchmark nativo (./build.sh native): niveles procedurales de 1K a 1M tiles con un jugador scripteado
+// (corre a la derecha, salta y dispara). El costo por step con la grilla + árbol no depende del tamaño del
+// nivel; el recorrido lineal de antes crece con él. Después, los mismos niveles por chunks (.plv), y al final
+// stress(): miles de balas y enemigos en los pools.
+#include <chrono>
+#include <cstdio>
+
+static double msSince(std::chrono::steady_clock::time_point t){ return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now()-t).count(); }
+
+int main(){
+  for(int n : {1000, 10000, 100000, 1000000}){
+    // mismo recorrido corto con los dos caminos: el jugador tiene que terminar en el mismo lugar
+    const int check=std::max(60, 20000000/(n*20)); float pos[2][2]; double us[2], tests[2];
+    for(int bp=0; bp<2; bp++){
+      genLevel(n, 7); setBroadphase(bp); tests[bp]=0;
+      auto t0=std::chrono::steady_clock::now();
+      for(int f=0;f<check;f++){ input(false, true, f%20==0, f%3==0); step(1.0f/60.0f); tests[bp]+=tileTests; }
+      us[bp]=msSince(t0)*1000.0/check; tests[bp]/=check; pos[bp][0]=player.x; pos[bp][1]=player.y;
+    }
+    // con índices, además, un recorrido largo (60 s de juego)
+    genLevel(n, 7); setBroadphase(true); const int frames=3600; double longTests=0;
+    auto t0=std::chrono::steady_clock::now();
+    for(int f=0;f<frames;f++){ input(false, true, f%20==0, f%3==0); step(1.0f/60.0f); longTests+=tileTests; }
+    const double longUs=msSince(t0)*1000.0/frames;
+    std::printf("tiles %7d  ancho %6.0f  lineal %9.0f tests %9.2f us/step  índices %3.0f tests %5.2f us/step (%d steps: %5.2f us, %3.0f tests, x=%.2f)  %s\n",
+                getTileCount(), levelW, tests[0], us[0], tests[1], us[1], frames, longUs, longTests/frames, player.x,
+                pos[0][0]==pos[1][0] && pos[0][1]==pos[1][1]? "mismo recorrido" : "RECORRIDO DISTINTO");
+  }
+
+  // .plv: el mismo nivel cargado entero desde JSON vs abierto por chunks (60 s de juego sirviendo los chunks
+  // que pide, como app.js). Arranque y memoria del nivel por chunks no crecen con el nivel.
+  for(int n : {10000, 100000, 1000000}){
+    genLevel(n, 7); const std::string json=levelJson(); std::vector<uint8_t> plv;
+    auto t0=std::chrono::steady_clock::now(); parseLevelJson(json); const double jsonMs=msSince(t0); const int jsonBytes=getResidentBytes();
+    if(!writeLevel(plv)){ std::printf("writeLevel falló\n"); return 1; }
+    float pos[2][2]; double us[2]; int loads=0, bytes=0; double openMs=0;
+    for(int st=0; st<2; st++){
+      if(st){ openBytes(plv); // la primera apertura libera el nivel en memoria: no es parte del arranque
+        t0=std::chrono::steady_clock::now(); if(!openBytes(plv)){ std::printf("openBytes falló\n"); return 1; } serveChunks(plv); openMs=msSince(t0); }
+      else { parseLevelJson(json); player=Player(); }
+      t0=std::chrono::steady_clock::now();
+      for(int f=0;f<3600;f++){ if(st) serveChunks(plv); input(false, true, f%20==0, f%3==0); step(1.0f/60.0f); }
+      us[st]=msSince(t0)*1000.0/3600; pos[st][0]=player.x; pos[st][1]=player.y;
+      if(st){ loads=chunkLoads; bytes=getResidentBytes(); }
+    }
+    std::printf("tiles %7d  JSON %8zu B -> .plv %8zu B  |  JSON: carga %7.2f ms, %8d B, %.2f us/step  |  chunks: arranque %.3f ms, %5d B, %.2f us/step, %d cargas  %s\n",
+                getTileCount(), json.size(), plv.size(), jsonMs, jsonBytes, us[0], openMs, bytes, us[1], loads,
+                pos[0][0]==pos[1][0] && pos[0][1]==pos[1][1]? "mismo recorrido" : "RECORRIDO DISTINTO");
+  }
+
+  // stress(): 2000 enemigos + 8000 balas con el jugador disparando y saltando. En el nivel chico, grilla de
+  // enemigos + franjas de tiles vs lineal (cada bala contra todos los tiles y enemigos, sin ventana de tiles);
+  // en uno de 100K tiles sólo con índices. Tienen que dar lo mismo y los pools no se realocan.
+  for(int big=0; big<2; big++){ int res[2][3]={};
+    for(int bp= big? 1 : 0; bp<2; bp++){
+      if(big) genLevel(100000, 7); else reset(); setBroadphase(bp); stress();
+      const float *p0=bx.data(), *e0=ex.data(); const int frames= bp? 600 : 120; double alive=0, pairs=0, tests=0;
+      auto t0=std::chrono::steady_clock::now();
+      for(int f=0;f<frames;f++){ input(false, false, f%30==0, true); step(1.0f/60.0f); alive+=nbullets; pairs+=pairTests; tests+=tileTests;
+        if(f==119){ res[bp][0]=kills; res[bp][1]=playerHits; res[bp][2]=nbullets; } }
+      const double us=msSince(t0)*1000.0/frames;
+      std::printf("%s %-7s %3d steps %5.0f balas (máx %d) %4d enemigos  %8.1f us/step  %9.0f tests bala-enemigo  %8.0f tests de tiles  bajas %4d  impactos %4d  realocaciones: %s\n",
+                  big? "nivel 100K" : "nivel chico", bp? "índices" : "lineal", frames, alive/frames, MAXB, nenemies, us, pairs/frames, tests/frames, kills, playerHits,
+                  (p0==bx.data() && e0==ex.data())? "ninguna" : "SI");
+    }
+    if(!big) std::printf("  (120 steps) lineal vs índices: %s\n", res[0][0]==res[1][0] && res[0][1]==res[1][1] && res[0][2]==res[1][2]? "mismas bajas, impactos y balas vivas" : "RESULTADOS DISTINTOS");
+  }
+  return 0;
+}
+#endif
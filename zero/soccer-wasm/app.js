@@ -19,13 +19,23 @@ class GL{ constructor(c){ this.c=c; this.g=c.getContext('webgl'); const g=this.g
 class Game{ constructor(){ this.cv=document.getElementById('canvas'); this.gl=new GL(this.cv); this.fps=0; this.last=performance.now(); this.keys={}; this.loop=this.loop.bind(this); this.init(); }
  async init(){ this.mod=await this.loadWASM(); this.mod.reset(); this.gl.resize(); addEventListener('resize',()=>this.gl.resize()); this.bindInput(); requestAnimationFrame(this.loop); }
  loadWASM(){ return new Promise((resolve,reject)=>{ const s=document.createElement('script'); s.src='physics.js'; s.onload=async()=>{ try{ if(typeof Module==='function'){ const m=await Module({}); resolve(m);} else if(typeof Module==='object'){ Module.onRuntimeInitialized=()=>resolve(Module);} else reject(new Error('Module not found')); } catch(e){reject(e);} }; s.onerror=reject; document.body.appendChild(s); }); }
- bindInput(){ addEventListener('keydown',(e)=>{ this.keys[e.code]=true; if(['ArrowUp','ArrowDown','ArrowLeft','ArrowRight'].includes(e.code)) e.preventDefault(); if(e.code==='KeyR'){ this.mod.reset(); } }); addEventListener('keyup',(e)=>{ this.keys[e.code]=false; }); }
+ bindInput(){ addEventListener('keydown',(e)=>{ this.keys[e.code]=true; if(['ArrowUp','ArrowDown','ArrowLeft','ArrowRight'].includes(e.code)) e.preventDefault(); if(e.code==='KeyR'){ this.mod.reset(); if(this.net) this.mod.netStart(0,this.netLat,2,1); } if(e.code==='KeyN'){ this.toggleNet(); } if(e.code==='KeyC'){ this.mod.setSweep(this.mod.getSweep()?0:1); } if(e.code==='KeyI'){ this.mod.setAiMode(this.mod.getAiMode()?0:1); } if(e.code==='BracketLeft'||e.code==='BracketRight'){ this.mod.setAiBudget(Math.min(4, Math.max(0, this.mod.getAiBudget()+(e.code==='BracketRight'?0.25:-0.25)))); } }); addEventListener('keyup',(e)=>{ this.keys[e.code]=false; }); }
+ // N: rollback por loopback. P2 (flechas) viaja por un cable con latencia y jitter; P1 predice y resimula.
+ // I: P2 la maneja la IA por rollouts ([ y ] cambian su presupuesto en ms por frame); sin I, la IA simple de step().
+ toggleNet(){ this.net=!this.net; this.netLat=6; this.acc=0; if(this.net) this.mod.netStart(0,this.netLat,2,1); else this.mod.netStop(); }
  loop(){ const now=performance.now(); const dt=(now-this.last)/1000; this.last=now;
   const up=!!(this.keys['KeyW']); const down=!!(this.keys['KeyS']); const left=!!(this.keys['KeyA']); const right=!!(this.keys['KeyD']); const kick=!!(this.keys['KeyJ']);
   const up2=!!(this.keys['ArrowUp']); const down2=!!(this.keys['ArrowDown']); const left2=!!(this.keys['ArrowLeft']); const right2=!!(this.keys['ArrowRight']); const kick2=!!(this.keys['Slash']);
-  this.mod.input(0,up,down,left,right,kick);
-  this.mod.input(1,up2,down2,left2,right2,kick2);
-  const t0=performance.now(); this.mod.step(dt); const stepMs=performance.now()-t0;
+  const ai=this.mod.getAiMode()!==0; let stepMs=0, aiMs=0;
+  if(this.net){ // frames fijos de 1/60 (máx 4 por render)
+   const bits=(u,d,l,r,k)=>(u?1:0)|(d?2:0)|(l?4:0)|(r?8:0)|(k?16:0); this.acc=Math.min(this.acc+dt, 4/60);
+   const t0=performance.now(); while(this.acc>=1/60){ const t1=performance.now(); const p2=ai? this.mod.aiThink() : bits(up2,down2,left2,right2,kick2); aiMs+=performance.now()-t1; this.mod.netTick(bits(up,down,left,right,kick), p2); this.acc-=1/60; } stepMs=performance.now()-t0-aiMs;
+  } else {
+   this.mod.input(0,up,down,left,right,kick);
+   if(ai){ const t1=performance.now(); const b=this.mod.aiThink(); aiMs=performance.now()-t1; this.mod.input(1,!!(b&1),!!(b&2),!!(b&4),!!(b&8),!!(b&16)); }
+   else this.mod.input(1,up2,down2,left2,right2,kick2);
+   const t0=performance.now(); this.mod.step(dt); stepMs=performance.now()-t0;
+  }
   const ps=this.mod.getPlayers(); const ball=this.mod.getBall(); const sA=this.mod.getScoreA(); const sB=this.mod.getScoreB(); const tm=this.mod.getTime(); const ko=this.mod.getKickoff(); const win=this.mod.getWinner();
   // build draw buffers
   const n=ps.length/4 + 1; const pts=new Float32Array(n*2); const sizes=new Float32Array(n); const cols=new Float32Array(n*3);
@@ -43,9 +53,9 @@ class Game{ constructor(){ this.cv=document.getElementById('canvas'); this.gl=ne
     document.title = `Air Hockey WASM`;
   }
   // HUD
-  this.updateHUD(stepMs, sA, sB, tm);
+  this.updateHUD(stepMs, sA, sB, tm, aiMs);
   requestAnimationFrame(this.loop); }
- updateHUD(stepMs,sA,sB,tm){ const fpsEl=document.getElementById('fps'); const timeEl=document.getElementById('time'); const scEl=document.getElementById('score'); this._frames=(this._frames||0)+1; if(this._frames%30===0){ const now=performance.now(); const d=now-(this._lastFps||now); this._fps=Math.round(30000/d); this._lastFps=now; fpsEl.textContent=this._fps; } timeEl.textContent=tm.toFixed(1); scEl.textContent=`${sA} - ${sB}`; }
+ updateHUD(stepMs,sA,sB,tm,aiMs){ const fpsEl=document.getElementById('fps'); const timeEl=document.getElementById('time'); const scEl=document.getElementById('score'); this._frames=(this._frames||0)+1; if(this._frames%30===0){ const now=performance.now(); const d=now-(this._lastFps||now); this._fps=Math.round(30000/d); this._lastFps=now; fpsEl.textContent=this._fps; } timeEl.textContent=tm.toFixed(1); const netEl=document.getElementById('net'); if(netEl){ if(this.net){ const n=this.mod.getNetStats(); netEl.textContent=`${this.netLat}±2 frames · rollbacks ${n[1]} · resim ${n[3]} (máx ${n[4]}) · frenadas ${n[5]} · ${stepMs.toFixed(2)} ms`; } else netEl.textContent='off'; } const swEl=document.getElementById('sweep'); if(swEl) swEl.textContent=this.mod.getSweep()? 'on' : 'off'; const aiEl=document.getElementById('ai'); if(aiEl){ aiEl.textContent= this.mod.getAiMode()? `rollouts ${this.mod.getAiRollouts()}/frame · presupuesto ${this.mod.getAiBudget().toFixed(2)} ms · ${aiMs.toFixed(2)} ms` : 'simple'; } scEl.textContent=`${sA} - ${sB}`; }
 }
 
 document.addEventListener('DOMContentLoaded',()=>new Game());
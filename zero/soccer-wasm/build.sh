@@ -1,10 +1,24 @@
 #!/bin/bash
 set -euo pipefail
 
+# ./build.sh          -> physics.js (WASM)
+# ./build.sh native   -> soccer-bench (rollback: resimulación bit a bit y costo por frame; IA: rollouts por ms;
+#                        barrido: tiros rápidos que atraviesan paletas o deciden mal el gol, con y sin barrido)
+# -fno-math-errno/-fno-trapping-math dejan vectorizar el kernel de rollouts (sqrt y selects sin ramas)
+MODE="${1:-wasm}"
+
+if [ "$MODE" = "native" ]; then
+  echo "🔨 Compilando benchmark nativo (Air Hockey)..."
+  ${CXX:-c++} physics.cpp -O3 -std=c++17 -fno-math-errno -fno-trapping-math -DSOCCER_BENCH -o soccer-bench
+  echo "✅ Compilación OK → ./soccer-bench"
+  exit 0
+fi
+
 echo "🔨 Compilando Soccer WASM ..."
 
 emcc physics.cpp \
   -O3 \
+  -msimd128 -fno-math-errno \
   --bind \
   -s WASM=1 \
   -s MODULARIZE=1 \
@@ -1,9 +1,14 @@
+#ifdef __EMSCRIPTEN__
 #include <emscripten/bind.h>
+using namespace emscripten;
+#endif
 #include <vector>
 #include <cmath>
 #include <cstdint>
+#include <cstdlib>
+#include <cstring>
 #include <algorithm>
-using namespace emscripten;
+#include <chrono>
 
 static inline float clamp(float v,float a,float b){ return v<a?a:(v>b?b:v); }
 static inline float rnd(){ return (float)rand()/(float)RAND_MAX; }
@@ -19,13 +24,15 @@ static inline Vec norm(const Vec&a){ float L=len(a); return L>1e-6f? mul(a,1.0f/
 // Campo normalizado [0,1]x[0,1]
 // Air hockey: 2 paletas (team 0/1) y 1 puck (team 2)
 struct Circle{ Vec p,v; float r; uint8_t team; };
-static Circle puck; static std::vector<Circle> paddles; static int scoreA=0, scoreB=0; static float timeLeft=90.0f;
-static int maxGoals=5; static bool gameOver=false; static int winner=-1; static float kickoff=0.0f; // congelar tras gol
+// Todo el estado del partido en un POD de tamaño fijo: se copia entero para snapshots/rollback
+static const int NPAD=2;
+struct Match{ Circle puck; Circle paddles[NPAD]; int scoreA, scoreB; float timeLeft; int maxGoals; bool gameOver; int winner; float kickoff; /* congelar tras gol */ };
+static Match S;
 
-void reset(){ paddles.clear(); scoreA=0; scoreB=0; timeLeft=90.0f; gameOver=false; winner=-1; kickoff=0.0f; puck={ {0.5f,0.5f}, {0,0}, 0.04f, 2 };
+void reset(){ std::memset(&S, 0, sizeof(S)); S.timeLeft=90.0f; S.maxGoals=5; S.gameOver=false; S.winner=-1; S.kickoff=0.0f; S.puck={ {0.5f,0.5f}, {0,0}, 0.04f, 2 };
   // 1 vs 1 paletas (más grandes)
-  paddles.push_back({ {0.15f,0.5f}, {0,0}, 0.08f, 0 });
-  paddles.push_back({ {0.85f,0.5f}, {0,0}, 0.08f, 1 });
+  S.paddles[0]={ {0.15f,0.5f}, {0,0}, 0.08f, 0 };
+  S.paddles[1]={ {0.85f,0.5f}, {0,0}, 0.08f, 1 };
 }
 
 static const float MAX_PADDLE_SPEED=3.0f; static const float MAX_PUCK_SPEED=4.5f;
@@ -36,45 +43,367 @@ static void integrate(Circle &c,float dt){ c.p.x+=c.v.x*dt; c.p.y+=c.v.y*dt; c.v
 static void resolve(Circle &a,Circle &b){ Vec d=sub(b.p,a.p); float L=len(d); float minDist=a.r+b.r; if(L<minDist && L>1e-6f){ Vec n=mul(d,1.0f/L); float pen=minDist-L; a.p = add(a.p, mul(n, -pen*0.5f)); b.p = add(b.p, mul(n,  pen*0.5f)); float rel=dot(sub(b.v,a.v),n); if(rel<0){ float e=0.75f; float j=-(1.0f+e)*rel*0.5f; a.v=add(a.v, mul(n,-j)); b.v=add(b.v, mul(n, j)); // clamp and light friction
       clampSpeed(a); clampSpeed(b); a.v=mul(a.v,0.995f); b.v=mul(b.v,0.995f); } } }
 
-void input(int idx,bool up,bool down,bool left,bool right,bool kick){ if(gameOver||kickoff>0.0f) return; Circle &p=paddles[idx]; float sp=1.2f; if(up) p.v.y+=sp*(1.0f/60.0f); if(down) p.v.y-=sp*(1.0f/60.0f); if(left) p.v.x-=sp*(1.0f/60.0f); if(right) p.v.x+=sp*(1.0f/60.0f);
+// Barrido continuo del puck
+// A MAX_PUCK_SPEED el puck avanza ~0.075 por frame (casi su diámetro) y resolve() sólo mira el solapamiento al
+// final del paso: los tiros atraviesan paletas y la línea de gol se decide con la posición final. Si el
+// desplazamiento del frame pasa SWEEP_MIN radios, el puck va de impacto en impacto dentro del frame (tiempo de
+// impacto contra paredes, línea de gol y paletas en movimiento relativo); lento sigue con integrate() de siempre.
+// Así un frame es un solo step() y no hacen falta sub-pasos globales.
+static const float SWEEP_MIN=0.5f; static const int SWEEP_MAX_HITS=4;
+static bool sweepOn=true;
+static inline bool inMouth(float y){ return y>0.4f && y<0.6f; }
+// primer s en [0,tmax] con |d + w*s| == R acercándose; 0 si ya se solapan, -1 si no se tocan
+static float toiCircle(Vec d,Vec w,float R,float tmax){ const float a=dot(w,w), b=dot(d,w), c=dot(d,d)-R*R; if(b>=0.0f || a<1e-12f) return -1.0f; if(c<=0.0f) return 0.0f; const float disc=b*b-a*c; if(disc<0.0f) return -1.0f; const float s=(-b-std::sqrt(disc))/a; return s<=tmax? s : -1.0f; }
+
+// integrate() del puck lento; devuelve el arco que cruzó (0: izquierdo, 1: derecho) o -1, antes de que la pared lo frene
+static int integratePuck(float dt){ Circle &c=S.puck; c.p.x+=c.v.x*dt; c.p.y+=c.v.y*dt; c.v=mul(c.v,0.995f); clampSpeed(c);
+  const int side= !inMouth(c.p.y)? -1 : (c.p.x<c.r? 0 : (c.p.x>1.0f-c.r? 1 : -1)); collideWalls(c); return side; }
+
+// Puck rápido: from/vel son posición inicial y velocidad efectiva de cada paleta en este frame (ya integradas).
+// Mismo resultado que integratePuck(): arco cruzado o -1.
+static int sweepPuck(float dt,const Vec *from,const Vec *vel){
+  Circle &c=S.puck; const float r=c.r; const bool pads= S.kickoff<=0.0f, goals= pads && !S.gameOver; float t=0.0f; int side=-1;
+  for(int hit=0; hit<=SWEEP_MAX_HITS && t<dt; hit++){
+    const float rem=dt-t; float s=rem; int what=-1; // 0..3: paredes x=0, x=1, y=0, y=1; 4+i: paleta i
+    auto take=[&](float ts,int w){ if(ts>=0.0f && ts<s){ s=ts; what=w; } };
+    if(c.v.x<0.0f && c.p.x+c.v.x*rem<r) take(std::max(0.0f,(r-c.p.x)/c.v.x), 0);
+    if(c.v.x>0.0f && c.p.x+c.v.x*rem>1.0f-r) take(std::max(0.0f,(1.0f-r-c.p.x)/c.v.x), 1);
+    if(c.v.y<0.0f && c.p.y+c.v.y*rem<r) take(std::max(0.0f,(r-c.p.y)/c.v.y), 2);
+    if(c.v.y>0.0f && c.p.y+c.v.y*rem>1.0f-r) take(std::max(0.0f,(1.0f-r-c.p.y)/c.v.y), 3);
+    if(pads) for(int i=0;i<NPAD;i++) take(toiCircle(sub(c.p, add(from[i], mul(vel[i],t))), sub(c.v, vel[i]), r+S.paddles[i].r, rem), 4+i);
+    c.p=add(c.p, mul(c.v,s)); t+=s;
+    if(what<0) break;
+    if(what<2){ if(goals && inMouth(c.p.y)){ side=what; c.p.x+=c.v.x*(dt-t); break; } // la línea de gol no frena: sigue de largo
+      c.p.x= what==0? r : 1.0f-r; c.v.x*=-0.94f; }
+    else if(what<4){ c.p.y= what==2? r : 1.0f-r; c.v.y*=-0.94f; }
+    else { Circle &P=S.paddles[what-4]; const Vec n=norm(sub(c.p, add(from[what-4], mul(vel[what-4],t)))); const float rel=dot(sub(c.v,P.v),n);
+      if(rel<0.0f){ const float j=-(1.0f+0.75f)*rel*0.5f; P.v=add(P.v, mul(n,-j)); c.v=add(c.v, mul(n,j)); clampSpeed(P); clampSpeed(c); P.v=mul(P.v,0.995f); c.v=mul(c.v,0.995f); } }
+  }
+  c.v=mul(c.v,0.995f); clampSpeed(c); collideWalls(c);
+  return side;
+}
+void setSweep(int on){ sweepOn= on!=0; }
+int getSweep(){ return sweepOn? 1 : 0; }
+
+void input(int idx,bool up,bool down,bool left,bool right,bool kick){ if(S.gameOver||S.kickoff>0.0f) return; Circle &p=S.paddles[idx]; float sp=1.2f; if(up) p.v.y+=sp*(1.0f/60.0f); if(down) p.v.y-=sp*(1.0f/60.0f); if(left) p.v.x-=sp*(1.0f/60.0f); if(right) p.v.x+=sp*(1.0f/60.0f);
   // boost al golpear el puck (controlado)
-  if(kick){ Vec d=sub(puck.p,p.p); if(len(d)<p.r+puck.r+0.02f){ Vec n=norm(d); // componente hacia puck + influencia de velocidad de paleta
-      puck.v = add(puck.v, add(mul(n,5.0f), mul(p.v,0.6f))); clampSpeed(puck); }
+  if(kick){ Vec d=sub(S.puck.p,p.p); if(len(d)<p.r+S.puck.r+0.02f){ Vec n=norm(d); // componente hacia puck + influencia de velocidad de paleta
+      S.puck.v = add(S.puck.v, add(mul(n,5.0f), mul(p.v,0.6f))); clampSpeed(S.puck); }
  }
 }
 
+static int aiMode=0; // 0: aiStep() dentro de step(); 1: la paleta 1 la maneja aiThink() como un input más
+
 static void aiStep(){ // la paleta derecha (idx 1) sigue el puck en Y
-  if(paddles.size()>1){ Vec d=sub(puck.p, paddles[1].p); float s = (d.y>0?1.0f:-1.0f); paddles[1].v.y += s*0.5f*(1.0f/60.0f); paddles[1].v.x += (puck.p.x>paddles[1].p.x? 0.1f: -0.1f)*(1.0f/60.0f); }
+  Vec d=sub(S.puck.p, S.paddles[1].p); float s = (d.y>0?1.0f:-1.0f); S.paddles[1].v.y += s*0.5f*(1.0f/60.0f); S.paddles[1].v.x += (S.puck.p.x>S.paddles[1].p.x? 0.1f: -0.1f)*(1.0f/60.0f);
 }
 
 void step(float dt){ // integrar
-  if(gameOver){ // animación mínima
-    for(auto &p:paddles) p.v = mul(p.v, 0.98f);
-    puck.v = mul(puck.v, 0.98f);
+  if(S.gameOver){ // animación mínima
+    for(auto &p:S.paddles) p.v = mul(p.v, 0.98f);
+    S.puck.v = mul(S.puck.v, 0.98f);
   }
-  if(kickoff>0.0f){ kickoff = std::max(0.0f, kickoff - dt); }
-  for(auto &p:paddles) integrate(p,dt); integrate(puck,dt);
+  if(S.kickoff>0.0f){ S.kickoff = std::max(0.0f, S.kickoff - dt); }
+  Vec from[NPAD], vel[NPAD]; for(int i=0;i<NPAD;++i) from[i]=S.paddles[i].p;
+  for(auto &p:S.paddles) integrate(p,dt);
+  for(int i=0;i<NPAD;++i) vel[i]=mul(sub(S.paddles[i].p, from[i]), dt>0.0f? 1.0f/dt : 0.0f);
+  const int crossed= (sweepOn && len(S.puck.v)*dt>SWEEP_MIN*S.puck.r)? sweepPuck(dt, from, vel) : integratePuck(dt);
   // colisiones entre paletas
-  for(size_t i=0;i<paddles.size();++i) for(size_t j=i+1;j<paddles.size();++j) resolve(paddles[i],paddles[j]);
+  for(int i=0;i<NPAD;++i) for(int j=i+1;j<NPAD;++j) resolve(S.paddles[i],S.paddles[j]);
   // colisiones paleta-puck
-  if(kickoff<=0.0f) for(auto &p:paddles) resolve(p, puck);
-  // goles (arcos en y=0.4..0.6 x=0 o x=1)
-  if(!gameOver && kickoff<=0.0f){
-    if(puck.p.x<puck.r && puck.p.y>0.4f && puck.p.y<0.6f){ scoreB++; puck={ {0.5f,0.5f},{0,0},0.04f,2 }; kickoff=1.2f; }
-    if(puck.p.x>1.0f-puck.r && puck.p.y>0.4f && puck.p.y<0.6f){ scoreA++; puck={ {0.5f,0.5f},{0,0},0.04f,2 }; kickoff=1.2f; }
+  if(S.kickoff<=0.0f) for(auto &p:S.paddles) resolve(p, S.puck);
+  // goles (arcos en y=0.4..0.6 x=0 o x=1): cruzó la línea en este paso o una paleta lo empujó contra la pared
+  if(!S.gameOver && S.kickoff<=0.0f){
+    if(crossed==0 || (S.puck.p.x<S.puck.r && inMouth(S.puck.p.y))){ S.scoreB++; S.puck={ {0.5f,0.5f},{0,0},0.04f,2 }; S.kickoff=1.2f; }
+    else if(crossed==1 || (S.puck.p.x>1.0f-S.puck.r && inMouth(S.puck.p.y))){ S.scoreA++; S.puck={ {0.5f,0.5f},{0,0},0.04f,2 }; S.kickoff=1.2f; }
   }
   // IA simple
-  if(!gameOver && kickoff<=0.0f) aiStep();
+  if(!S.gameOver && S.kickoff<=0.0f && aiMode==0) aiStep();
   // tiempo y fin de juego
-  if(!gameOver){ timeLeft = std::max(0.0f, timeLeft - dt); if(timeLeft<=0.0f || scoreA>=maxGoals || scoreB>=maxGoals){ gameOver=true; winner = (scoreA==scoreB? -1 : (scoreA>scoreB? 0:1)); } }
+  if(!S.gameOver){ S.timeLeft = std::max(0.0f, S.timeLeft - dt); if(S.timeLeft<=0.0f || S.scoreA>=S.maxGoals || S.scoreB>=S.maxGoals){ S.gameOver=true; S.winner = (S.scoreA==S.scoreB? -1 : (S.scoreA>S.scoreB? 0:1)); } }
+}
+
+// Rollback netcode
+// El partido avanza por frames de 1/60 con un input por jugador (bits INPUT_*). snapshot(f) guarda el Match
+// antes de simular el frame f en un ring prealocado; restore(f) lo devuelve. La sesión net predice el input
+// remoto (repite el último confirmado), y cuando llega el real y no coincide vuelve al primer frame errado y
+// resimula hasta el actual (como mucho MAX_ROLLBACK frames; si el remoto se atrasa más, el frame se frena).
+// El peer remoto es un loopback local: sus inputs viajan por un "cable" con latencia y jitter configurables.
+enum { INPUT_UP=1, INPUT_DOWN=2, INPUT_LEFT=4, INPUT_RIGHT=8, INPUT_KICK=16 };
+static const int RB_RING=64, MAX_ROLLBACK=10, FRAME_DT_DIV=60;
+
+static Match snaps[RB_RING];
+void snapshot(int frame){ std::memcpy(&snaps[frame%RB_RING], &S, sizeof(Match)); }
+void restore(int frame){ std::memcpy(&S, &snaps[frame%RB_RING], sizeof(Match)); }
+int getStateSize(){ return (int)sizeof(Match); }
+
+static inline void applyInput(int idx, uint8_t b){ input(idx, b&INPUT_UP, b&INPUT_DOWN, b&INPUT_LEFT, b&INPUT_RIGHT, b&INPUT_KICK); }
+static void simFrame(uint8_t in0, uint8_t in1){ applyInput(0,in0); applyInput(1,in1); step(1.0f/FRAME_DT_DIV); }
+
+// FNV-1a sobre los bits del estado campo por campo (sin el padding): detecta desync y compara resimulaciones
+static inline void fnv(uint32_t &h, const void *p, size_t n){ const uint8_t *b=(const uint8_t*)p; for(size_t i=0;i<n;i++){ h^=b[i]; h*=16777619u; } }
+static uint32_t hashMatch(const Match &m){ uint32_t h=2166136261u;
+  auto circle=[&](const Circle &c){ fnv(h,&c.p,sizeof(Vec)); fnv(h,&c.v,sizeof(Vec)); fnv(h,&c.r,4); fnv(h,&c.team,1); };
+  circle(m.puck); for(int i=0;i<NPAD;i++) circle(m.paddles[i]);
+  fnv(h,&m.scoreA,4); fnv(h,&m.scoreB,4); fnv(h,&m.timeLeft,4); fnv(h,&m.gameOver,1); fnv(h,&m.winner,4); fnv(h,&m.kickoff,4);
+  return h;
+}
+uint32_t checksum(){ return hashMatch(S); }
+
+struct NetPacket{ int frame, arrive; uint8_t bits; };
+static struct Net{
+  bool on=false; int local=0, frame=0, tick=0, sent=-1, latency=6, jitter=3; uint32_t rng=1;
+  uint8_t in[RB_RING][NPAD]; bool confirmed[RB_RING]; int lastConfirmed=-1; // todos los frames remotos <= lastConfirmed llegaron
+  std::vector<NetPacket> wire; // paquetes del peer en vuelo
+  int rollbacks=0, resimFrames=0, lastResim=0, maxResim=0, stalls=0;
+} net;
+
+static inline uint32_t netRand(){ uint32_t &s=net.rng; s^=s<<13; s^=s>>17; s^=s<<5; return s; }
+
+void netStart(int local, int latency, int jitter, int seed){
+  net=Net(); net.on=true; net.local=local&1; net.latency=std::max(0,latency); net.jitter=std::max(0,jitter); net.rng=seed? (uint32_t)seed : 1u;
+  net.wire.reserve(256); reset();
+}
+void netStop(){ net.on=false; }
+
+// Un tick de red/render: manda el input del peer remoto al cable, recibe lo que llegó, hace rollback si hace
+// falta y simula el frame actual. Devuelve false si el frame quedó frenado esperando al remoto.
+bool netTick(int localBits, int remoteBits){
+  if(!net.on) return false;
+  const int remote=1-net.local, R=RB_RING;
+  net.tick++;
+  // el peer remoto corre a la par nuestra: su input de este frame sale ahora y llega latency±jitter ticks después
+  if(net.sent<net.frame){ int j=net.jitter? (int)(netRand()%(2*net.jitter+1))-net.jitter : 0; net.wire.push_back({ net.frame, net.tick+std::max(0, net.latency+j), (uint8_t)remoteBits }); net.sent=net.frame; }
+  // recibir (el cable puede desordenar paquetes con jitter)
+  int rollbackFrom=net.frame;
+  for(size_t i=0;i<net.wire.size();){ const NetPacket pk=net.wire[i]; if(pk.arrive>net.tick){ ++i; continue; }
+    net.wire[i]=net.wire.back(); net.wire.pop_back();
+    const int f=pk.frame%R; net.confirmed[f]=true;
+    if(pk.frame<net.frame && net.in[f][remote]!=pk.bits) rollbackFrom=std::min(rollbackFrom, pk.frame);
+    net.in[f][remote]=pk.bits;
+  }
+  while(net.lastConfirmed<net.frame && net.confirmed[(net.lastConfirmed+1)%R]){ net.lastConfirmed++; net.confirmed[net.lastConfirmed%R]=false; }
+  // re-predecir los frames sin confirmar con el último input confirmado
+  const uint8_t guess= net.lastConfirmed>=0? net.in[net.lastConfirmed%R][remote] : 0;
+  for(int f=net.lastConfirmed+1; f<net.frame; f++){ if(net.confirmed[f%R]) continue; if(net.in[f%R][remote]!=guess){ net.in[f%R][remote]=guess; rollbackFrom=std::min(rollbackFrom,f); } }
+  // rollback + resimulación
+  net.lastResim=0;
+  if(rollbackFrom<net.frame){ restore(rollbackFrom); for(int f=rollbackFrom; f<net.frame; f++){ snapshot(f); simFrame(net.in[f%R][0], net.in[f%R][1]); } net.lastResim=net.frame-rollbackFrom; net.rollbacks++; net.resimFrames+=net.lastResim; net.maxResim=std::max(net.maxResim, net.lastResim); }
+  // el remoto está demasiado atrás: no avanzamos hasta que llegue
+  if(net.frame-net.lastConfirmed>MAX_ROLLBACK){ net.stalls++; return false; }
+  const int f=net.frame%R; net.in[f][net.local]=(uint8_t)localBits;
+  if(net.frame>net.lastConfirmed && !net.confirmed[f]) net.in[f][remote]=guess;
+  snapshot(net.frame); simFrame(net.in[f][0], net.in[f][1]); net.frame++;
+  return true;
+}
+
+// IA por rollouts
+// La paleta 1 elige su input simulando planes cortos: cada plan es "mover en dirección a hasta el frame sw,
+// después en b", con kick sostenido, ROLL_FRAMES frames hacia adelante. Los ROLL_LANES planes de un lote
+// corren juntos sobre una copia reducida del Match en SoA (puck, paleta propia y rival a velocidad constante)
+// con selects en vez de ramas, así el loop por lane vectoriza. El primer lote cubre las 8x8 combinaciones de
+// direcciones (con el plan anterior corrido un frame); los siguientes perturban al mejor hasta agotar el
+// presupuesto de tiempo. Es una fuente de input como el teclado: no corre dentro de step(), así el rollback
+// sigue siendo exacto.
+static const int ROLL_LANES=64, ROLL_FRAMES=30, ROLL_SWITCH=10, ROLL_MAX_BATCHES=256;
+static float aiBudgetMs=1.0f; static int aiRollouts=0; static uint32_t aiRng=0x2545F491u;
+struct AiPlan{ uint8_t a, b, sw; };
+static AiPlan aiBest={0,0,ROLL_SWITCH};
+// ninguno, arriba, abajo, izquierda, derecha y diagonales (arriba es +y, como en input())
+static const float MOVE_X[9]={0, 0,0,-1,1, -1,1,-1,1}, MOVE_Y[9]={0, 1,-1,0,0, 1,1,-1,-1};
+static const uint8_t MOVE_BITS[9]={0, INPUT_UP, INPUT_DOWN, INPUT_LEFT, INPUT_RIGHT, INPUT_UP|INPUT_LEFT, INPUT_UP|INPUT_RIGHT, INPUT_DOWN|INPUT_LEFT, INPUT_DOWN|INPUT_RIGHT};
+
+struct alignas(32) RollLanes{
+  float px[ROLL_LANES], py[ROLL_LANES], pvx[ROLL_LANES], pvy[ROLL_LANES]; // puck
+  float mx[ROLL_LANES], my[ROLL_LANES], mvx[ROLL_LANES], mvy[ROLL_LANES]; // paleta 1 (IA)
+  float ox[ROLL_LANES], oy[ROLL_LANES], ovx[ROLL_LANES], ovy[ROLL_LANES]; // paleta 0 (rival)
+  float ax0[ROLL_LANES], ay0[ROLL_LANES], ax1[ROLL_LANES], ay1[ROLL_LANES], sw[ROLL_LANES];
+  float score[ROLL_LANES], done[ROLL_LANES], pxSum[ROLL_LANES];
+};
+static RollLanes RL;
+
+// clampSpeed() sin ramas: la división y la raíz se calculan siempre (si no, el loop no vectoriza)
+static inline void rlClamp(float &vx,float &vy,float maxv){ const float k=std::min(1.0f, maxv/std::sqrt(std::max(vx*vx+vy*vy, 1e-12f))); vx*=k; vy*=k; }
+// integrate() + clampSpeed() + collideWalls() sin ramas
+static inline void rlIntegrate(float &x,float &y,float &vx,float &vy,float r,float maxv,float e,float dt){
+  x+=vx*dt; y+=vy*dt; vx*=0.995f; vy*=0.995f;
+  rlClamp(vx,vy,maxv);
+  const bool xl=x<r, xh=x>1-r, yl=y<r, yh=y>1-r;
+  x= xl? r : (xh? 1-r : x); vx= (xl|xh)? vx*e : vx; y= yl? r : (yh? 1-r : y); vy= (yl|yh)? vy*e : vy;
+}
+// resolve(paleta, puck) sin ramas
+static inline void rlResolve(float &ax,float &ay,float &avx,float &avy,float ar, float &bx,float &by,float &bvx,float &bvy,float br){
+  const float dx=bx-ax, dy=by-ay, L=std::sqrt(dx*dx+dy*dy), minD=ar+br; const bool hit= (L<minD) & (L>1e-6f);
+  const float inv=1.0f/std::max(L,1e-6f), nx=dx*inv, ny=dy*inv, pen= hit? (minD-L)*0.5f : 0.0f;
+  ax-=nx*pen; ay-=ny*pen; bx+=nx*pen; by+=ny*pen;
+  const float rel=(bvx-avx)*nx+(bvy-avy)*ny; const bool imp= hit & (rel<0); const float j= imp? -(1.0f+0.75f)*rel*0.5f : 0.0f;
+  avx-=nx*j; avy-=ny*j; bvx+=nx*j; bvy+=ny*j;
+  float cax=avx, cay=avy, cbx=bvx, cby=bvy; rlClamp(cax,cay,MAX_PADDLE_SPEED); rlClamp(cbx,cby,MAX_PUCK_SPEED);
+  avx= imp? cax*0.995f : avx; avy= imp? cay*0.995f : avy; bvx= imp? cbx*0.995f : bvx; bvy= imp? cby*0.995f : bvy;
+}
+
+static void rollBatch(const AiPlan *plans){
+  const Circle &P=S.puck, &M=S.paddles[1], &O=S.paddles[0];
+  const float dt=1.0f/FRAME_DT_DIV, acc=1.2f/FRAME_DT_DIV, pr=P.r, mr=M.r, orr=O.r;
+  for(int l=0;l<ROLL_LANES;l++){ RL.px[l]=P.p.x; RL.py[l]=P.p.y; RL.pvx[l]=P.v.x; RL.pvy[l]=P.v.y; RL.mx[l]=M.p.x; RL.my[l]=M.p.y; RL.mvx[l]=M.v.x; RL.mvy[l]=M.v.y;
+    RL.ox[l]=O.p.x; RL.oy[l]=O.p.y; RL.ovx[l]=O.v.x; RL.ovy[l]=O.v.y; RL.score[l]=0; RL.done[l]=0; RL.pxSum[l]=0;
+    RL.ax0[l]=MOVE_X[plans[l].a]*acc; RL.ay0[l]=MOVE_Y[plans[l].a]*acc; RL.ax1[l]=MOVE_X[plans[l].b]*acc; RL.ay1[l]=MOVE_Y[plans[l].b]*acc; RL.sw[l]=plans[l].sw; }
+  for(int f=0;f<ROLL_FRAMES;f++){ const float ff=(float)f;
+    for(int l=0;l<ROLL_LANES;l++){
+      float px=RL.px[l], py=RL.py[l], pvx=RL.pvx[l], pvy=RL.pvy[l], mx=RL.mx[l], my=RL.my[l], mvx=RL.mvx[l], mvy=RL.mvy[l], ox=RL.ox[l], oy=RL.oy[l], ovx=RL.ovx[l], ovy=RL.ovy[l];
+      // input(1, plan, kick)
+      const float ax0=RL.ax0[l], ay0=RL.ay0[l], ax1=RL.ax1[l], ay1=RL.ay1[l], score=RL.score[l], done=RL.done[l];
+      const bool first=ff<RL.sw[l]; mvx+= first? ax0 : ax1; mvy+= first? ay0 : ay1;
+      { const float dx=px-mx, dy=py-my, d=std::sqrt(dx*dx+dy*dy); const bool kick= d<mr+pr+0.02f; const float inv= (d>1e-6f? 1.0f : 0.0f)/std::max(d,1e-6f);
+        float kvx=pvx+dx*inv*5.0f+mvx*0.6f, kvy=pvy+dy*inv*5.0f+mvy*0.6f; rlClamp(kvx,kvy,MAX_PUCK_SPEED); pvx= kick? kvx : pvx; pvy= kick? kvy : pvy; }
+      // step(): integrar, paletas contra puck, goles (cruce de línea antes de la pared o empujado por una paleta).
+      // Acá el puck no se barre: el modelo de rollout es el de paso fijo, alcanza para elegir planes.
+      const float gx=px+pvx*dt, gm= (py+pvy*dt>0.4f && py+pvy*dt<0.6f)? 1.0f : 0.0f;
+      rlIntegrate(ox,oy,ovx,ovy,orr,MAX_PADDLE_SPEED,-0.9f,dt); rlIntegrate(mx,my,mvx,mvy,mr,MAX_PADDLE_SPEED,-0.9f,dt); rlIntegrate(px,py,pvx,pvy,pr,MAX_PUCK_SPEED,-0.94f,dt);
+      rlResolve(ox,oy,ovx,ovy,orr, px,py,pvx,pvy,pr); rlResolve(mx,my,mvx,mvy,mr, px,py,pvx,pvy,pr);
+      const float mouth= (py>0.4f && py<0.6f)? 1.0f : 0.0f, scored= std::max(gx<pr? gm : 0.0f, px<pr? mouth : 0.0f), conceded= std::max(gx>1.0f-pr? gm : 0.0f, px>1.0f-pr? mouth : 0.0f);
+      const float ev= scored*(100.0f-ff) + conceded*(ff-100.0f); // el primer gol del rollout queda fijo
+      RL.score[l]= done==0.0f? ev : score; RL.done[l]= std::max(done, scored+conceded); RL.pxSum[l]+=px;
+      RL.px[l]=px; RL.py[l]=py; RL.pvx[l]=pvx; RL.pvy[l]=pvy; RL.mx[l]=mx; RL.my[l]=my; RL.mvx[l]=mvx; RL.mvy[l]=mvy; RL.ox[l]=ox; RL.oy[l]=oy; RL.ovx[l]=ovx; RL.ovy[l]=ovy;
+    }
+  }
+  // heurística al final: puck lejos de nuestro arco (x=1) en promedio sobre el rollout (con 30 frames un tiro
+  // fuerte rebota y vuelve, el x final solo castiga pegarle) y yendo hacia el rival, paleta entre puck y arco;
+  // con el puck en el medio o de nuestro lado hay que ir a buscarlo, si no alcanza con seguirlo en y
+  for(int l=0;l<ROLL_LANES;l++){ const float dx=RL.px[l]-RL.mx[l], dy=RL.py[l]-RL.my[l];
+    const float h=2.0f*(1.0f-RL.pxSum[l]/ROLL_FRAMES) - 0.3f*RL.pvx[l] - (RL.px[l]>RL.mx[l]? 2.0f : 0.0f) - (RL.px[l]>0.45f? 0.5f*std::sqrt(dx*dx+dy*dy) : 0.2f*std::fabs(RL.my[l]-RL.py[l]));
+    RL.score[l]= RL.done[l]!=0? RL.score[l] : h; }
+}
+
+static inline uint32_t aiRand(){ uint32_t &s=aiRng; s^=s<<13; s^=s>>17; s^=s<<5; return s; }
+
+// Devuelve los bits INPUT_* para la paleta 1 en este frame. Corre al menos un lote aunque el presupuesto sea 0.
+int aiThink(){
+  aiRollouts=0; if(S.gameOver || S.kickoff>0.0f) return 0;
+  const auto t0=std::chrono::steady_clock::now();
+  AiPlan plans[ROLL_LANES]; float bestScore=-1e30f;
+  const AiPlan warm= aiBest.sw>1? AiPlan{aiBest.a, aiBest.b, (uint8_t)(aiBest.sw-1)} : AiPlan{aiBest.b, aiBest.b, (uint8_t)ROLL_SWITCH};
+  AiPlan best=warm;
+  for(int batch=0; batch<ROLL_MAX_BATCHES; batch++){
+    for(int l=0;l<ROLL_LANES;l++){
+      if(batch==0) plans[l]=AiPlan{(uint8_t)(1+(l&7)), (uint8_t)(1+(l>>3)), (uint8_t)ROLL_SWITCH};
+      else { const uint32_t r=aiRand(); plans[l]={ (r&1)? (uint8_t)(r%9) : best.a, (r&2)? (uint8_t)((r>>8)%9) : best.b, (uint8_t)(1+(r>>16)%ROLL_FRAMES) }; }
+    }
+    // el plan anterior ocupa el lugar de su par de direcciones en la grilla (sólo cambia el frame de cambio)
+    if(batch==0 && warm.a && warm.b) plans[(warm.a-1)+(warm.b-1)*8]=warm;
+    rollBatch(plans); aiRollouts+=ROLL_LANES;
+    for(int l=0;l<ROLL_LANES;l++) if(RL.score[l]>bestScore){ bestScore=RL.score[l]; best=plans[l]; }
+    if(std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now()-t0).count()>=aiBudgetMs) break;
+  }
+  aiBest=best;
+  return MOVE_BITS[best.a] | INPUT_KICK;
 }
+void setAiMode(int m){ aiMode= m? 1 : 0; aiBest={0,0,ROLL_SWITCH}; }
+int getAiMode(){ return aiMode; }
+void setAiBudget(float ms){ aiBudgetMs=std::max(0.0f, ms); }
+float getAiBudget(){ return aiBudgetMs; }
+int getAiRollouts(){ return aiRollouts; } // planes simulados en el último aiThink()
 
 // getters
-val getPlayers(){ static std::vector<float> buf; buf.resize(paddles.size()*4); for(size_t i=0;i<paddles.size();++i){ buf[i*4]=paddles[i].p.x; buf[i*4+1]=paddles[i].p.y; buf[i*4+2]=paddles[i].r; buf[i*4+3]=paddles[i].team; } return val(typed_memory_view(buf.size(), buf.data())); }
-val getBall(){ static float s[3]; s[0]=puck.p.x; s[1]=puck.p.y; s[2]=puck.r; return val(typed_memory_view(3,s)); }
-int getScoreA(){ return scoreA; } int getScoreB(){ return scoreB; }
-float getTime(){ return timeLeft; }
-int getWinner(){ return gameOver? winner : -2; } // -2: en curso, -1: empate, 0: P1, 1: P2
-float getKickoff(){ return kickoff; }
-
-EMSCRIPTEN_BINDINGS(soc){ function("reset", &reset); function("step", &step); function("input", &input); function("getPlayers", &getPlayers); function("getBall", &getBall); function("getScoreA", &getScoreA); function("getScoreB", &getScoreB); function("getTime", &getTime); function("getWinner", &getWinner); function("getKickoff", &getKickoff); }
+int getScoreA(){ return S.scoreA; } int getScoreB(){ return S.scoreB; }
+float getTime(){ return S.timeLeft; }
+int getWinner(){ return S.gameOver? S.winner : -2; } // -2: en curso, -1: empate, 0: P1, 1: P2
+float getKickoff(){ return S.kickoff; }
+
+#ifdef __EMSCRIPTEN__
+val getPlayers(){ static std::vector<float> buf; buf.resize(NPAD*4); for(int i=0;i<NPAD;++i){ buf[i*4]=S.paddles[i].p.x; buf[i*4+1]=S.paddles[i].p.y; buf[i*4+2]=S.paddles[i].r; buf[i*4+3]=S.paddles[i].team; } return val(typed_memory_view(buf.size(), buf.data())); }
+val getBall(){ static float s[3]; s[0]=S.puck.p.x; s[1]=S.puck.p.y; s[2]=S.puck.r; return val(typed_memory_view(3,s)); }
+// frame, rollbacks, frames resimulados (total / último / máximo), frenadas, frames sin confirmar
+val getNetStats(){ static float s[7]; s[0]=(float)net.frame; s[1]=(float)net.rollbacks; s[2]=(float)net.resimFrames; s[3]=(float)net.lastResim; s[4]=(float)net.maxResim; s[5]=(float)net.stalls; s[6]=(float)(net.frame-1-net.lastConfirmed); return val(typed_memory_view(7,s)); }
+
+EMSCRIPTEN_BINDINGS(soc){ function("reset", &reset); function("step", &step); function("input", &input); function("getPlayers", &getPlayers); function("getBall", &getBall); function("getScoreA", &getScoreA); function("getScoreB", &getScoreB); function("getTime", &getTime); function("getWinner", &getWinner); function("getKickoff", &getKickoff); function("snapshot", &snapshot); function("restore", &restore); function("getStateSize", &getStateSize); function("checksum", &checksum); function("netStart", &netStart); function("netStop", &netStop); function("netTick", &netTick); function("getNetStats", &getNetStats); function("aiThink", &aiThink); function("setAiMode", &setAiMode); function("getAiMode", &getAiMode); function("setAiBudget", &setAiBudget); function("getAiBudget", &getAiBudget); function("getAiRollouts", &getAiRollouts); function("setSweep", &setSweep); function("getSweep", &getSweep); }
+#endif
+
+#ifdef SOCCER_BENCH
+// Benchmark nativo (./build.sh native): un partido entero (90 s) con inputs pseudoaleatorios por la sesión
+// net con distintas latencias/jitter. Cada frame confirmado se compara bit a bit (checksum) con la corrida
+// directa sin red, y se mide el costo de restore + resimular MAX_ROLLBACK frames. Después: kernel de rollouts
+// de la IA y tiros rápidos con y sin barrido continuo del puck.
+#include <chrono>
+#include <cstdio>
+
+static double msSince(std::chrono::steady_clock::time_point t){ return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now()-t).count(); }
+
+int main(){
+  const int F=90*60; std::vector<uint8_t> in0(F), in1(F); std::vector<uint32_t> ref(F+1);
+  uint32_t r=12345; auto rnd32=[&]{ r^=r<<13; r^=r>>17; r^=r<<5; return r; };
+  uint8_t b0=0, b1=0; for(int f=0;f<F;f++){ if(rnd32()%12==0) b0=rnd32()&31; if(rnd32()%12==0) b1=rnd32()&31; in0[f]=b0; in1[f]=b1; } // teclas sostenidas varios frames
+  reset(); for(int f=0;f<F;f++){ ref[f]=checksum(); simFrame(in0[f], in1[f]); } ref[F]=checksum();
+  std::printf("estado %d bytes, ring %d snapshots (%d KB); partido %d-%d\n", getStateSize(), RB_RING, (int)(sizeof(snaps)/1024), S.scoreA, S.scoreB);
+
+  const int cfg[][2]={ {0,0}, {2,1}, {4,2}, {6,3}, {9,4} };
+  for(auto &c: cfg){
+    netStart(0, c[0], c[1], 7); int bad=0, checked=0, ticks=0;
+    auto t0=std::chrono::steady_clock::now();
+    while(net.frame<F){ netTick(in0[net.frame], in1[net.frame]); ticks++;
+      const int k=net.lastConfirmed+1; if(k>0 && k<=net.frame){ const uint32_t h= k<net.frame? hashMatch(snaps[k%RB_RING]) : checksum(); checked++; if(h!=ref[k]) bad++; } }
+    const double ms=msSince(t0);
+    std::printf("latencia %d±%d  ticks %5d  rollbacks %5d  resim %6d frames (máx %2d)  frenadas %4d  %.2f us/tick  frames distintos %d/%d\n",
+                c[0], c[1], ticks, net.rollbacks, net.resimFrames, net.maxResim, net.stalls, ms*1000.0/ticks, bad, checked);
+  }
+
+  // costo de un rollback completo: restore + MAX_ROLLBACK frames de step()/input()
+  reset(); for(int f=0;f<600;f++) simFrame(in0[f], in1[f]);
+  const int reps=100000; snapshot(0);
+  auto t0=std::chrono::steady_clock::now();
+  for(int k=0;k<reps;k++){ restore(0); for(int f=0;f<MAX_ROLLBACK;f++){ snapshot(f+1); simFrame(in0[600+f], in1[600+f]); } }
+  std::printf("rollback de %d frames: %.2f us\n", MAX_ROLLBACK, msSince(t0)*1000.0/reps);
+
+  // IA: un lote de 64 planes x 30 frames en el kernel SoA vs los mismos planes con input()/step() escalares
+  setAiMode(1); reset(); for(int f=0;f<120;f++) simFrame(in0[f], 0);
+  { AiPlan plans[ROLL_LANES]; for(int l=0;l<ROLL_LANES;l++) plans[l]={ (uint8_t)(1+(l&7)), (uint8_t)(1+(l>>3)), (uint8_t)ROLL_SWITCH };
+    const int batches=2000; auto t1=std::chrono::steady_clock::now();
+    for(int k=0;k<batches;k++) rollBatch(plans);
+    const double lanesMs=msSince(t1)/batches;
+    const Match saved=S; t1=std::chrono::steady_clock::now();
+    for(int k=0;k<batches/10;k++) for(int l=0;l<ROLL_LANES;l++){ S=saved; for(int f=0;f<ROLL_FRAMES;f++) simFrame(0, MOVE_BITS[f<plans[l].sw? plans[l].a : plans[l].b]|INPUT_KICK); }
+    const double scalarMs=msSince(t1)/(batches/10); S=saved;
+    std::printf("lote %dx%d: kernel %.1f us (%.0f rollouts/ms)  escalar %.1f us\n", ROLL_LANES, ROLL_FRAMES, lanesMs*1000.0, ROLL_LANES/lanesMs, scalarMs*1000.0); }
+
+  // partidos contra un perseguidor fijo (paleta 0): aiStep() vs rollouts con distintos presupuestos.
+  // Los goles son pocos (el puck sólo cruza la línea si una paleta lo empuja contra la pared), así que además se mide en qué campo se juega.
+  auto chaser=[&](uint32_t &rs)->uint8_t{ rs^=rs<<13; rs^=rs>>17; rs^=rs<<5; if(rs%5==0) return 0;
+    const Circle &P=S.puck, &M=S.paddles[0]; const float tx= P.p.x<0.5f? P.p.x-0.05f : 0.15f, ty=P.p.y;
+    return (ty>M.p.y+0.01f? INPUT_UP : ty<M.p.y-0.01f? INPUT_DOWN : 0) | (tx>M.p.x+0.01f? INPUT_RIGHT : tx<M.p.x-0.01f? INPUT_LEFT : 0) | INPUT_KICK; };
+  const float budgets[]={ -1.0f, 0.0f, 0.25f, 1.0f }; // -1: aiStep() de siempre
+  for(float b: budgets){
+    setAiMode(b>=0); setAiBudget(b>=0? b : 0.0f); int ga=0, gb=0; double thinkMs=0; long rollouts=0, thinks=0, frames=0, rival=0;
+    for(int m=0;m<3;m++){ reset(); uint32_t rs=99+m;
+      while(!S.gameOver){ const uint8_t p0=chaser(rs); uint8_t p1=0;
+        if(aiMode){ auto t2=std::chrono::steady_clock::now(); p1=(uint8_t)aiThink(); thinkMs+=msSince(t2); rollouts+=aiRollouts; thinks++; }
+        simFrame(p0, p1); frames++; rival+= S.puck.p.x<0.5f; }
+      ga+=S.scoreA; gb+=S.scoreB; }
+    if(b<0) std::printf("IA aiStep()          goles %d - %d  puck en campo del perseguidor %4.1f%%\n", ga, gb, 100.0*rival/frames);
+    else std::printf("IA rollouts %.2f ms  goles %d - %d  puck en campo del perseguidor %4.1f%%  %4.0f rollouts/frame  %.3f ms/frame\n", b, ga, gb, 100.0*rival/frames, (double)rollouts/std::max(1L,thinks), thinkMs/std::max(1L,thinks));
+  }
+  setAiMode(0);
+
+  // barrido del puck: tiros a MAX_PUCK_SPEED contra una paleta quieta (|offset| < suma de radios: siempre tiene
+  // que tocarla) y en diagonal contra el arco izquierdo (gol si y sólo si la recta cruza x=r dentro del arco).
+  // Sin barrido a 1 paso, sin barrido con 8 sub-pasos (lo que hacía falta antes) y con barrido a 1 paso.
+  struct Mode{ const char *name; bool sweep; int sub; } modes[]={ {"sin barrido, 1 paso  ", false, 1}, {"sin barrido, 8 pasos ", false, 8}, {"barrido, 1 paso      ", true, 1} };
+  for(const Mode &md: modes){ setSweep(md.sweep); const float h=1.0f/FRAME_DT_DIV/md.sub;
+    int through=0, pads=0, wrong=0, goals=0;
+    for(int k=0;k<400;k++){ reset(); S.paddles[0].p={0.3f,0.5f}; S.paddles[1].p={0.9f,0.1f};
+      const float off=-0.11f+0.22f*(k%40)/39.0f; S.puck.p={0.6f+0.0075f*(k/40), 0.5f+off}; S.puck.v={-MAX_PUCK_SPEED,0}; pads++;
+      bool touched=false; for(int f=0;f<30 && !touched && S.puck.p.x>0.2f;f++){ for(int q=0;q<md.sub;q++) step(h); touched= S.puck.v.y!=0.0f || S.puck.v.x>0.0f; }
+      through+= !touched; }
+    for(int k=0;k<400;k++){ reset(); S.paddles[0].p={0.9f,0.3f}; S.paddles[1].p={0.9f,0.7f};
+      const float yc=0.35f+0.3f*(k%40)/39.0f, slope=(k&1? 1.0f : -1.0f)*(0.2f+0.08f*(k/80)), x0=0.5f+0.01f*(k%7);
+      if(std::fabs(yc-0.4f)<0.002f || std::fabs(yc-0.6f)<0.002f) continue;
+      const float c=MAX_PUCK_SPEED/std::sqrt(1.0f+slope*slope); S.puck.p={x0, yc-slope*(x0-S.puck.r)}; S.puck.v={-c, slope*c}; goals++;
+      for(int f=0;f<60 && S.scoreB==0 && S.puck.v.x<0.0f;f++) for(int q=0;q<md.sub && S.scoreB==0;q++) step(h);
+      wrong+= (S.scoreB>0)!=inMouth(yc); }
+    reset(); auto t3=std::chrono::steady_clock::now();
+    for(int f=0;f<F;f++){ applyInput(0,in0[f]); applyInput(1,in1[f]); for(int q=0;q<md.sub;q++) step(h); }
+    std::printf("%s atraviesa paleta %3d/%d  gol mal decidido %3d/%d  partido %.3f us/frame\n", md.name, through, pads, wrong, goals, msSince(t3)*1000.0/F);
+  }
+  setSweep(1);
+  return 0;
+}
+#endif
@@ -1,7 +1,11 @@
+// u_scale/u_offset: identidad para floats; para uint16 normalizado (0..1) mapea a [-0.5,1.5]
 const vertexShaderSource = `
 attribute vec2 a_position;
+uniform vec2 u_scale;
+uniform vec2 u_offset;
 void main() {
-  gl_Position = vec4(a_position * 2.0 - 1.0, 0.0, 1.0);
+  vec2 p = a_position * u_scale + u_offset;
+  gl_Position = vec4(p * 2.0 - 1.0, 0.0, 1.0);
   gl_PointSize = 2.0;
 }
 `;
@@ -16,6 +20,26 @@ void main() {
 }
 `;
 
+// mapa de calor: textura de densidad (luminancia, escala log) sobre un quad de pantalla completa
+const heatVertexSource = `
+attribute vec2 a_corner;
+varying vec2 v_uv;
+void main() {
+  v_uv = a_corner;
+  gl_Position = vec4(a_corner * 2.0 - 1.0, 0.0, 1.0);
+}
+`;
+
+const heatFragmentSource = `
+precision mediump float;
+uniform sampler2D u_density;
+varying vec2 v_uv;
+void main() {
+  float d = texture2D(u_density, v_uv).r;
+  gl_FragColor = vec4(d * 1.6, d * d * 1.2, 0.25 + d * 0.9, 1.0) * step(0.001, d);
+}
+`;
+
 class Renderer {
   constructor(canvas) {
     this.canvas = canvas;
@@ -23,9 +47,25 @@ class Renderer {
     if (!this.gl) throw new Error('WebGL no soportado');
     this.program = this.createProgram(vertexShaderSource, fragmentShaderSource);
     this.posLoc = this.gl.getAttribLocation(this.program, 'a_position');
+    this.scaleLoc = this.gl.getUniformLocation(this.program, 'u_scale');
+    this.offsetLoc = this.gl.getUniformLocation(this.program, 'u_offset');
     this.posBuffer = this.gl.createBuffer();
 
     const gl = this.gl;
+    this.heatProgram = this.createProgram(heatVertexSource, heatFragmentSource);
+    this.cornerLoc = gl.getAttribLocation(this.heatProgram, 'a_corner');
+    this.quadBuffer = gl.createBuffer();
+    gl.bindBuffer(gl.ARRAY_BUFFER, this.quadBuffer);
+    gl.bufferData(gl.ARRAY_BUFFER, new Float32Array([0, 0, 1, 0, 0, 1, 1, 1]), gl.STATIC_DRAW);
+    this.heatTex = gl.createTexture();
+    gl.bindTexture(gl.TEXTURE_2D, this.heatTex);
+    gl.texParameteri(gl.TEXTURE_2D, gl.TEXTURE_MIN_FILTER, gl.LINEAR);
+    gl.texParameteri(gl.TEXTURE_2D, gl.TEXTURE_MAG_FILTER, gl.LINEAR);
+    gl.texParameteri(gl.TEXTURE_2D, gl.TEXTURE_WRAP_S, gl.CLAMP_TO_EDGE);
+    gl.texParameteri(gl.TEXTURE_2D, gl.TEXTURE_WRAP_T, gl.CLAMP_TO_EDGE);
+    gl.pixelStorei(gl.UNPACK_ALIGNMENT, 1);
+    this.heatBytes = new Uint8Array(0);
+
     gl.enable(gl.BLEND);
     gl.blendFunc(gl.SRC_ALPHA, gl.ONE_MINUS_SRC_ALPHA);
     gl.clearColor(0.02, 0.02, 0.03, 1.0);
@@ -54,16 +94,39 @@ class Renderer {
     this.gl.viewport(0, 0, this.canvas.width, this.canvas.height);
   }
 
+  // points: Float32Array (x,y) o Uint16Array (x,y en punto fijo, ver getQuantizedView); se sube la vista tal cual
   draw(points) {
     const gl = this.gl;
+    const quant = points instanceof Uint16Array;
     gl.clear(gl.COLOR_BUFFER_BIT);
     gl.useProgram(this.program);
+    gl.uniform2f(this.scaleLoc, quant ? 2.0 : 1.0, quant ? 2.0 : 1.0);
+    gl.uniform2f(this.offsetLoc, quant ? -0.5 : 0.0, quant ? -0.5 : 0.0);
     gl.bindBuffer(gl.ARRAY_BUFFER, this.posBuffer);
-    gl.bufferData(gl.ARRAY_BUFFER, new Float32Array(points), gl.DYNAMIC_DRAW);
+    gl.bufferData(gl.ARRAY_BUFFER, points, gl.DYNAMIC_DRAW);
     gl.enableVertexAttribArray(this.posLoc);
-    gl.vertexAttribPointer(this.posLoc, 2, gl.FLOAT, false, 0, 0);
+    gl.vertexAttribPointer(this.posLoc, 2, quant ? gl.UNSIGNED_SHORT : gl.FLOAT, quant, 0, 0);
     gl.drawArrays(gl.POINTS, 0, points.length / 2);
   }
+
+  // density: Uint32Array w*h (fila 0 = y 0, igual que los puntos). WebGL1 no tiene texturas uint32:
+  // se pasa a luminancia 8 bits con escala log, costo fijo w*h sin importar cuántas partículas haya
+  drawDensity(density, w, h) {
+    const gl = this.gl;
+    if (this.heatBytes.length !== w * h) this.heatBytes = new Uint8Array(w * h);
+    let max = 1;
+    for (let i = 0; i < density.length; i++) if (density[i] > max) max = density[i];
+    const k = 255 / Math.log1p(max);
+    for (let i = 0; i < density.length; i++) this.heatBytes[i] = Math.log1p(density[i]) * k;
+    gl.clear(gl.COLOR_BUFFER_BIT);
+    gl.useProgram(this.heatProgram);
+    gl.bindTexture(gl.TEXTURE_2D, this.heatTex);
+    gl.texImage2D(gl.TEXTURE_2D, 0, gl.LUMINANCE, w, h, 0, gl.LUMINANCE, gl.UNSIGNED_BYTE, this.heatBytes);
+    gl.bindBuffer(gl.ARRAY_BUFFER, this.quadBuffer);
+    gl.enableVertexAttribArray(this.cornerLoc);
+    gl.vertexAttribPointer(this.cornerLoc, 2, gl.FLOAT, false, 0, 0);
+    gl.drawArrays(gl.TRIANGLE_STRIP, 0, 4);
+  }
 }
 
 class Game {
@@ -78,7 +141,9 @@ class Game {
   }
 
   async init() {
-    const mod = await this.loadWASM();
+    let mod;
+    try { mod = await this.loadWASM(); }
+    catch (e) { document.getElementById('kernel').textContent = e.message; throw e; }
     this.wasm = mod;
     this.wasm.init();
 
@@ -88,10 +153,29 @@ class Game {
     this.loop();
   }
 
-  loadWASM() {
+  // Detección de WASM SIMD128 (módulo mínimo con v128); sin soporte cargamos el build escalar
+  static simdSupported() {
+    try {
+      return WebAssembly.validate(new Uint8Array([0,97,115,109,1,0,0,0,1,5,1,96,0,1,123,3,2,1,0,10,10,1,8,0,65,0,253,15,253,98,11]));
+    } catch (e) { return false; }
+  }
+
+  // Builds en orden de preferencia: sin SIMD128 sólo sirve el escalar; con SharedArrayBuffer (página
+  // crossOriginIsolated) el de pool de hilos, y si no está, el SIMD de un hilo. Todos salen de ./build.sh.
+  async loadWASM() {
+    const threads = self.crossOriginIsolated && typeof SharedArrayBuffer !== 'undefined';
+    const builds = !Game.simdSupported() ? ['physics-scalar.js'] : (threads ? ['physics-mt.js', 'physics.js'] : ['physics.js']);
+    for (const src of builds) {
+      try { return await Game.loadScript(src); }
+      catch (e) { console.warn(`${src}: ${e.message}`); }
+    }
+    throw new Error(`no se pudo cargar ${builds.join(' ni ')} (¿falta correr ./build.sh?)`);
+  }
+
+  static loadScript(src) {
     return new Promise((resolve, reject) => {
       const s = document.createElement('script');
-      s.src = 'physics.js';
+      s.src = src;
       s.onload = async () => {
         try {
           if (typeof Module === 'function') {
@@ -103,7 +187,7 @@ class Game {
           } else reject(new Error('Module no encontrado'));
         } catch (e) { reject(e); }
       };
-      s.onerror = reject;
+      s.onerror = () => { s.remove(); reject(new Error('no se encontró el archivo')); };
       document.body.appendChild(s);
     });
   }
@@ -113,10 +197,29 @@ class Game {
     const countEl = document.getElementById('count');
     const updateEl = document.getElementById('updateMs');
     const dtEl = document.getElementById('dtMs');
+    const kernelEl = document.getElementById('kernel');
+    const uploadEl = document.getElementById('uploadKB');
 
     document.getElementById('spawn100k').onclick = () => this.wasm.spawnRandom(100000);
     document.getElementById('spawn500k').onclick = () => this.wasm.spawnRandom(500000);
-    document.getElementById('clear').onclick = () => this.wasm.clearAll();
+    document.getElementById('clear').onclick = () => { this.wasm.clearAll(); this.wasm.clearBodies(); this.bodyIds = []; };
+    // modo N-body (Barnes–Hut): click agrega un cuerpo masivo en el mouse, shift+click quita el último
+    const modeBtn = document.getElementById('nbody');
+    modeBtn.onclick = () => {
+      this.wasm.setGravityMode(this.wasm.getGravityMode() ? 0 : 1);
+      modeBtn.textContent = this.wasm.getGravityMode() ? 'Modo: N-body' : 'Modo: agujero negro';
+    };
+    document.getElementById('bodies1k').onclick = () => {
+      for (let i = 0; i < 1000; i++) this.bodyIds.push(this.wasm.addBody(Math.random(), Math.random(), 0.001));
+    };
+    this.bodyIds = [];
+    // salida de step(): floats (8 B/partícula), uint16 (4 B/partícula) o mapa de densidad (tamaño fijo)
+    const outBtn = document.getElementById('output');
+    const outNames = ['float', 'uint16', 'densidad'];
+    outBtn.onclick = () => {
+      this.wasm.setOutputMode((this.wasm.getOutputMode() + 1) % 3);
+      outBtn.textContent = `Salida: ${outNames[this.wasm.getOutputMode()]}`;
+    };
 
     this.canvas.addEventListener('mousemove', (e) => {
       const r = this.canvas.getBoundingClientRect();
@@ -124,7 +227,12 @@ class Game {
       this.mouse.y = (e.clientY - r.top) / r.height;
       this.wasm.setBlackHole(this.mouse.x, this.mouse.y);
     });
-    this.canvas.addEventListener('mousedown', () => this.mouse.down = true);
+    this.canvas.addEventListener('mousedown', (e) => {
+      this.mouse.down = true;
+      if (!this.wasm.getGravityMode()) return;
+      if (e.shiftKey) { if (this.bodyIds.length) this.wasm.removeBody(this.bodyIds.pop()); }
+      else this.bodyIds.push(this.wasm.addBody(this.mouse.x, this.mouse.y, 0.01));
+    });
     this.canvas.addEventListener('mouseup', () => this.mouse.down = false);
 
     this.updateHUD = (updateMs) => {
@@ -135,9 +243,11 @@ class Game {
         this.fps = Math.round(30000 / delta);
         this.lastFps = now;
         fpsEl.textContent = this.fps;
-        countEl.textContent = this.wasm.getCount();
+        countEl.textContent = this.wasm.getCount() + (this.wasm.getGravityMode() ? ` · ${this.wasm.getBodyCount()} cuerpos` : '');
+        kernelEl.textContent = (this.wasm.getSimdWidth() > 1 ? `SIMD x${this.wasm.getSimdWidth()}` : 'escalar') + ` · ${this.wasm.getThreadCount()} hilo(s)`;
       }
       updateEl.textContent = updateMs.toFixed(2);
+      uploadEl.textContent = this.uploadKB.toFixed(0);
       dtEl.textContent = this.dt.toFixed(2);
     };
   }
@@ -151,8 +261,18 @@ class Game {
     this.wasm.step(this.dt);
     const upd = performance.now() - t0;
 
-    const pts = this.wasm.getPositionsView();
-    this.renderer.draw(pts);
+    const mode = this.wasm.getOutputMode();
+    let bytes;
+    if (mode === 2) {
+      const d = this.wasm.getDensityView();
+      this.renderer.drawDensity(d, this.wasm.getDensityWidth(), this.wasm.getDensityHeight());
+      bytes = d.byteLength;
+    } else {
+      const pts = mode === 1 ? this.wasm.getQuantizedView() : this.wasm.getPositionsView();
+      this.renderer.draw(pts);
+      bytes = pts.byteLength;
+    }
+    this.uploadKB = bytes / 1024;
 
     this.updateHUD(upd);
     requestAnimationFrame(() => this.loop());
@@ -0,0 +1,30 @@
+// Benchmark headless del build con hilos (Node worker_threads, sin browser).
+// Uso: ./build.sh && node bench-node.mjs [particulas] [frames]
+import { availableParallelism } from 'node:os';
+
+// physics-mt-node.mjs no se versiona: sale de ./build.sh (emsdk)
+const { default: Module } = await import('./physics-mt-node.mjs').catch((e) => {
+  console.error(`falta physics-mt-node.mjs (${e.code || e.message}): correr ./build.sh primero`);
+  process.exit(1);
+});
+
+const n = Number(process.argv[2] || 1000000);
+const frames = Number(process.argv[3] || 100);
+
+const m = await Module();
+m.init();
+m.spawnRandom(n);
+console.log(`partículas ${m.getCount()} · SIMD x${m.getSimdWidth()} · hilos por defecto ${m.getThreadCount()} · núcleos ${availableParallelism()}`);
+
+for (const t of [1, 2, 4, 8]) {
+  m.setThreadCount(t);
+  for (let f = 0; f < 5; f++) m.step(16.6); // warmup: los workers del pool arrancan en frío
+  const t0 = performance.now();
+  for (let f = 0; f < frames; f++) m.step(16.6);
+  const ms = (performance.now() - t0) / frames;
+  const timings = Array.from(m.getChunkTimings());
+  const chunks = timings.map((c) => c.toFixed(3)).join(' ');
+  console.log(`hilos ${m.getThreadCount()} · ${ms.toFixed(3)} ms/step · chunk más lento ${Math.max(...timings).toFixed(3)} ms · chunks ${chunks}`);
+}
+
+process.exit(0); // los workers del pool no terminan solos
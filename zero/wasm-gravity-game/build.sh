@@ -1,10 +1,24 @@
 #!/bin/bash
 set -euo pipefail
 
+# ./build.sh          -> physics.js (SIMD128) + physics-scalar.js (fallback sin SIMD, mismos resultados)
+#                        + physics-mt.js (SIMD128 + pool de hilos, requiere SharedArrayBuffer / crossOriginIsolated)
+#                        + physics-mt-node.mjs (mismo build con hilos para Node: node bench-node.mjs)
+# ./build.sh native   -> physics-bench (SSE/AVX nativo de la máquina, benchmark simd vs escalar e hilos)
+MODE="${1:-wasm}"
+
+if [ "$MODE" = "native" ]; then
+  echo "🔨 Compilando benchmark nativo (gravity game)..."
+  ${CXX:-c++} physics.cpp -O3 -march=native -ffp-contract=off -fno-math-errno -std=c++17 -pthread -DGRAVITY_THREADS -DGRAVITY_BENCH -o physics-bench
+  echo "✅ Compilación OK → ./physics-bench [particulas]"
+  exit 0
+fi
+
 echo "🔨 Compilando física C++ a WebAssembly (gravity game)..."
 
 emcc physics.cpp \
   -O3 \
+  -msimd128 \
   -s WASM=1 \
   --bind \
   -s MODULARIZE=1 \
@@ -12,5 +26,19 @@ emcc physics.cpp \
   -s ALLOW_MEMORY_GROWTH=1 \
   -o physics.js
 
+emcc physics.cpp \
+  -O3 \
+  -s WASM=1 \
+  --bind \
+  -s MODULARIZE=1 \
+  -s EXPORT_NAME=Module \
+  -s ALLOW_MEMORY_GROWTH=1 \
+  -o physics-scalar.js
+
+MT_FLAGS="-O3 -msimd128 -pthread -s PTHREAD_POOL_SIZE=8 -s INITIAL_MEMORY=67108864 -s ALLOW_MEMORY_GROWTH=1 --bind -s MODULARIZE=1 -s EXPORT_NAME=Module"
+
+emcc physics.cpp $MT_FLAGS -s ENVIRONMENT=web,worker -o physics-mt.js
+emcc physics.cpp $MT_FLAGS -s ENVIRONMENT=node -s EXPORT_ES6=1 -o physics-mt-node.mjs
+
 echo "✅ Compilación OK"
-ls -la physics.js physics.wasm || true
+ls -la physics.js physics.wasm physics-scalar.js physics-scalar.wasm physics-mt.js physics-mt.wasm physics-mt-node.mjs || true
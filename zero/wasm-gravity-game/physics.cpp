@@ -1,29 +1,81 @@
+#ifdef __EMSCRIPTEN__
 #include <emscripten/bind.h>
+#endif
 #include <vector>
 #include <cmath>
 #include <cstdlib>
+#include <cstdint>
+#include <chrono>
+#include <algorithm>
+#include <utility>
 
+// Kernel de step: SIMD128 en wasm (-msimd128), SSE/AVX en el build nativo de benchmark, escalar si no hay nada.
+// Los tres hacen exactamente las mismas operaciones en el mismo orden que stepScalar().
+#if defined(__wasm_simd128__)
+#include <wasm_simd128.h>
+#define SIMD_WIDTH 4
+#elif defined(__AVX__)
+#include <immintrin.h>
+#define SIMD_WIDTH 8
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define SIMD_WIDTH 4
+#else
+#define SIMD_WIDTH 1
+#endif
+
+// Build con hilos (-pthread en emcc, -DGRAVITY_THREADS en nativo): pool fijo creado en init()
+#if defined(__EMSCRIPTEN_PTHREADS__) || defined(GRAVITY_THREADS)
+#define GRAVITY_THREADED 1
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#endif
+
+#ifdef __EMSCRIPTEN__
 using namespace emscripten;
+#endif
 
-struct Particle {
-    float x, y;
-    float vx, vy;
+// Los arrays arrancan alineados a línea de cache (64 B) para que los chunks por hilo no compartan líneas
+template <class T> struct CacheAligned {
+    typedef T value_type;
+    CacheAligned() = default;
+    template <class U> CacheAligned(const CacheAligned<U>&) {}
+    T* allocate(size_t n) { return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(64))); }
+    void deallocate(T* p, size_t) { ::operator delete(p, std::align_val_t(64)); }
+    template <class U> bool operator==(const CacheAligned<U>&) const { return true; }
+    template <class U> bool operator!=(const CacheAligned<U>&) const { return false; }
 };
+typedef std::vector<float, CacheAligned<float>> FloatArray;
 
-static std::vector<Particle> particles;
+// Partículas en SoA: cada componente en su propio array contiguo para cargar 4/8 partículas por instrucción
+static FloatArray px, py, pvx, pvy;
 static const size_t MAX_PARTICLES = 1000000; // 1M
 
 static float blackHoleX = 0.5f;
 static float blackHoleY = 0.5f;
 static float gravityStrength = 120.0f; // ajustable desde JS si queremos
 
+static const float DAMPING = 0.9995f;
+static const float EPSILON = 1e-5f; // evitar ramas: sumar epsilon al denom
+
+#ifdef GRAVITY_THREADED
+static void startPool();
+#endif
+static void runJob(int count, void (*fn)(int));
+
 void init() {
-    particles.clear();
-    particles.reserve(MAX_PARTICLES);
+#ifdef GRAVITY_THREADED
+    startPool();
+#endif
+    px.clear(); py.clear(); pvx.clear(); pvy.clear();
+    px.reserve(MAX_PARTICLES); py.reserve(MAX_PARTICLES);
+    pvx.reserve(MAX_PARTICLES); pvy.reserve(MAX_PARTICLES);
 }
 
 void clearAll() {
-    particles.clear();
+    px.clear(); py.clear(); pvx.clear(); pvy.clear();
 }
 
 void setBlackHole(float x, float y) {
@@ -33,34 +85,28 @@ void setBlackHole(float x, float y) {
 
 void spawnRandom(size_t n) {
     if (n > MAX_PARTICLES) n = MAX_PARTICLES;
-    size_t canAdd = (particles.size() + n > MAX_PARTICLES) ? (MAX_PARTICLES - particles.size()) : n;
+    size_t canAdd = (px.size() + n > MAX_PARTICLES) ? (MAX_PARTICLES - px.size()) : n;
     for (size_t i = 0; i < canAdd; i++) {
-        Particle p;
-        p.x = static_cast<float>(std::rand()) / RAND_MAX; // [0,1]
-        p.y = static_cast<float>(std::rand()) / RAND_MAX;
-        p.vx = 0.0f;
-        p.vy = 0.0f;
-        particles.push_back(p);
+        px.push_back(static_cast<float>(std::rand()) / RAND_MAX); // [0,1]
+        py.push_back(static_cast<float>(std::rand()) / RAND_MAX);
+        pvx.push_back(0.0f);
+        pvy.push_back(0.0f);
     }
 }
 
 size_t getCount() {
-    return particles.size();
+    return px.size();
 }
 
-// Integración simple con atracción newtoniana hacia el agujero negro
-void step(float dtMs) {
-    const float dt = dtMs / 1000.0f; // ms a segundos
+// Integración simple con atracción newtoniana hacia el agujero negro, partículas [begin,end)
+static void stepScalarRange(size_t begin, size_t end, float dt) {
     const float G = gravityStrength; // constante
+    float *x = px.data(), *y = py.data(), *vx = pvx.data(), *vy = pvy.data();
 
-    // Evitar ramas: sumar epsilon al denom
-    const float epsilon = 1e-5f;
-
-    for (size_t i = 0; i < particles.size(); i++) {
-        Particle &p = particles[i];
-        float dx = blackHoleX - p.x;
-        float dy = blackHoleY - p.y;
-        float r2 = dx*dx + dy*dy + epsilon;
+    for (size_t i = begin; i < end; i++) {
+        float dx = blackHoleX - x[i];
+        float dy = blackHoleY - y[i];
+        float r2 = dx*dx + dy*dy + EPSILON;
         float invR = 1.0f / std::sqrt(r2);
 
         // fuerza ~ 1/r^2 pero limitamos para estabilidad
@@ -69,30 +115,653 @@ void step(float dtMs) {
         float ux = dx * invR;
         float uy = dy * invR;
 
-        // actualizar velocidad
-        p.vx += a * ux * dt;
-        p.vy += a * uy * dt;
-
-        // damping leve
-        p.vx *= 0.9995f;
-        p.vy *= 0.9995f;
+        // actualizar velocidad + damping leve
+        vx[i] = (vx[i] + a * ux * dt) * DAMPING;
+        vy[i] = (vy[i] + a * uy * dt) * DAMPING;
 
         // actualizar posición
-        p.x += p.vx * dt;
-        p.y += p.vy * dt;
+        x[i] += vx[i] * dt;
+        y[i] += vy[i] * dt;
+    }
+}
+
+// Mismo cálculo, SIMD_WIDTH partículas por iteración; la cola (< SIMD_WIDTH) va por el camino escalar
+static void stepSimdRange(size_t begin, size_t end, float dt) {
+#if SIMD_WIDTH > 1
+    float *x = px.data(), *y = py.data(), *vx = pvx.data(), *vy = pvy.data();
+    size_t i = begin;
+    const size_t vend = begin + ((end - begin) / SIMD_WIDTH) * SIMD_WIDTH;
+#if defined(__wasm_simd128__)
+    const v128_t bhx = wasm_f32x4_splat(blackHoleX), bhy = wasm_f32x4_splat(blackHoleY);
+    const v128_t G = wasm_f32x4_splat(gravityStrength), vdt = wasm_f32x4_splat(dt);
+    const v128_t eps = wasm_f32x4_splat(EPSILON), one = wasm_f32x4_splat(1.0f), damp = wasm_f32x4_splat(DAMPING);
+    for (; i < vend; i += 4) {
+        v128_t X = wasm_v128_load(x + i), Y = wasm_v128_load(y + i);
+        v128_t VX = wasm_v128_load(vx + i), VY = wasm_v128_load(vy + i);
+        v128_t dx = wasm_f32x4_sub(bhx, X), dy = wasm_f32x4_sub(bhy, Y);
+        v128_t r2 = wasm_f32x4_add(wasm_f32x4_add(wasm_f32x4_mul(dx, dx), wasm_f32x4_mul(dy, dy)), eps);
+        v128_t invR = wasm_f32x4_div(one, wasm_f32x4_sqrt(r2));
+        v128_t a = wasm_f32x4_mul(wasm_f32x4_mul(G, invR), invR);
+        v128_t ux = wasm_f32x4_mul(dx, invR), uy = wasm_f32x4_mul(dy, invR);
+        VX = wasm_f32x4_mul(wasm_f32x4_add(VX, wasm_f32x4_mul(wasm_f32x4_mul(a, ux), vdt)), damp);
+        VY = wasm_f32x4_mul(wasm_f32x4_add(VY, wasm_f32x4_mul(wasm_f32x4_mul(a, uy), vdt)), damp);
+        X = wasm_f32x4_add(X, wasm_f32x4_mul(VX, vdt));
+        Y = wasm_f32x4_add(Y, wasm_f32x4_mul(VY, vdt));
+        wasm_v128_store(x + i, X); wasm_v128_store(y + i, Y);
+        wasm_v128_store(vx + i, VX); wasm_v128_store(vy + i, VY);
+    }
+#elif defined(__AVX__)
+    const __m256 bhx = _mm256_set1_ps(blackHoleX), bhy = _mm256_set1_ps(blackHoleY);
+    const __m256 G = _mm256_set1_ps(gravityStrength), vdt = _mm256_set1_ps(dt);
+    const __m256 eps = _mm256_set1_ps(EPSILON), one = _mm256_set1_ps(1.0f), damp = _mm256_set1_ps(DAMPING);
+    for (; i < vend; i += 8) {
+        __m256 X = _mm256_loadu_ps(x + i), Y = _mm256_loadu_ps(y + i);
+        __m256 VX = _mm256_loadu_ps(vx + i), VY = _mm256_loadu_ps(vy + i);
+        __m256 dx = _mm256_sub_ps(bhx, X), dy = _mm256_sub_ps(bhy, Y);
+        __m256 r2 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), eps);
+        __m256 invR = _mm256_div_ps(one, _mm256_sqrt_ps(r2));
+        __m256 a = _mm256_mul_ps(_mm256_mul_ps(G, invR), invR);
+        __m256 ux = _mm256_mul_ps(dx, invR), uy = _mm256_mul_ps(dy, invR);
+        VX = _mm256_mul_ps(_mm256_add_ps(VX, _mm256_mul_ps(_mm256_mul_ps(a, ux), vdt)), damp);
+        VY = _mm256_mul_ps(_mm256_add_ps(VY, _mm256_mul_ps(_mm256_mul_ps(a, uy), vdt)), damp);
+        X = _mm256_add_ps(X, _mm256_mul_ps(VX, vdt));
+        Y = _mm256_add_ps(Y, _mm256_mul_ps(VY, vdt));
+        _mm256_storeu_ps(x + i, X); _mm256_storeu_ps(y + i, Y);
+        _mm256_storeu_ps(vx + i, VX); _mm256_storeu_ps(vy + i, VY);
+    }
+#else // SSE2
+    const __m128 bhx = _mm_set1_ps(blackHoleX), bhy = _mm_set1_ps(blackHoleY);
+    const __m128 G = _mm_set1_ps(gravityStrength), vdt = _mm_set1_ps(dt);
+    const __m128 eps = _mm_set1_ps(EPSILON), one = _mm_set1_ps(1.0f), damp = _mm_set1_ps(DAMPING);
+    for (; i < vend; i += 4) {
+        __m128 X = _mm_loadu_ps(x + i), Y = _mm_loadu_ps(y + i);
+        __m128 VX = _mm_loadu_ps(vx + i), VY = _mm_loadu_ps(vy + i);
+        __m128 dx = _mm_sub_ps(bhx, X), dy = _mm_sub_ps(bhy, Y);
+        __m128 r2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), eps);
+        __m128 invR = _mm_div_ps(one, _mm_sqrt_ps(r2));
+        __m128 a = _mm_mul_ps(_mm_mul_ps(G, invR), invR);
+        __m128 ux = _mm_mul_ps(dx, invR), uy = _mm_mul_ps(dy, invR);
+        VX = _mm_mul_ps(_mm_add_ps(VX, _mm_mul_ps(_mm_mul_ps(a, ux), vdt)), damp);
+        VY = _mm_mul_ps(_mm_add_ps(VY, _mm_mul_ps(_mm_mul_ps(a, uy), vdt)), damp);
+        X = _mm_add_ps(X, _mm_mul_ps(VX, vdt));
+        Y = _mm_add_ps(Y, _mm_mul_ps(VY, vdt));
+        _mm_storeu_ps(x + i, X); _mm_storeu_ps(y + i, Y);
+        _mm_storeu_ps(vx + i, VX); _mm_storeu_ps(vy + i, VY);
+    }
+#endif
+    stepScalarRange(vend, end, dt);
+#else
+    stepScalarRange(begin, end, dt);
+#endif
+}
+
+// --- Pool de hilos ---
+// El rango de partículas se parte en threadCount chunks contiguos, múltiplos de 16 floats (64 B). El hilo que
+// llama a step() procesa el chunk 0 y los workers el resto; step() vuelve recién cuando terminaron todos, así
+// getPositionsView() siempre ve el frame completo. No hay interacción entre partículas: no hace falta más sync.
+// El mismo reparto (runJob) arma en paralelo las partes del árbol de Barnes–Hut que son por partícula.
+static const int MAX_THREADS = 8;
+static const size_t CHUNK_ALIGN = 16;
+static int threadCount = 1; // incluye al hilo principal
+#ifdef GRAVITY_THREADED
+static bool threadCountSet = false; // setThreadCount() explícito: startPool() no lo pisa
+#endif
+static int chunkCount = 1; // chunks del último step(): threadCount si el pool corre, 1 si no
+static size_t chunkSize = 0;
+static float chunkMs[MAX_THREADS] = {0};
+static float jobDt = 0.0f; // dt del step en curso, lo leen los chunks
+
+// --- Modo N-body (Barnes–Hut) ---
+// Fuentes de gravedad: cuerpos masivos (addBody/removeBody) y, con selfGravity, las propias partículas
+// (masa total swarmMass repartida entre todas). Cada frame: orden Morton de las partículas (mejor localidad
+// para el step y para getPositionsView), quadtree lineal sobre las fuentes ordenadas por código Morton y
+// fuerza por partícula recorriendo el árbol con criterio de apertura size/dist < theta.
+// Unidades: un cuerpo de masa 1 atrae igual que el agujero negro (a = gravityStrength * m / r^2).
+struct Body { float x, y, m; int id; };
+static std::vector<Body> bodies;
+static std::vector<int> bodyIndexById; // id -> índice en bodies, -1 si fue removido
+static std::vector<int> freeBodyIds;
+static int gravityMode = 0; // 0 = agujero negro, 1 = Barnes–Hut
+static bool selfGravity = true;
+static float swarmMass = 0.05f;
+static float theta = 1.0f; // 100K + 1000 cuerpos entran en 16.7 ms desde 4 núcleos (bench); 0.7 pide 8
+
+struct BHNode { float cx, cy, mass, size; uint32_t first, count; int32_t child; uint8_t nchild; };
+static std::vector<BHNode> bhNodes;
+static std::vector<float> srcX, srcY, srcM; // fuentes en orden Morton
+static std::vector<uint32_t> srcKeys; // código Morton de cada fuente
+static std::vector<uint32_t> mortonKeys, mortonIdx, sortKeysTmp, sortIdxTmp;
+static std::vector<std::pair<uint32_t, uint32_t>> bodyKeys; // (código Morton, índice) de los cuerpos
+static float bhMinX = 0, bhMinY = 0, bhSpan = 1;
+static const uint32_t BH_LEAF = 8;
+static const int BH_MAX_DEPTH = 16;
+static const float BH_DOMAIN = 0.5f;      // margen del árbol alrededor de [0,1]^2
+static const float BH_SOFTENING = 1e-4f;  // epsilon^2 de N-body (~0.01 de radio): evita colapsos a un punto
+
+static inline uint32_t spreadBits(uint32_t v) { // 16 bits -> posiciones pares
+    v &= 0xffff;
+    v = (v | (v << 8)) & 0x00ff00ff;
+    v = (v | (v << 4)) & 0x0f0f0f0f;
+    v = (v | (v << 2)) & 0x33333333;
+    v = (v | (v << 1)) & 0x55555555;
+    return v;
+}
+static inline uint32_t mortonOf(float x, float y) {
+    const float s = 65535.0f / bhSpan;
+    float qx = (x - bhMinX) * s, qy = (y - bhMinY) * s;
+    qx = qx < 0 ? 0 : (qx > 65535.0f ? 65535.0f : qx);
+    qy = qy < 0 ? 0 : (qy > 65535.0f ? 65535.0f : qy);
+    return spreadBits((uint32_t)qx) | (spreadBits((uint32_t)qy) << 1);
+}
+
+// Partes por partícula del armado, repartidas con runJob() en treeParts tramos contiguos [n*k/P, n*(k+1)/P)
+static size_t treeN = 0;
+static int treeParts = 1, radixShift = 0;
+static uint32_t radixCount[MAX_THREADS][2048];
+static FloatArray permTmp[4];
+
+static void mortonKeysJob(int k) {
+    const size_t b = treeN * k / treeParts, e = treeN * (k + 1) / treeParts;
+    for (size_t i = b; i < e; i++) { mortonKeys[i] = mortonOf(px[i], py[i]); mortonIdx[i] = (uint32_t)i; }
+}
+
+static void radixCountJob(int k) {
+    const size_t b = treeN * k / treeParts, e = treeN * (k + 1) / treeParts;
+    uint32_t *count = radixCount[k];
+    std::fill(count, count + 2048, 0u);
+    for (size_t i = b; i < e; i++) count[(mortonKeys[i] >> radixShift) & 0x7ff]++;
+}
+
+static void radixScatterJob(int k) {
+    const size_t b = treeN * k / treeParts, e = treeN * (k + 1) / treeParts;
+    uint32_t *count = radixCount[k];
+    for (size_t i = b; i < e; i++) {
+        const uint32_t d = count[(mortonKeys[i] >> radixShift) & 0x7ff]++;
+        sortKeysTmp[d] = mortonKeys[i]; sortIdxTmp[d] = mortonIdx[i];
+    }
+}
+
+static void permuteJob(int k) {
+    const size_t b = treeN * k / treeParts, e = treeN * (k + 1) / treeParts;
+    const uint32_t *order = mortonIdx.data();
+    FloatArray* src[4] = {&px, &py, &pvx, &pvy};
+    for (int a = 0; a < 4; a++) {
+        const float *in = src[a]->data(); float *out = permTmp[a].data();
+        for (size_t i = b; i < e; i++) out[i] = in[order[i]];
+    }
+}
+
+// radix sort LSD de (mortonKeys, mortonIdx), 3 pasadas de 11 bits. Cada tramo cuenta sus dígitos, los
+// offsets van por dígito y dentro del dígito por tramo (estable), y cada tramo reparte lo suyo.
+// Una pasada con todas las claves en el mismo dígito (bits altos de una caja chica) no mueve nada y se saltea.
+static void sortByMorton() {
+    sortKeysTmp.resize(treeN); sortIdxTmp.resize(treeN);
+    for (radixShift = 0; radixShift < 32; radixShift += 11) {
+        runJob(treeParts, radixCountJob);
+        uint32_t sum = 0; bool moves = true;
+        for (int d = 0; d < 2048; d++) {
+            uint32_t digit = 0;
+            for (int k = 0; k < treeParts; k++) { const uint32_t c = radixCount[k][d]; radixCount[k][d] = sum + digit; digit += c; }
+            if (digit == treeN) moves = false;
+            sum += digit;
+        }
+        if (!moves) continue;
+        runJob(treeParts, radixScatterJob);
+        mortonKeys.swap(sortKeysTmp); mortonIdx.swap(sortIdxTmp);
     }
 }
 
+// nodo sobre las fuentes [first, first+count), que comparten los primeros 2*depth bits del código Morton.
+// Las claves están ordenadas: el fin de cada cuadrante es un upper_bound, y masa/centro de un nodo interno
+// salen de sus hijos (cada fuente se suma una vez, en su hoja, no una vez por nivel).
+static void buildNode(uint32_t nodeIdx, uint32_t first, uint32_t count, int depth, float size) {
+    BHNode node;
+    node.size = size; node.first = first; node.count = count; node.child = -1; node.nchild = 0;
+    float mass = 0, mx = 0, my = 0;
+    if (count > BH_LEAF && depth < BH_MAX_DEPTH) {
+        const int shift = 2 * (BH_MAX_DEPTH - 1 - depth);
+        const uint32_t *keys = srcKeys.data(), end = first + count;
+        uint32_t ranges[4][2]; int nchild = 0;
+        for (uint32_t b = first; b < end; ) {
+            const uint32_t e = (uint32_t)(std::upper_bound(keys + b, keys + end, keys[b] | ((1u << shift) - 1)) - keys);
+            ranges[nchild][0] = b; ranges[nchild][1] = e - b; nchild++;
+            b = e;
+        }
+        const int32_t child = (int32_t)bhNodes.size();
+        bhNodes.resize(bhNodes.size() + nchild);
+        for (int c = 0; c < nchild; c++) {
+            buildNode(child + c, ranges[c][0], ranges[c][1], depth + 1, size * 0.5f);
+            const BHNode& ch = bhNodes[child + c];
+            mass += ch.mass; mx += ch.cx * ch.mass; my += ch.cy * ch.mass;
+        }
+        node.child = child; node.nchild = (uint8_t)nchild;
+    } else {
+        for (uint32_t i = first; i < first + count; i++) { mass += srcM[i]; mx += srcX[i] * srcM[i]; my += srcY[i] * srcM[i]; }
+    }
+    node.mass = mass; node.cx = mass > 0 ? mx / mass : 0; node.cy = mass > 0 ? my / mass : 0;
+    bhNodes[nodeIdx] = node;
+}
+
+// parts: tramos para runJob() (los chunks del step); 1 = todo en el hilo que llama
+static void buildBarnesHut(int parts) {
+    const size_t n = px.size();
+    // caja contenedora cuadrada de partículas y cuerpos
+    float minX = 1e30f, minY = 1e30f, maxX = -1e30f, maxY = -1e30f;
+    for (size_t i = 0; i < n; i++) { minX = std::min(minX, px[i]); maxX = std::max(maxX, px[i]); minY = std::min(minY, py[i]); maxY = std::max(maxY, py[i]); }
+    for (const Body& b : bodies) { minX = std::min(minX, b.x); maxX = std::max(maxX, b.x); minY = std::min(minY, b.y); maxY = std::max(maxY, b.y); }
+    if (minX > maxX) { minX = minY = 0; maxX = maxY = 1; }
+    // las que escapan lejos no estiran el árbol ni actúan como fuentes (su aporte en pantalla es despreciable)
+    minX = std::max(minX, -BH_DOMAIN); minY = std::max(minY, -BH_DOMAIN); maxX = std::min(maxX, 1.0f + BH_DOMAIN); maxY = std::min(maxY, 1.0f + BH_DOMAIN);
+    bhMinX = minX; bhMinY = minY; bhSpan = std::max(std::max(maxX - minX, maxY - minY), 1e-6f) * 1.0001f;
+
+    // 1) partículas en orden Morton
+    treeN = n; treeParts = parts;
+    mortonKeys.resize(n); mortonIdx.resize(n);
+    runJob(parts, mortonKeysJob);
+    sortByMorton();
+    for (FloatArray& t : permTmp) t.resize(n);
+    runJob(parts, permuteJob);
+    px.swap(permTmp[0]); py.swap(permTmp[1]); pvx.swap(permTmp[2]); pvy.swap(permTmp[3]);
+
+    // 2) fuentes: partículas dentro del dominio (ya en orden Morton, con su clave en mortonKeys) intercaladas
+    //    con los cuerpos, que son pocos y se ordenan aparte
+    const float pm = n > 0 ? swarmMass / (float)n : 0.0f;
+    const float lo = -BH_DOMAIN, hi = 1.0f + BH_DOMAIN;
+    bodyKeys.clear();
+    for (size_t b = 0; b < bodies.size(); b++) bodyKeys.push_back({mortonOf(bodies[b].x, bodies[b].y), (uint32_t)b});
+    std::sort(bodyKeys.begin(), bodyKeys.end());
+    const size_t cap = (selfGravity ? n : 0) + bodies.size();
+    srcX.resize(cap); srcY.resize(cap); srcM.resize(cap); srcKeys.resize(cap);
+    size_t ns = 0, b = 0;
+    for (size_t i = 0; selfGravity && i < n; i++) {
+        if (px[i] < lo || px[i] > hi || py[i] < lo || py[i] > hi) continue;
+        for (; b < bodyKeys.size() && bodyKeys[b].first < mortonKeys[i]; b++, ns++) {
+            const Body& bd = bodies[bodyKeys[b].second];
+            srcX[ns] = bd.x; srcY[ns] = bd.y; srcM[ns] = bd.m; srcKeys[ns] = bodyKeys[b].first;
+        }
+        srcX[ns] = px[i]; srcY[ns] = py[i]; srcM[ns] = pm; srcKeys[ns] = mortonKeys[i]; ns++;
+    }
+    for (; b < bodyKeys.size(); b++, ns++) {
+        const Body& bd = bodies[bodyKeys[b].second];
+        srcX[ns] = bd.x; srcY[ns] = bd.y; srcM[ns] = bd.m; srcKeys[ns] = bodyKeys[b].first;
+    }
+    srcX.resize(ns); srcY.resize(ns); srcM.resize(ns); srcKeys.resize(ns);
+
+    // 3) quadtree
+    bhNodes.clear();
+    if (ns == 0) return;
+    bhNodes.resize(1);
+    buildNode(0, 0, (uint32_t)ns, 0, bhSpan);
+}
+
+// aceleración Barnes–Hut + integración de las partículas [begin,end)
+// Las partículas están en orden Morton, así que cada bloque de BH_GROUP consecutivas es espacialmente compacto:
+// se recorre el árbol una vez por bloque (criterio de apertura contra la caja del bloque, más conservador que
+// por partícula) armando una lista de interacción, y esa lista se aplica a todo el bloque en un loop plano.
+// Un bloque muy disperso (partículas que escaparon del dominio) se procesa partícula por partícula.
+static const size_t BH_GROUP = 32;
+static const float BH_GROUP_SPAN = 0.1f;
+static void stepBarnesHutRange(size_t begin, size_t end, float dt) {
+    thread_local std::vector<float> ilX, ilY, ilM; // lista de interacción por hilo
+    float *x = px.data(), *y = py.data(), *vx = pvx.data(), *vy = pvy.data();
+    if (bhNodes.empty()) { // sin fuentes (ni cuerpos ni autogravedad): aceleración 0, las partículas siguen de largo
+        for (size_t i = begin; i < end; i++) { vx[i] *= DAMPING; vy[i] *= DAMPING; x[i] += vx[i] * dt; y[i] += vy[i] * dt; }
+        return;
+    }
+    const float G = gravityStrength, theta2 = theta * theta;
+    const BHNode* nodes = bhNodes.data();
+    const float *sx = srcX.data(), *sy = srcY.data(), *sm = srcM.data();
+    // cota de la lista: cada fuente entra a lo sumo una vez, sola o dentro de un nodo aceptado
+    const size_t ilCap = srcX.size() + bhNodes.size();
+    if (ilX.size() < ilCap) { ilX.resize(ilCap); ilY.resize(ilCap); ilM.resize(ilCap); }
+    float *lx = ilX.data(), *ly = ilY.data(), *lm = ilM.data();
+    uint32_t stack[4 * BH_MAX_DEPTH + 4];
+    size_t groupEnd = begin;
+    for (size_t g = begin; g < end; ) {
+        size_t ge = std::min(end, g + BH_GROUP);
+        float minX = x[g], maxX = x[g], minY = y[g], maxY = y[g];
+        for (size_t i = g + 1; i < ge; i++) { minX = std::min(minX, x[i]); maxX = std::max(maxX, x[i]); minY = std::min(minY, y[i]); maxY = std::max(maxY, y[i]); }
+        if (g >= groupEnd && std::max(maxX - minX, maxY - minY) > BH_GROUP_SPAN) groupEnd = ge; // disperso: de a uno
+        if (g < groupEnd) { ge = g + 1; minX = maxX = x[g]; minY = maxY = y[g]; }
+        size_t nl = 0;
+        int sp = 0; stack[sp++] = 0;
+        while (sp > 0) {
+            const BHNode& nd = nodes[stack[--sp]];
+            const float dx = std::max(0.0f, std::max(minX - nd.cx, nd.cx - maxX));
+            const float dy = std::max(0.0f, std::max(minY - nd.cy, nd.cy - maxY));
+            if (nd.size * nd.size < theta2 * (dx*dx + dy*dy)) { // lejos del bloque (hoja o no): centro de masa
+                lx[nl] = nd.cx; ly[nl] = nd.cy; lm[nl] = nd.mass; nl++;
+            } else if (nd.child < 0) { // hoja cercana: fuentes individuales
+                for (uint32_t j = nd.first; j < nd.first + nd.count; j++) { lx[nl] = sx[j]; ly[nl] = sy[j]; lm[nl] = sm[j]; nl++; }
+            } else {
+                for (int c = 0; c < nd.nchild; c++) stack[sp++] = (uint32_t)(nd.child + c);
+            }
+        }
+        // lista x bloque: el loop interno va sobre las partículas del bloque (sin reducción, vectorizable)
+        const size_t gn = ge - g;
+        if (gn == 1) { // partícula suelta: sin los BH_GROUP carriles del bloque
+            float ax = 0, ay = 0; const float xi = x[g], yi = y[g];
+            for (size_t j = 0; j < nl; j++) {
+                const float ex = lx[j] - xi, ey = ly[j] - yi;
+                const float r2 = ex*ex + ey*ey + BH_SOFTENING;
+                const float invR = 1.0f / std::sqrt(r2);
+                const float f = lm[j] * invR * invR * invR;
+                ax += ex * f; ay += ey * f;
+            }
+            vx[g] = (vx[g] + G * ax * dt) * DAMPING;
+            vy[g] = (vy[g] + G * ay * dt) * DAMPING;
+            x[g] += vx[g] * dt;
+            y[g] += vy[g] * dt;
+            g = ge;
+            continue;
+        }
+        float bx[BH_GROUP], by[BH_GROUP], bax[BH_GROUP] = {0}, bay[BH_GROUP] = {0};
+        for (size_t i = 0; i < BH_GROUP; i++) { bx[i] = x[g + (i < gn ? i : 0)]; by[i] = y[g + (i < gn ? i : 0)]; }
+        for (size_t j = 0; j < nl; j++) {
+            const float sxj = lx[j], syj = ly[j], smj = lm[j];
+            for (size_t i = 0; i < BH_GROUP; i++) {
+                const float ex = sxj - bx[i], ey = syj - by[i];
+                const float r2 = ex*ex + ey*ey + BH_SOFTENING;
+                const float invR = 1.0f / std::sqrt(r2);
+                const float f = smj * invR * invR * invR;
+                bax[i] += ex * f; bay[i] += ey * f;
+            }
+        }
+        for (size_t i = 0; i < gn; i++) {
+            const size_t k = g + i;
+            vx[k] = (vx[k] + G * bax[i] * dt) * DAMPING;
+            vy[k] = (vy[k] + G * bay[i] * dt) * DAMPING;
+            x[k] += vx[k] * dt;
+            y[k] += vy[k] * dt;
+        }
+        g = ge;
+    }
+}
+
+void setGravityMode(int mode) {
+    gravityMode = mode == 1 ? 1 : 0;
+}
+
+int getGravityMode() {
+    return gravityMode;
+}
+
+void setTheta(float t) {
+    theta = std::max(0.0f, std::min(2.0f, t));
+}
+
+void setSelfGravity(bool on) {
+    selfGravity = on;
+}
+
+void setSwarmMass(float m) {
+    swarmMass = std::max(0.0f, m);
+}
+
+// devuelve un id estable para removeBody
+int addBody(float x, float y, float mass) {
+    int id;
+    if (!freeBodyIds.empty()) { id = freeBodyIds.back(); freeBodyIds.pop_back(); }
+    else { id = (int)bodyIndexById.size(); bodyIndexById.push_back(-1); }
+    bodyIndexById[id] = (int)bodies.size();
+    bodies.push_back({x, y, mass, id});
+    return id;
+}
+
+bool removeBody(int id) {
+    if (id < 0 || id >= (int)bodyIndexById.size() || bodyIndexById[id] < 0) return false;
+    const int idx = bodyIndexById[id];
+    bodies[idx] = bodies.back(); bodyIndexById[bodies[idx].id] = idx; // swap con el último
+    bodies.pop_back();
+    bodyIndexById[id] = -1; freeBodyIds.push_back(id);
+    return true;
+}
+
+void clearBodies() {
+    bodies.clear(); bodyIndexById.clear(); freeBodyIds.clear();
+}
+
+int getBodyCount() {
+    return (int)bodies.size();
+}
+
+// --- Salida para el render ---
+// OUTPUT_FLOAT: getPositionsView() copia 2 floats por partícula (8 B). OUTPUT_QUANT: uint16 x,y en punto fijo
+// (4 B por partícula) sobre [-0.5,1.5], así lo que se va del rango queda pegado a un borde fuera de la pantalla.
+// OUTPUT_DENSITY: histograma W×H uint32 de tamaño constante. Las dos últimas se escriben dentro de step(), por
+// tiles de OUT_TILE partículas recién integradas (todavía en L1), sin una segunda pasada sobre px/py.
+enum { OUTPUT_FLOAT = 0, OUTPUT_QUANT = 1, OUTPUT_DENSITY = 2 };
+static int outputMode = OUTPUT_FLOAT;
+static const size_t OUT_TILE = 1024;
+static const float QUANT_MIN = -0.5f, QUANT_SPAN = 2.0f;
+static std::vector<uint16_t> quantPos;                    // x,y intercalados, persistente
+static std::vector<uint32_t> density;                     // densityW*densityH, lo que lee JS
+static std::vector<uint32_t> densityPart[MAX_THREADS];    // parcial por hilo (el hilo 0 escribe directo en density)
+static int densityW = 256, densityH = 256;
+
+static void writeQuantRange(size_t begin, size_t end) {
+    const float *x = px.data(), *y = py.data();
+    uint16_t *q = quantPos.data();
+    const float s = 65535.0f / QUANT_SPAN;
+    for (size_t i = begin; i < end; i++) { // clamp + cvt sin ramas, vectoriza
+        const float qx = std::min(65535.0f, std::max(0.0f, (x[i] - QUANT_MIN) * s + 0.5f));
+        const float qy = std::min(65535.0f, std::max(0.0f, (y[i] - QUANT_MIN) * s + 0.5f));
+        q[i*2] = (uint16_t)qx; q[i*2+1] = (uint16_t)qy;
+    }
+}
+
+// sólo cuenta lo que cae en [0,1)², la vista del canvas
+static void writeDensityRange(size_t begin, size_t end, uint32_t *hist) {
+    const float *x = px.data(), *y = py.data();
+    const float fw = (float)densityW, fh = (float)densityH;
+    for (size_t i = begin; i < end; i++) {
+        const float cx = x[i] * fw, cy = y[i] * fh;
+        // un solo salto sobre "adentro" (& y no &&: el signo de x/y afuera es aleatorio y no se predice);
+        // una celda de descarte sin salto serializaría los incrementos de todas las que se fueron
+        const bool in = (cx >= 0.0f) & (cy >= 0.0f) & (cx < fw) & (cy < fh);
+        if (in) hist[(int)cy * densityW + (int)cx]++;
+    }
+}
+
+static void runChunk(int k, float dt) {
+    auto t0 = std::chrono::steady_clock::now();
+    const size_t n = px.size(), begin = std::min(n, (size_t)k * chunkSize), end = std::min(n, begin + chunkSize);
+    uint32_t *hist = nullptr;
+    if (outputMode == OUTPUT_DENSITY) {
+        std::vector<uint32_t> &h = k == 0 ? density : densityPart[k];
+        h.assign((size_t)densityW * densityH, 0u);
+        hist = h.data();
+    }
+    // tiles múltiplos de BH_GROUP: los bloques de Barnes–Hut quedan igual que sin tiles
+    for (size_t tb = begin; tb < end; tb += OUT_TILE) {
+        const size_t te = std::min(end, tb + OUT_TILE);
+        if (gravityMode == 1) stepBarnesHutRange(tb, te, dt);
+        else stepSimdRange(tb, te, dt);
+        if (outputMode == OUTPUT_QUANT) writeQuantRange(tb, te);
+        else if (hist) writeDensityRange(tb, te, hist);
+    }
+    chunkMs[k] = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+static void stepChunkJob(int k) {
+    runChunk(k, jobDt);
+}
+
+#ifdef GRAVITY_BENCH
+// Bench: runJob() corre los tramos de a uno en el hilo que llama y acumula el más lento de cada reparto. Con
+// menos núcleos que hilos el reloj de pared no baja; esto da lo que tardaría el step con un núcleo por tramo.
+static bool jobSerial = false;
+static double jobSlowestMs = 0.0, jobTotalMs = 0.0;
+#endif
+
+#ifdef GRAVITY_THREADED
+// sin destructor estático: los workers quedan bloqueados en el cv hasta que el proceso termina
+static std::mutex &poolMutex = *new std::mutex;
+static std::condition_variable &poolCv = *new std::condition_variable;
+static uint64_t jobGen = 0;
+static void (*jobFn)(int) = nullptr;
+static int jobThreads = 1;
+static std::atomic<int> jobPending{0};
+static bool poolStarted = false;
+
+static void workerLoop(int k) {
+    uint64_t seen = 0;
+    for (;;) {
+        std::unique_lock<std::mutex> lk(poolMutex);
+        poolCv.wait(lk, [&] { return jobGen != seen; });
+        seen = jobGen;
+        void (*fn)(int) = jobFn;
+        const bool active = k < jobThreads;
+        lk.unlock();
+        if (!active) continue;
+        fn(k);
+        jobPending.fetch_sub(1, std::memory_order_release);
+    }
+}
+
+static void startPool() {
+    if (poolStarted) return;
+    poolStarted = true;
+    // los workers viven lo que vive el módulo (en wasm salen del PTHREAD_POOL_SIZE precreado)
+    for (int k = 1; k < MAX_THREADS; k++) std::thread(workerLoop, k).detach();
+    if (!threadCountSet) threadCount = std::max(1, std::min(MAX_THREADS, (int)std::thread::hardware_concurrency()));
+}
+#endif
+
+// fn(k) para k en [0, count): el hilo que llama corre fn(0) y vuelve cuando terminaron todos
+static void runJob(int count, void (*fn)(int)) {
+#ifdef GRAVITY_BENCH
+    if (jobSerial) {
+        double slowest = 0.0;
+        for (int k = 0; k < count; k++) {
+            auto t0 = std::chrono::steady_clock::now();
+            fn(k);
+            const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+            slowest = std::max(slowest, ms); jobTotalMs += ms;
+        }
+        jobSlowestMs += slowest;
+        return;
+    }
+#endif
+#ifdef GRAVITY_THREADED
+    if (count > 1) {
+        {
+            std::lock_guard<std::mutex> lk(poolMutex);
+            jobFn = fn; jobThreads = count;
+            jobPending.store(count - 1, std::memory_order_relaxed);
+            jobGen++;
+        }
+        poolCv.notify_all();
+        fn(0);
+        // join: espera activa corta (el main thread del browser no puede bloquearse en un futex)
+        while (jobPending.load(std::memory_order_acquire) > 0) std::this_thread::yield();
+        return;
+    }
+#endif
+    for (int k = 0; k < count; k++) fn(k);
+}
+
+void step(float dtMs) {
+    const size_t n = px.size();
+    // sin pool (setThreadCount antes de init()) todo va en el chunk 0: partirlo dejaría partículas sin integrar
+    chunkCount = 1;
+#ifdef GRAVITY_THREADED
+    if (poolStarted) chunkCount = threadCount;
+#endif
+    // árbol: claves, orden y permutación en chunkCount tramos; fuentes y quadtree en este hilo
+    if (gravityMode == 1) buildBarnesHut(chunkCount);
+    if (outputMode == OUTPUT_QUANT) quantPos.resize(n * 2);
+    const size_t perThread = (n + chunkCount - 1) / chunkCount;
+    chunkSize = (perThread + CHUNK_ALIGN - 1) / CHUNK_ALIGN * CHUNK_ALIGN;
+    jobDt = dtMs / 1000.0f; // ms a segundos
+    runJob(chunkCount, stepChunkJob);
+    if (outputMode == OUTPUT_DENSITY) { // reducción W×H por hilo extra: costo constante, no depende de n
+        uint32_t *d = density.data();
+        for (int k = 1; k < chunkCount; k++) {
+            const uint32_t *p = densityPart[k].data();
+            for (size_t c = 0; c < density.size(); c++) d[c] += p[c];
+        }
+    }
+}
+
+// 0 = floats (getPositionsView), 1 = uint16 (getQuantizedView), 2 = densidad (getDensityView)
+void setOutputMode(int mode) {
+    outputMode = (mode == OUTPUT_QUANT || mode == OUTPUT_DENSITY) ? mode : OUTPUT_FLOAT;
+    if (outputMode == OUTPUT_QUANT) quantPos.reserve(MAX_PARTICLES * 2);
+    else std::vector<uint16_t>().swap(quantPos);
+    if (outputMode != OUTPUT_DENSITY) {
+        std::vector<uint32_t>().swap(density);
+        for (auto &p : densityPart) std::vector<uint32_t>().swap(p);
+    }
+}
+
+int getOutputMode() {
+    return outputMode;
+}
+
+void setDensitySize(int w, int h) {
+    densityW = std::max(16, std::min(1024, w));
+    densityH = std::max(16, std::min(1024, h));
+    density.assign((size_t)densityW * densityH, 0u);
+}
+
+int getDensityWidth() {
+    return densityW;
+}
+
+int getDensityHeight() {
+    return densityH;
+}
+
+// Hilos usados por step() (1 = sin paralelismo). En el build sin hilos siempre queda en 1.
+void setThreadCount(int n) {
+#ifdef GRAVITY_THREADED
+    threadCount = std::max(1, std::min(MAX_THREADS, n));
+    threadCountSet = true;
+#else
+    (void)n; threadCount = 1;
+#endif
+}
+
+int getThreadCount() {
+    return threadCount;
+}
+
+// Camino escalar puro, para comparar contra el kernel SIMD (mismo resultado dentro de tolerancia)
+void stepScalar(float dtMs) {
+    stepScalarRange(0, px.size(), dtMs / 1000.0f);
+}
+
+int getSimdWidth() {
+    return SIMD_WIDTH;
+}
+
+#ifdef __EMSCRIPTEN__
 val getPositionsView() {
     static std::vector<float> buf;
-    buf.resize(particles.size() * 2);
-    for (size_t i = 0; i < particles.size(); i++) {
-        buf[i*2]   = particles[i].x;
-        buf[i*2+1] = particles[i].y;
+    buf.resize(px.size() * 2);
+    for (size_t i = 0; i < px.size(); i++) {
+        buf[i*2]   = px[i];
+        buf[i*2+1] = py[i];
     }
     return val(typed_memory_view(buf.size(), buf.data()));
 }
 
+// uint16 x,y del último step() en modo OUTPUT_QUANT; posición = q / 65535 * 2 - 0.5
+val getQuantizedView() {
+    return val(typed_memory_view(quantPos.size(), quantPos.data()));
+}
+
+// histograma densityW×densityH (fila 0 = y 0) del último step() en modo OUTPUT_DENSITY
+val getDensityView() {
+    return val(typed_memory_view(density.size(), density.data()));
+}
+
+// ms de cada chunk en el último step(), uno por hilo que trabajó
+val getChunkTimings() {
+    return val(typed_memory_view((size_t)chunkCount, chunkMs));
+}
+
 EMSCRIPTEN_BINDINGS(physics_bindings) {
     function("init", &init);
     function("clearAll", &clearAll);
@@ -100,5 +769,149 @@ EMSCRIPTEN_BINDINGS(physics_bindings) {
     function("spawnRandom", &spawnRandom);
     function("getCount", &getCount);
     function("step", &step);
+    function("stepScalar", &stepScalar);
+    function("getSimdWidth", &getSimdWidth);
+    function("setThreadCount", &setThreadCount);
+    function("getThreadCount", &getThreadCount);
+    function("getChunkTimings", &getChunkTimings);
+    function("setGravityMode", &setGravityMode);
+    function("getGravityMode", &getGravityMode);
+    function("setTheta", &setTheta);
+    function("setSelfGravity", &setSelfGravity);
+    function("setSwarmMass", &setSwarmMass);
+    function("addBody", &addBody);
+    function("removeBody", &removeBody);
+    function("clearBodies", &clearBodies);
+    function("getBodyCount", &getBodyCount);
     function("getPositionsView", &getPositionsView);
+    function("setOutputMode", &setOutputMode);
+    function("getOutputMode", &getOutputMode);
+    function("setDensitySize", &setDensitySize);
+    function("getDensityWidth", &getDensityWidth);
+    function("getDensityHeight", &getDensityHeight);
+    function("getQuantizedView", &getQuantizedView);
+    function("getDensityView", &getDensityView);
+}
+#endif
+
+#ifdef GRAVITY_BENCH
+// Benchmark nativo (./build.sh native): ms por step a 1M partículas y diferencia máxima SIMD vs escalar
+#include <chrono>
+#include <cstdio>
+#include <algorithm>
+
+int main(int argc, char **argv) {
+    const size_t n = argc > 1 ? (size_t)std::atol(argv[1]) : MAX_PARTICLES;
+    const int frames = 200;
+    std::srand(1); init(); spawnRandom(n);
+    FloatArray x0 = px, y0 = py;
+
+    // resultado escalar de referencia
+    for (int f = 0; f < 10; f++) stepScalar(16.6f);
+    FloatArray xs = px, ys = py;
+    px = x0; py = y0; std::fill(pvx.begin(), pvx.end(), 0.0f); std::fill(pvy.begin(), pvy.end(), 0.0f);
+    for (int f = 0; f < 10; f++) step(16.6f);
+    float maxDiff = 0.0f;
+    for (size_t i = 0; i < n; i++) maxDiff = std::max(maxDiff, std::max(std::fabs(px[i] - xs[i]), std::fabs(py[i] - ys[i])));
+
+    auto t0 = std::chrono::steady_clock::now();
+    for (int f = 0; f < frames; f++) step(16.6f);
+    auto t1 = std::chrono::steady_clock::now();
+    for (int f = 0; f < frames; f++) stepScalar(16.6f);
+    auto t2 = std::chrono::steady_clock::now();
+    double simdMs = std::chrono::duration<double, std::milli>(t1 - t0).count() / frames;
+    double scalarMs = std::chrono::duration<double, std::milli>(t2 - t1).count() / frames;
+    std::printf("particles %zu  simd(w=%d) %.3f ms/step  scalar %.3f ms/step  max |simd-scalar| %.3g\n",
+                n, SIMD_WIDTH, simdMs, scalarMs, maxDiff);
+#ifdef GRAVITY_THREADED
+    // Escalado: con menos núcleos que hilos el tiempo de pared no baja; el chunk más lento es lo que
+    // tardaría el step con un núcleo por hilo (los chunks no comparten datos).
+    std::printf("hardware threads %u\n", std::thread::hardware_concurrency());
+    double ms1 = 0.0;
+    for (int t = 1; t <= MAX_THREADS; t *= 2) {
+        setThreadCount(t);
+        for (int f = 0; f < 5; f++) step(16.6f); // warmup del pool
+        double slowest = 0.0;
+        auto a = std::chrono::steady_clock::now();
+        for (int f = 0; f < frames; f++) {
+            step(16.6f);
+            double m = 0.0;
+            for (int k = 0; k < t; k++) m = std::max(m, (double)chunkMs[k]);
+            slowest += m;
+        }
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - a).count() / frames;
+        slowest /= frames;
+        if (t == 1) ms1 = ms;
+        std::printf("threads %d  %.3f ms/step (x%.2f)  slowest chunk %.3f ms (x%.2f)  chunks:", t, ms, ms1 / ms, slowest, ms1 / slowest);
+        for (int k = 0; k < t; k++) std::printf(" %.3f", chunkMs[k]);
+        std::printf("\n");
+    }
+#endif
+
+    // modos de salida a n partículas: ms/step y bytes que cruzan a JS por frame
+    setThreadCount(1);
+    {
+        const char *names[] = {"float (step + copia)", "uint16 en step", "densidad 256x256"};
+        for (int mode = 0; mode < 3; mode++) {
+            clearAll(); std::srand(1); spawnRandom(n); // mismo estado inicial para los tres
+            setOutputMode(mode);
+            static std::vector<float> copy; // lo que hace getPositionsView()
+            auto a = std::chrono::steady_clock::now();
+            for (int f = 0; f < frames; f++) {
+                step(16.6f);
+                if (mode == OUTPUT_FLOAT) {
+                    copy.resize(px.size() * 2);
+                    for (size_t i = 0; i < px.size(); i++) { copy[i*2] = px[i]; copy[i*2+1] = py[i]; }
+                }
+            }
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - a).count() / frames;
+            const size_t bytes = mode == OUTPUT_FLOAT ? px.size() * 8 : mode == OUTPUT_QUANT ? quantPos.size() * 2 : (size_t)densityW * densityH * 4;
+            std::printf("salida %-22s %.3f ms/frame  %zu KB/frame\n", names[mode], ms, bytes / 1024);
+        }
+        // error de cuantización sobre lo visible: 1/65535 del rango de 2 unidades
+        setOutputMode(OUTPUT_QUANT); step(16.6f);
+        float qerr = 0.0f;
+        for (size_t i = 0; i < px.size(); i++)
+            if (px[i] >= 0.0f && px[i] <= 1.0f) qerr = std::max(qerr, std::fabs(quantPos[i*2] / 65535.0f * QUANT_SPAN + QUANT_MIN - px[i]));
+        std::printf("max |quant - float| en pantalla %.3g\n", qerr);
+        setOutputMode(OUTPUT_FLOAT);
+    }
+
+    // Barnes–Hut: 100K partículas con autogravedad + 1000 cuerpos, 20 steps desde una distribución uniforme.
+    // Presupuesto: un step por frame a 60 fps. Con N núcleos, jobSerial corre cada reparto de runJob() de a un
+    // tramo y suma el más lento: lo serial (fuentes, quadtree) + el tramo más lento de claves/orden/fuerza.
+    const double budgetMs = 1000.0 / 60.0;
+    const float defaultTheta = theta;
+    jobSerial = true;
+    for (float th : {0.5f, 0.7f, 1.0f}) {
+        std::printf("barnes-hut 100000 + 1000 bodies  theta %.1f%s  ms/step (arbol) por nucleos:", th, th == defaultTheta ? " (default)" : "");
+        int fits = 0, tried = 0;
+        for (int t = 1; t <= MAX_THREADS; t *= 2) {
+            clearAll(); clearBodies(); std::srand(2); spawnRandom(100000);
+            for (int b = 0; b < 1000; b++) addBody(std::rand() / (float)RAND_MAX, std::rand() / (float)RAND_MAX, 0.001f);
+            setGravityMode(1); setTheta(th); setThreadCount(t);
+            if (getThreadCount() != t) break; // build sin hilos: sólo 1
+            double stepMs = 0.0, treeMs = 0.0;
+            for (int f = 0; f < 20; f++) {
+                jobSlowestMs = jobTotalMs = 0.0;
+                auto a = std::chrono::steady_clock::now();
+                step(16.6f);
+                stepMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - a).count() - jobTotalMs + jobSlowestMs;
+                jobSlowestMs = jobTotalMs = 0.0;
+                a = std::chrono::steady_clock::now();
+                buildBarnesHut(t); // mismo estado: sólo para medir el árbol aparte
+                treeMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - a).count() - jobTotalMs + jobSlowestMs;
+            }
+            std::printf("  %d: %.1f (%.1f)", t, stepMs / 20, treeMs / 20);
+            tried = t;
+            if (!fits && stepMs / 20 <= budgetMs) fits = t;
+        }
+        if (fits) std::printf("  -> %.1f ms desde %d nucleos\n", budgetMs, fits);
+        else std::printf("  -> no entra en %.1f ms con %d\n", budgetMs, tried);
+    }
+    jobSerial = false;
+    setTheta(defaultTheta); setThreadCount(1);
+    setGravityMode(0);
+    return 0;
 }
+#endif
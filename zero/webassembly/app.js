@@ -83,19 +83,39 @@ class WebGLRenderer {
         gl.clearColor(0.04, 0.04, 0.04, 1.0);
     }
     
+    // Buffers de GPU del modo WASM: se reservan una vez a MAX_CIRCLES y se actualizan con bufferSubData
+    // directo desde las vistas de wasm (que apuntan a los arrays de la simulación, sin copia)
+    allocWasmBuffers(maxCircles) {
+        const gl = this.gl;
+        gl.bindBuffer(gl.ARRAY_BUFFER, this.positionBuffer);
+        gl.bufferData(gl.ARRAY_BUFFER, maxCircles * 2 * 4, gl.DYNAMIC_DRAW);
+        gl.bindBuffer(gl.ARRAY_BUFFER, this.colorBuffer);
+        gl.bufferData(gl.ARRAY_BUFFER, maxCircles * 3 * 4, gl.DYNAMIC_DRAW);
+        gl.bindBuffer(gl.ARRAY_BUFFER, this.sizeBuffer);
+        gl.bufferData(gl.ARRAY_BUFFER, maxCircles * 4, gl.DYNAMIC_DRAW);
+        this.wasmBuffersReady = true;
+    }
+
     render(wasmModule) {
         const gl = this.gl;
-        const count = wasmModule._getCircleCount();
         
-        if (count === 0) {
+        if (wasmModule._getCircleCount() === 0) {
             gl.clear(gl.COLOR_BUFFER_BIT);
             return;
         }
-        
-        // Usar Embind: obtener vistas tipadas directamente
-        const positions = wasmModule.getPositionsView();
-        const colors = wasmModule.getColorsView();
-        const sizes = wasmModule.getSizesView();
+
+        // renderJS() reasigna los mismos buffers con otro tamaño: al volver, reservar y republicar todo
+        if (!this.wasmBuffersReady) {
+            this.allocWasmBuffers(wasmModule._getMaxCircles());
+            wasmModule._markAllAttribDirty();
+        }
+
+        // 0: cámara por defecto, arrays de la simulación sin copia; 1: sólo lo visible (culling + LOD en wasm)
+        const renderMode = wasmModule._prepareRender();
+        const count = wasmModule._getRenderCount();
+        // el modo compacto pisa colores/tamaños en los buffers de GPU: al volver al directo, republicar todo
+        if (renderMode === 0 && this.lastRenderMode === 1) wasmModule._markAllAttribDirty();
+        this.lastRenderMode = renderMode;
         
         // Clear
         gl.clear(gl.COLOR_BUFFER_BIT);
@@ -103,21 +123,32 @@ class WebGLRenderer {
         // Usar programa
         gl.useProgram(this.program);
         
-        // Subir positions
+        // Posiciones: cambian todas en cada frame
         gl.bindBuffer(gl.ARRAY_BUFFER, this.positionBuffer);
-        gl.bufferData(gl.ARRAY_BUFFER, new Float32Array(positions), gl.DYNAMIC_DRAW);
+        gl.bufferSubData(gl.ARRAY_BUFFER, 0, renderMode === 0 ? wasmModule.getPositionsView() : wasmModule.getRenderPositionsView());
         gl.enableVertexAttribArray(this.positionLoc);
         gl.vertexAttribPointer(this.positionLoc, 2, gl.FLOAT, false, 0, 0);
         
-        // Subir colors
+        if (renderMode === 0) {
+            // Colores y tamaños: sólo el rango sucio (círculos nuevos o modificados)
+            const d0 = wasmModule._getAttribDirtyBegin();
+            const d1 = wasmModule._getAttribDirtyEnd();
+            gl.bindBuffer(gl.ARRAY_BUFFER, this.colorBuffer);
+            if (d1 > d0) gl.bufferSubData(gl.ARRAY_BUFFER, d0 * 3 * 4, wasmModule.getColorsView().subarray(d0 * 3, d1 * 3));
+            gl.bindBuffer(gl.ARRAY_BUFFER, this.sizeBuffer);
+            if (d1 > d0) gl.bufferSubData(gl.ARRAY_BUFFER, d0 * 4, wasmModule.getSizesView().subarray(d0, d1));
+            if (d1 > d0) wasmModule._clearAttribDirty();
+        } else {
+            // el conjunto visible cambia con la cámara: colores y tamaños de lo visible, enteros
+            gl.bindBuffer(gl.ARRAY_BUFFER, this.colorBuffer);
+            gl.bufferSubData(gl.ARRAY_BUFFER, 0, wasmModule.getRenderColorsView());
+            gl.bindBuffer(gl.ARRAY_BUFFER, this.sizeBuffer);
+            gl.bufferSubData(gl.ARRAY_BUFFER, 0, wasmModule.getRenderSizesView());
+        }
         gl.bindBuffer(gl.ARRAY_BUFFER, this.colorBuffer);
-        gl.bufferData(gl.ARRAY_BUFFER, new Float32Array(colors), gl.DYNAMIC_DRAW);
         gl.enableVertexAttribArray(this.colorLoc);
         gl.vertexAttribPointer(this.colorLoc, 3, gl.FLOAT, false, 0, 0);
-        
-        // Subir sizes
         gl.bindBuffer(gl.ARRAY_BUFFER, this.sizeBuffer);
-        gl.bufferData(gl.ARRAY_BUFFER, new Float32Array(sizes), gl.DYNAMIC_DRAW);
         gl.enableVertexAttribArray(this.sizeLoc);
         gl.vertexAttribPointer(this.sizeLoc, 1, gl.FLOAT, false, 0, 0);
         
@@ -141,6 +172,9 @@ class App {
         this.mode = 'WASM'; // 'WASM' | 'JS'
         this.jsCircles = [];
         this.isDrawing = false;
+        this.mouseX = 0.5; this.mouseY = 0.5;
+        this.cam = { x0: 0, y0: 0, x1: 1, y1: 1 }; // rectángulo del mundo visible (sólo modo WASM)
+        this.streamEmitter = -1;
         this.lastTime = performance.now();
         this.frameCount = 0;
         this.fps = 60;
@@ -156,6 +190,7 @@ class App {
             
             this.setupEvents();
             this.renderer.resize();
+            this.wasmModule._setViewportSize(this.canvas.width, this.canvas.height);
             this.animate();
             
             console.log('✅ WASM cargado correctamente!');
@@ -217,6 +252,14 @@ class App {
             this.clearAll();
         });
 
+        // Colisiones círculo–círculo (sólo WASM)
+        const collideBtn = document.getElementById('collisions');
+        collideBtn.addEventListener('click', () => {
+            const on = this.wasmModule._getCollisions() ? 0 : 1;
+            this.wasmModule._setCollisions(on);
+            collideBtn.textContent = on ? 'Colisiones: on' : 'Colisiones: off';
+        });
+
         // Mouse events
         this.canvas.addEventListener('mousedown', (e) => {
             this.isDrawing = true;
@@ -224,6 +267,12 @@ class App {
         });
         
         this.canvas.addEventListener('mousemove', (e) => {
+            const rect = this.canvas.getBoundingClientRect();
+            this.mouseSX = (e.clientX - rect.left) / rect.width;
+            this.mouseSY = (e.clientY - rect.top) / rect.height;
+            const p = this.toWorld(this.mouseSX, this.mouseSY);
+            this.mouseX = p.x; this.mouseY = p.y;
+            if (this.streamEmitter >= 0) this.wasmModule._moveEmitter(this.streamEmitter, this.mouseX, this.mouseY);
             if (this.isDrawing) {
                 this.addCircleAtMouse(e);
             }
@@ -252,54 +301,118 @@ class App {
             this.isDrawing = false;
         });
         
+        // Cámara (modo WASM): rueda = zoom en el cursor, flechas = pan, 0 = ver todo
+        this.canvas.addEventListener('wheel', (e) => {
+            if (this.mode !== 'WASM') return;
+            e.preventDefault();
+            this.zoomCamera(this.mouseSX ?? 0.5, this.mouseSY ?? 0.5, e.deltaY < 0 ? 1.25 : 0.8);
+        }, { passive: false });
+
         // Keyboard
         window.addEventListener('keydown', (e) => {
+            if (this.mode === 'WASM') {
+                const step = 0.1;
+                if (e.key === 'ArrowLeft') this.panCamera(-step, 0);
+                if (e.key === 'ArrowRight') this.panCamera(step, 0);
+                if (e.key === 'ArrowUp') this.panCamera(0, -step);
+                if (e.key === 'ArrowDown') this.panCamera(0, step);
+                if (e.key === '0') { this.cam = { x0: 0, y0: 0, x1: 1, y1: 1 }; this.applyCamera(); }
+            }
             if (e.key === 'c' || e.key === 'C') {
                 this.clearAll();
             }
             if (e.key === 't' || e.key === 'T') {
                 document.getElementById('toggleMode').click();
             }
+            // Emisores nativos (sólo WASM): E prende/apaga un stream que sigue al mouse, B un burst
+            if (this.mode === 'WASM' && (e.key === 'e' || e.key === 'E')) {
+                if (this.streamEmitter >= 0) {
+                    this.wasmModule._destroyEmitter(this.streamEmitter);
+                    this.streamEmitter = -1;
+                } else {
+                    this.streamEmitter = this.wasmModule._createEmitter(1, this.mouseX, this.mouseY);
+                }
+            }
+            if (this.mode === 'WASM' && (e.key === 'b' || e.key === 'B')) {
+                const id = this.wasmModule._createEmitter(0, this.mouseX, this.mouseY);
+                if (id >= 0) {
+                    this.wasmModule._setEmitterRate(id, 3000);
+                    this.wasmModule._setEmitterColors(id, 0.3, 0.9, 1.0, 0.6, 0.2, 1.0);
+                }
+            }
         });
         
         // Resize
         window.addEventListener('resize', () => {
             this.renderer.resize();
+            this.wasmModule._setViewportSize(this.canvas.width, this.canvas.height);
         });
     }
     
+    // pantalla [0,1] -> mundo según la cámara (en modo JS la cámara no aplica)
+    toWorld(sx, sy) {
+        if (this.mode !== 'WASM') return { x: sx, y: sy };
+        const c = this.cam;
+        return { x: c.x0 + sx * (c.x1 - c.x0), y: c.y0 + sy * (c.y1 - c.y0) };
+    }
+
+    applyCamera() {
+        const c = this.cam;
+        if (c.x0 === 0 && c.y0 === 0 && c.x1 === 1 && c.y1 === 1) this.wasmModule._resetCamera();
+        else this.wasmModule._setCamera(c.x0, c.y0, c.x1, c.y1);
+    }
+
+    // zoom alrededor del punto de pantalla (sx, sy); factor > 1 acerca
+    zoomCamera(sx, sy, factor) {
+        const c = this.cam;
+        const p = this.toWorld(sx, sy);
+        const w = (c.x1 - c.x0) / factor, h = (c.y1 - c.y0) / factor;
+        this.cam = { x0: p.x - sx * w, y0: p.y - sy * h, x1: p.x - sx * w + w, y1: p.y - sy * h + h };
+        this.applyCamera();
+    }
+
+    panCamera(dx, dy) {
+        const c = this.cam;
+        const w = c.x1 - c.x0, h = c.y1 - c.y0;
+        this.cam = { x0: c.x0 + dx * w, y0: c.y0 + dy * h, x1: c.x1 + dx * w, y1: c.y1 + dy * h };
+        this.applyCamera();
+    }
+
     addCircleAtMouse(e) {
         const rect = this.canvas.getBoundingClientRect();
-        const x = (e.clientX - rect.left) / rect.width;
-        const y = (e.clientY - rect.top) / rect.height;
+        const p = this.toWorld((e.clientX - rect.left) / rect.width, (e.clientY - rect.top) / rect.height);
         
-        // Agregar múltiples círculos para efecto más denso
-        for (let i = 0; i < 5; i++) {
-            const offsetX = (Math.random() - 0.5) * 0.02;
-            const offsetY = (Math.random() - 0.5) * 0.02;
-            if (this.mode === 'WASM') {
-                this.wasmModule._addCircle(x + offsetX, y + offsetY);
-            } else {
-                this.jsAddCircle(x + offsetX, y + offsetY);
-            }
-        }
+        this.addCirclesAround(p.x, p.y);
     }
     
     addCircleAtTouch(touch) {
         const rect = this.canvas.getBoundingClientRect();
-        const x = (touch.clientX - rect.left) / rect.width;
-        const y = (touch.clientY - rect.top) / rect.height;
+        const p = this.toWorld((touch.clientX - rect.left) / rect.width, (touch.clientY - rect.top) / rect.height);
         
+        this.addCirclesAround(p.x, p.y);
+    }
+
+    // Agregar múltiples círculos para efecto más denso (en WASM: un solo addCircles)
+    addCirclesAround(x, y) {
+        const xy = new Float32Array(10);
         for (let i = 0; i < 5; i++) {
-            const offsetX = (Math.random() - 0.5) * 0.02;
-            const offsetY = (Math.random() - 0.5) * 0.02;
-            if (this.mode === 'WASM') {
-                this.wasmModule._addCircle(x + offsetX, y + offsetY);
-            } else {
-                this.jsAddCircle(x + offsetX, y + offsetY);
-            }
+            xy[i * 2] = x + (Math.random() - 0.5) * 0.02;
+            xy[i * 2 + 1] = y + (Math.random() - 0.5) * 0.02;
+        }
+        if (this.mode === 'WASM') {
+            this.wasmAddCircles(xy);
+        } else {
+            for (let i = 0; i < 5; i++) this.jsAddCircle(xy[i * 2], xy[i * 2 + 1]);
         }
     }
+
+    // x,y intercalados -> staging en el heap de wasm -> un solo cruce JS/WASM
+    wasmAddCircles(xy) {
+        const count = xy.length / 2;
+        const ptr = this.wasmModule._getSpawnStaging(count);
+        this.wasmModule.HEAPF32.set(xy, ptr >> 2); // HEAPF32 después de getSpawnStaging: puede haber crecido la memoria
+        return this.wasmModule._addCircles(ptr, count);
+    }
     
     animate() {
         const now = performance.now();
@@ -342,6 +455,16 @@ class App {
             document.getElementById('fps').textContent = this.fps;
             const count = this.mode === 'WASM' ? this.wasmModule._getCircleCount() : this.jsCircles.length;
             document.getElementById('count').textContent = count;
+            const visEl = document.getElementById('visible');
+            visEl.textContent = this.mode === 'WASM'
+                ? `${this.wasmModule._getRenderCount()} (${this.wasmModule._getAggregatedCount()} agregados) · prep ${this.wasmModule._getRenderPrepMs().toFixed(2)} ms`
+                : '-';
+            const collideEl = document.getElementById('collideStats');
+            if (this.mode === 'WASM' && this.wasmModule._getCollisions()) {
+                collideEl.textContent = `broad ${this.wasmModule._getBroadphaseMs().toFixed(2)} ms · narrow ${this.wasmModule._getNarrowphaseMs().toFixed(2)} ms · ${this.wasmModule._getCollisionPairs()} contactos`;
+            } else {
+                collideEl.textContent = '-';
+            }
         }
     }
 
@@ -386,8 +509,9 @@ class App {
             colors[i * 3] = c.r; colors[i * 3 + 1] = c.g; colors[i * 3 + 2] = c.b;
             sizes[i] = c.size;
         }
-        // Usar el mismo pipeline del renderer
+        // Usar el mismo pipeline del renderer (reasigna sus buffers: el modo WASM los vuelve a reservar)
         const gl = this.renderer.gl;
+        this.renderer.wasmBuffersReady = false;
         gl.clear(gl.COLOR_BUFFER_BIT);
         gl.useProgram(this.renderer.program);
         gl.bindBuffer(gl.ARRAY_BUFFER, this.renderer.positionBuffer);
@@ -416,10 +540,12 @@ class App {
         const N = 50000;
         const seedPoints = () => ({ x: Math.random(), y: Math.random() });
         if (this.mode === 'WASM') {
+            const xy = new Float32Array(N * 2);
             for (let i = 0; i < N; i++) {
                 const s = seedPoints();
-                this.wasmModule._addCircle(s.x, s.y);
+                xy[i * 2] = s.x; xy[i * 2 + 1] = s.y;
             }
+            this.wasmAddCircles(xy);
             const t0 = performance.now();
             this.wasmModule._updateCircles(16.67);
             const dt = performance.now() - t0;
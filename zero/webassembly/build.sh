@@ -1,12 +1,24 @@
 #!/bin/bash
 set -euo pipefail
 
+# ./build.sh          -> renderer.js + renderer.wasm (SIMD128)
+# ./build.sh native   -> renderer-bench (colisiones a 10K-100K círculos: broadphase y narrowphase por frame)
+MODE="${1:-wasm}"
+
+if [ "$MODE" = "native" ]; then
+  echo "🔨 Compilando benchmark nativo (renderer)..."
+  ${CXX:-c++} renderer.cpp -O3 -std=c++17 -DRENDERER_BENCH -o renderer-bench
+  echo "✅ Compilación OK → ./renderer-bench [circulos]"
+  exit 0
+fi
+
 echo "🔨 Compilando C++ a WebAssembly..."
 
 emcc renderer.cpp \
     -O3 \
+    -msimd128 \
     -s WASM=1 \
-    -s EXPORTED_FUNCTIONS='["_init","_addCircle","_updateCircles","_getPositions","_getColors","_getSizes","_getCircleCount","_clearCircles"]' \
+    -s EXPORTED_FUNCTIONS='["_init","_addCircle","_getSpawnStaging","_addCircles","_createEmitter","_destroyEmitter","_moveEmitter","_setEmitterRate","_setEmitterSpread","_setEmitterColors","_setEmitterSize","_updateCircles","_getPositions","_getColors","_getSizes","_getCircleCount","_getMaxCircles","_getAttribDirtyBegin","_getAttribDirtyEnd","_clearAttribDirty","_markAllAttribDirty","_setCollisions","_getCollisions","_setViewportSize","_getBroadphaseMs","_getNarrowphaseMs","_getCollisionPairs","_getBroadphaseRebuilds","_setCamera","_resetCamera","_prepareRender","_getRenderCount","_getAggregatedCount","_getRenderPrepMs","_clearCircles"]' \
     -s EXPORTED_RUNTIME_METHODS='["ccall","cwrap","getValue","setValue","HEAPU8","HEAPF32"]' \
     --bind \
     -s ALLOW_MEMORY_GROWTH=1 \
@@ -1,165 +1,789 @@
+#ifdef __EMSCRIPTEN__
 #include <emscripten.h>
+#include <emscripten/bind.h>
+#else
+#define EMSCRIPTEN_KEEPALIVE // build nativo de benchmark (./build.sh native)
+#endif
 #include <cmath>
 #include <vector>
 #include <cstdlib>
-#include <emscripten/bind.h>
+#include <algorithm>
+#include <cstdint>
+#include <chrono>
+#if defined(__wasm_simd128__)
+#include <wasm_simd128.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Círculos en SoA. positions (x,y intercalados), colors (r,g,b) y sizes tienen exactamente el layout de los
+// atributos de WebGL: son los buffers que JS sube, sin copia intermedia. Se dimensionan una vez en init() a
+// MAX_CIRCLES, así los punteros no cambian mientras el módulo vive (salvo crecimiento de memoria de wasm).
+const int MAX_CIRCLES = 200000;
+
+static std::vector<float> positions; // x,y
+static std::vector<float> velX, velY;
+static std::vector<float> colors;    // r,g,b
+static std::vector<float> sizes;
+static int circleCount = 0;
+static float maxCircleSize = 0.0f; // diámetro máximo en px (gl_PointSize), dimensiona la grilla de colisiones
+
+// Rango [dirtyBegin, dirtyEnd) de círculos cuyo color/tamaño cambió desde el último clearAttribDirty().
+// Las posiciones cambian todas en cada update y se suben enteras; colores y tamaños sólo cuando hay rango.
+static int dirtyBegin = 0, dirtyEnd = 0;
+
+static void markAttribDirty(int begin, int end) {
+    if (dirtyBegin >= dirtyEnd) { dirtyBegin = begin; dirtyEnd = end; return; }
+    dirtyBegin = std::min(dirtyBegin, begin);
+    dirtyEnd = std::max(dirtyEnd, end);
+}
+
+// xorshift32: un estado de 4 bytes por generador, sin la sincronización ni el costo de std::rand()
+static inline uint32_t nextRand(uint32_t& s) {
+    s ^= s << 13; s ^= s >> 17; s ^= s << 5;
+    return s;
+}
+
+static inline float randUnit(uint32_t& s) { // [0,1)
+    return (nextRand(s) >> 8) * (1.0f / 16777216.0f);
+}
+
+static uint32_t spawnRng = 0x9e3779b9u; // addCircle / addCircles
 
-// Estructura para cada círculo
-struct Circle {
+// Escribe un círculo en el slot circleCount (el que llama verifica MAX_CIRCLES y marca el rango sucio)
+static inline void pushCircle(float x, float y, float vx, float vy, float r, float g, float b, float size) {
+    const int i = circleCount++;
+    positions[i*2] = x;
+    positions[i*2+1] = y;
+    velX[i] = vx;
+    velY[i] = vy;
+    colors[i*3] = r;
+    colors[i*3+1] = g;
+    colors[i*3+2] = b;
+    sizes[i] = size;
+    maxCircleSize = std::max(maxCircleSize, size);
+}
+
+// Mismo modelo que addCircle() de siempre: velocidad random ±0.05, gradiente por x, tamaño 3..22
+static inline void pushDefaultCircle(float x, float y) {
+    const uint32_t h = nextRand(spawnRng);
+    const float vx = ((int)(h % 100) - 50) * 0.001f;
+    const float vy = ((int)((h >> 8) % 100) - 50) * 0.001f;
+    pushCircle(x, y, vx, vy, x, 0.5f, 1.0f - x, 3.0f + (float)((h >> 16) % 20));
+}
+
+// --- Emisores nativos ---
+// Spawnean dentro de updateCircles(), sin cruzar a JS. STREAM emite `rate` círculos por segundo mientras
+// viva; BURST emite `rate` círculos de una vez en el próximo update y se libera. Dirección dir ± spread/2
+// (radianes), velocidad speed (mismas unidades que vx/vy: por ms), color sobre la rampa c0 -> c1.
+enum { EMITTER_BURST = 0, EMITTER_STREAM = 1 };
+const int MAX_EMITTERS = 32;
+
+struct Emitter {
+    bool active;
+    int mode;
     float x, y;
-    float vx, vy;  // velocidad
-    float r, g, b; // color
-    float size;
+    float rate, accum;
+    float dir, spread, speed;
+    float c0[3], c1[3];
+    float sizeMin, sizeMax;
+    uint32_t rng;
 };
 
-std::vector<Circle> circles;
-const int MAX_CIRCLES = 50000;
+static Emitter emitters[MAX_EMITTERS];
+
+static void runEmitter(Emitter& e, float deltaTime) {
+    int n;
+    if (e.mode == EMITTER_BURST) {
+        n = (int)e.rate;
+        e.active = false;
+    } else {
+        e.accum += e.rate * deltaTime * 0.001f;
+        n = (int)e.accum;
+        e.accum -= (float)n;
+    }
+    n = std::min(n, MAX_CIRCLES - circleCount);
+    if (n <= 0) return;
+    const int first = circleCount;
+    for (int k = 0; k < n; k++) {
+        const float a = e.dir + (randUnit(e.rng) - 0.5f) * e.spread;
+        const float v = e.speed * (0.5f + 0.5f * randUnit(e.rng));
+        const float t = randUnit(e.rng);
+        pushCircle(e.x, e.y, std::cos(a) * v, std::sin(a) * v,
+                   e.c0[0] + (e.c1[0] - e.c0[0]) * t,
+                   e.c0[1] + (e.c1[1] - e.c0[1]) * t,
+                   e.c0[2] + (e.c1[2] - e.c0[2]) * t,
+                   e.sizeMin + (e.sizeMax - e.sizeMin) * randUnit(e.rng));
+    }
+    markAttribDirty(first, circleCount);
+}
+
+static Emitter* emitterById(int id) {
+    return (id >= 0 && id < MAX_EMITTERS && emitters[id].active) ? &emitters[id] : nullptr;
+}
+
+// Staging para addCircles(): JS escribe x,y acá (HEAPF32) y pasa el puntero
+static std::vector<float> spawnStaging;
+
+// --- Colisiones círculo–círculo (opcional, setCollisions) ---
+// Se resuelven en px de pantalla (x*viewW, y*viewH) con radio size/2, el mismo círculo que dibuja el shader.
+// Broadphase: grilla uniforme de celda >= diámetro máximo. Los índices se mantienen ordenados por celda entre
+// frames (sortIdx/sortKey) y sólo se reordenan si algún círculo cambió de celda. No se repara con insertion
+// sort: con claves fila-mayor, bajar una fila mueve la clave gridW celdas y cuesta una fila entera de swaps.
+// Narrowphase: posiciones/velocidades se copian en orden de celda (SoA ordenado), así los vecinos "hacia
+// adelante" de una celda (la de la derecha y las tres de abajo) son rangos contiguos y el loop par a par sobre
+// un rango no tiene dependencias entre iteraciones. Jacobi: las correcciones se acumulan y se aplican al final.
+// Techo medido (./build.sh native, 1 núcleo, 1920×1080, tamaños 3..22 px): 50K círculos ~11-13 ms/frame ya
+// asentados (~400K contactos), dentro de 60 Hz; los primeros frames, con todo apilado contra las paredes,
+// llegan a ~60 ms. 100K ~40 ms: arriba de 50K no entra en 60 Hz.
+static bool collisionsOn = false;
+static float viewW = 1000.0f, viewH = 1000.0f;
+static const float COLLISION_RESTITUTION = 0.5f;
+
+static std::vector<int> sortIdx, cellStart;
+static std::vector<uint32_t> sortKey, sortKeyTmp;
+static std::vector<int> sortIdxTmp;
+static std::vector<float> sx, sy, sr, svx, svy, cdx, cdy, cvx, cvy;
+static int gridW = 0, gridH = 0;
+static float cellPx = 0.0f;
+static double broadphaseMs = 0.0, narrowphaseMs = 0.0;
+static int collisionPairs = 0;
+static int broadphaseRebuilds = 0; // frames en los que hubo que reordenar
+
+static inline uint32_t cellKeyOf(int i) {
+    int cx = (int)(positions[i*2] * viewW / cellPx), cy = (int)(positions[i*2+1] * viewH / cellPx);
+    cx = std::max(0, std::min(gridW - 1, cx));
+    cy = std::max(0, std::min(gridH - 1, cy));
+    return (uint32_t)(cy * gridW + cx);
+}
+
+static void countingSortKeys(int cells) {
+    const size_t n = sortKey.size();
+    sortIdxTmp.resize(n); sortKeyTmp.resize(n);
+    std::fill(cellStart.begin(), cellStart.end(), 0);
+    for (size_t a = 0; a < n; a++) cellStart[sortKey[a] + 1]++;
+    for (int c = 0; c < cells; c++) cellStart[c + 1] += cellStart[c];
+    for (size_t a = 0; a < n; a++) {
+        const int dst = cellStart[sortKey[a]]++;
+        sortIdxTmp[dst] = sortIdx[a]; sortKeyTmp[dst] = sortKey[a];
+    }
+    sortIdx.swap(sortIdxTmp); sortKey.swap(sortKeyTmp);
+}
+
+static void buildBroadphase() {
+    const int n = circleCount;
+    const float cell = std::max(4.0f, maxCircleSize);
+    const int gw = std::max(1, (int)std::ceil(viewW / cell)), gh = std::max(1, (int)std::ceil(viewH / cell));
+    const bool gridChanged = gw != gridW || gh != gridH || cell != cellPx;
+    gridW = gw; gridH = gh; cellPx = cell;
+    const int cells = gw * gh;
+    cellStart.resize(cells + 1);
+
+    bool sorted = true;
+    if (!gridChanged && (int)sortIdx.size() <= n) {
+        // orden del frame anterior + círculos nuevos al final, claves recalculadas en ese orden
+        for (int a = (int)sortIdx.size(); a < n; a++) sortIdx.push_back(a);
+        sortKey.resize(n);
+        for (int a = 0; a < n; a++) {
+            sortKey[a] = cellKeyOf(sortIdx[a]);
+            sorted &= a == 0 || sortKey[a-1] <= sortKey[a];
+        }
+    } else {
+        sortIdx.resize(n); sortKey.resize(n);
+        for (int a = 0; a < n; a++) { sortIdx[a] = a; sortKey[a] = cellKeyOf(a); }
+        sorted = false;
+    }
+    // ningún círculo cambió de celda: el orden sirve tal cual. Si no, counting sort estable sobre el orden
+    // anterior: los que no se movieron conservan su posición relativa y el scatter es casi secuencial.
+    if (!sorted) { countingSortKeys(cells); broadphaseRebuilds++; }
+
+    // inicio de cada celda sobre las claves ya ordenadas
+    int a = 0;
+    for (int c = 0; c <= cells; c++) {
+        while (a < n && (int)sortKey[a] < c) a++;
+        cellStart[c] = a;
+    }
+}
+
+// i contra el rango contiguo [j0, j1) del SoA ordenado. Todo con min/max y máscaras, sin saltos por par:
+// 4 pares por iteración con SIMD128 (wasm) o SSE2 (build nativo); el bloque se saltea entero si ninguno de
+// los 4 se toca (d² >= (ri+rj)², lo de abajo sumaría 0). La cola (< 4) va en un bloque más con radio 0 en los
+// carriles que sobran: el SoA tiene COLLIDE_PAD slots de relleno al final y esos carriles suman 0 exacto.
+// Sin SIMD, el mismo cálculo escalar par por par.
+static inline float collidePair(int j, float xi, float yi, float ri, float vxi, float vyi,
+                                float& axi, float& ayi, float& bxi, float& byi) {
+    const float ex = sx[j] - xi, ey = sy[j] - yi, rr = ri + sr[j];
+    const float d = std::sqrt(ex*ex + ey*ey) + 1e-6f;
+    const float nx = ex / d, ny = ey / d;
+    const float pen = 0.5f * std::max(0.0f, rr - d);              // cada uno se corre la mitad
+    const float hitMask = std::min(1.0f, pen * 1e4f);             // 1 si se tocan, 0 si no
+    const float vn = (svx[j] - vxi) * nx + (svy[j] - vyi) * ny;   // < 0: acercándose
+    const float imp = hitMask * 0.5f * (1.0f + COLLISION_RESTITUTION) * std::max(0.0f, -vn);
+    cdx[j] += nx * pen; cdy[j] += ny * pen;
+    cvx[j] += nx * imp; cvy[j] += ny * imp;
+    axi -= nx * pen; ayi -= ny * pen;
+    bxi -= nx * imp; byi -= ny * imp;
+    return hitMask;
+}
+
+#if defined(__wasm_simd128__)
+typedef v128_t f4;
+static inline f4 f4splat(float v) { return wasm_f32x4_splat(v); }
+static inline f4 f4load(const float* p) { return wasm_v128_load(p); }
+static inline void f4store(float* p, f4 v) { wasm_v128_store(p, v); }
+static inline f4 f4add(f4 a, f4 b) { return wasm_f32x4_add(a, b); }
+static inline f4 f4sub(f4 a, f4 b) { return wasm_f32x4_sub(a, b); }
+static inline f4 f4mul(f4 a, f4 b) { return wasm_f32x4_mul(a, b); }
+static inline f4 f4div(f4 a, f4 b) { return wasm_f32x4_div(a, b); }
+static inline f4 f4sqrt(f4 a) { return wasm_f32x4_sqrt(a); }
+static inline f4 f4min(f4 a, f4 b) { return wasm_f32x4_pmin(a, b); }
+static inline f4 f4max(f4 a, f4 b) { return wasm_f32x4_pmax(a, b); }
+static inline bool f4anyLess(f4 a, f4 b) { return wasm_v128_any_true(wasm_f32x4_lt(a, b)); }
+static inline float f4sum(f4 v) {
+    return wasm_f32x4_extract_lane(v, 0) + wasm_f32x4_extract_lane(v, 1) + wasm_f32x4_extract_lane(v, 2) + wasm_f32x4_extract_lane(v, 3);
+}
+#define COLLIDE_SIMD 1
+#elif defined(__SSE2__)
+typedef __m128 f4;
+static inline f4 f4splat(float v) { return _mm_set1_ps(v); }
+static inline f4 f4load(const float* p) { return _mm_loadu_ps(p); }
+static inline void f4store(float* p, f4 v) { _mm_storeu_ps(p, v); }
+static inline f4 f4add(f4 a, f4 b) { return _mm_add_ps(a, b); }
+static inline f4 f4sub(f4 a, f4 b) { return _mm_sub_ps(a, b); }
+static inline f4 f4mul(f4 a, f4 b) { return _mm_mul_ps(a, b); }
+static inline f4 f4div(f4 a, f4 b) { return _mm_div_ps(a, b); }
+static inline f4 f4sqrt(f4 a) { return _mm_sqrt_ps(a); }
+static inline f4 f4min(f4 a, f4 b) { return _mm_min_ps(a, b); }
+static inline f4 f4max(f4 a, f4 b) { return _mm_max_ps(a, b); }
+static inline bool f4anyLess(f4 a, f4 b) { return _mm_movemask_ps(_mm_cmplt_ps(a, b)) != 0; }
+static inline float f4sum(f4 v) {
+    float t[4]; _mm_storeu_ps(t, v); return t[0] + t[1] + t[2] + t[3];
+}
+#define COLLIDE_SIMD 1
+#endif
+
+static const int COLLIDE_PAD = 3;
+#ifdef COLLIDE_SIMD
+static const float COLLIDE_LIVE[8] = {1, 1, 1, 1, 0, 0, 0, 0}; // &COLLIDE_LIVE[4 - k]: k carriles vivos
+#endif
+
+static inline int collideRange(int i, int j0, int j1) {
+    const float xi = sx[i], yi = sy[i], ri = sr[i], vxi = svx[i], vyi = svy[i];
+    float axi = 0.0f, ayi = 0.0f, bxi = 0.0f, byi = 0.0f, hits = 0.0f;
+#ifdef COLLIDE_SIMD
+    const f4 X0 = f4splat(xi), Y0 = f4splat(yi), R0 = f4splat(ri), VX0 = f4splat(vxi), VY0 = f4splat(vyi);
+    const f4 zero = f4splat(0.0f), one = f4splat(1.0f), half = f4splat(0.5f), eps = f4splat(1e-6f);
+    const f4 maskScale = f4splat(1e4f), impScale = f4splat(0.5f * (1.0f + COLLISION_RESTITUTION));
+    f4 ax = zero, ay = zero, bx = zero, by = zero, hv = zero;
+    for (int j = j0; j < j1; j += 4) {
+        const f4 ex = f4sub(f4load(&sx[j]), X0), ey = f4sub(f4load(&sy[j]), Y0);
+        f4 rr = f4add(R0, f4load(&sr[j]));
+        if (j + 4 > j1) rr = f4mul(rr, f4load(&COLLIDE_LIVE[4 - (j1 - j)]));
+        const f4 d2 = f4add(f4mul(ex, ex), f4mul(ey, ey));
+        if (!f4anyLess(d2, f4mul(rr, rr))) continue;
+        const f4 d = f4add(f4sqrt(d2), eps);
+        const f4 nx = f4div(ex, d), ny = f4div(ey, d);
+        const f4 pen = f4mul(half, f4max(zero, f4sub(rr, d)));
+        const f4 hit = f4min(one, f4mul(pen, maskScale));
+        const f4 vn = f4add(f4mul(f4sub(f4load(&svx[j]), VX0), nx), f4mul(f4sub(f4load(&svy[j]), VY0), ny));
+        const f4 imp = f4mul(f4mul(hit, impScale), f4max(zero, f4sub(zero, vn)));
+        const f4 px = f4mul(nx, pen), py = f4mul(ny, pen), ix = f4mul(nx, imp), iy = f4mul(ny, imp);
+        f4store(&cdx[j], f4add(f4load(&cdx[j]), px)); f4store(&cdy[j], f4add(f4load(&cdy[j]), py));
+        f4store(&cvx[j], f4add(f4load(&cvx[j]), ix)); f4store(&cvy[j], f4add(f4load(&cvy[j]), iy));
+        ax = f4sub(ax, px); ay = f4sub(ay, py); bx = f4sub(bx, ix); by = f4sub(by, iy);
+        hv = f4add(hv, hit);
+    }
+    axi = f4sum(ax); ayi = f4sum(ay); bxi = f4sum(bx); byi = f4sum(by); hits = f4sum(hv);
+#else
+    for (int j = j0; j < j1; j++) hits += collidePair(j, xi, yi, ri, vxi, vyi, axi, ayi, bxi, byi);
+#endif
+    cdx[i] += axi; cdy[i] += ayi;
+    cvx[i] += bxi; cvy[i] += byi;
+    return (int)(hits + 0.5f);
+}
+
+static void resolveCollisions(float deltaTime) {
+    auto t0 = std::chrono::steady_clock::now();
+    buildBroadphase();
+    auto t1 = std::chrono::steady_clock::now();
+
+    const int n = circleCount;
+    for (auto* v : {&sx, &sy, &sr, &svx, &svy}) v->resize(n + COLLIDE_PAD);
+    for (auto* v : {&cdx, &cdy, &cvx, &cvy}) v->assign(n + COLLIDE_PAD, 0.0f);
+    for (int a = 0; a < n; a++) { // gather a px, en orden de celda
+        const int i = sortIdx[a];
+        sx[a] = positions[i*2] * viewW; sy[a] = positions[i*2+1] * viewH;
+        sr[a] = sizes[i] * 0.5f;
+        svx[a] = velX[i] * viewW; svy[a] = velY[i] * viewH;
+    }
+
+    int pairs = 0;
+    for (int cy = 0; cy < gridH; cy++) {
+        for (int cx = 0; cx < gridW; cx++) {
+            const int c = cy * gridW + cx;
+            const int end = cellStart[c + 1];
+            if (cellStart[c] == end) continue;
+            const int rowEnd = cellStart[cx + 1 < gridW ? c + 2 : c + 1]; // esta celda + la de la derecha
+            int b0 = 0, b1 = 0;                                          // las tres de abajo
+            if (cy + 1 < gridH) {
+                const int r = (cy + 1) * gridW;
+                b0 = cellStart[r + std::max(0, cx - 1)];
+                b1 = cellStart[r + std::min(gridW - 1, cx + 1) + 1];
+            }
+            for (int i = cellStart[c]; i < end; i++) {
+                pairs += collideRange(i, i + 1, rowEnd);
+                if (b1 > b0) pairs += collideRange(i, b0, b1);
+            }
+        }
+    }
+
+    // scatter de vuelta a coordenadas normalizadas. Con colisiones los bordes son paredes (afuera todo caería
+    // en las celdas del borde y las llenaría) y la velocidad se limita a media celda por frame: más rápido, un
+    // círculo atraviesa a otro sin llegar a solaparse nunca.
+    const float vmax = deltaTime > 0.0f ? 0.5f * cellPx / deltaTime : 0.0f;
+    for (int a = 0; a < n; a++) {
+        const int i = sortIdx[a];
+        float x = positions[i*2] + cdx[a] / viewW, y = positions[i*2+1] + cdy[a] / viewH;
+        float vx = svx[a] + cvx[a], vy = svy[a] + cvy[a]; // px/ms
+        const float v2 = vx*vx + vy*vy;
+        if (v2 > vmax * vmax) { const float k = vmax / std::sqrt(v2); vx *= k; vy *= k; }
+        if (x < 0.0f) { x = 0.0f; vx = std::fabs(vx) * 0.9f; } else if (x > 1.0f) { x = 1.0f; vx = -std::fabs(vx) * 0.9f; }
+        if (y < 0.0f) { y = 0.0f; vy = std::fabs(vy) * 0.9f; } else if (y > 1.0f) { y = 1.0f; vy = -std::fabs(vy) * 0.9f; }
+        positions[i*2] = x; positions[i*2+1] = y;
+        velX[i] = vx / viewW; velY[i] = vy / viewH;
+    }
+    auto t2 = std::chrono::steady_clock::now();
+    broadphaseMs = std::chrono::duration<double, std::milli>(t1 - t0).count();
+    narrowphaseMs = std::chrono::duration<double, std::milli>(t2 - t1).count();
+    collisionPairs = pairs;
+}
+
+// --- Cámara, culling y LOD antes del upload ---
+// Con la cámara por defecto (todo el mundo [0,1]² en pantalla) JS sube los arrays de la simulación tal cual
+// (RENDER_DIRECT, sin copia y con rango sucio). Con zoom/pan, prepareRender() compacta en renderPos/Col/Size
+// sólo lo que cae en la vista, ya en coordenadas de cámara y con el tamaño escalado por el zoom; los círculos
+// que quedan por debajo de LOD_MIN_PX se suman en celdas de AGG_CELL_PX px de pantalla y salen como un
+// punto por celda (centroide, color promedio, área conservada). Lo que se sube y dibuja depende de lo visible.
+enum { RENDER_DIRECT = 0, RENDER_COMPACT = 1 };
+static const float LOD_MIN_PX = 1.0f;
+static const float AGG_CELL_PX = 4.0f;
+
+static float camX0 = 0.0f, camY0 = 0.0f, camX1 = 1.0f, camY1 = 1.0f;
+static std::vector<float> renderPos, renderCol, renderSize;
+static int renderCount = 0, aggregatedCount = 0;
+static double renderPrepMs = 0.0;
+
+struct AggCell { float n, x, y, r, g, b, area; };
+static std::vector<AggCell> aggCells;
+static std::vector<int> aggTouched;
+static int aggW = 0, aggH = 0;
+
+static inline void pushRender(float x, float y, float r, float g, float b, float size) {
+    const int k = renderCount++;
+    renderPos[k*2] = x; renderPos[k*2+1] = y;
+    renderCol[k*3] = r; renderCol[k*3+1] = g; renderCol[k*3+2] = b;
+    renderSize[k] = size;
+}
+
+static bool cameraIsDefault() {
+    return camX0 == 0.0f && camY0 == 0.0f && camX1 == 1.0f && camY1 == 1.0f;
+}
+
+static int buildCompactRender() {
+    const float sxs = 1.0f / (camX1 - camX0), sys = 1.0f / (camY1 - camY0);
+    const float zoom = sxs; // px de pantalla por px "de mundo" (el tamaño se define a zoom 1)
+    const float mxs = 0.5f * zoom / viewW, mys = 0.5f * zoom / viewH; // radio en coords de cámara por unidad de size
+    const int aw = std::max(1, (int)std::ceil(viewW / AGG_CELL_PX)), ah = std::max(1, (int)std::ceil(viewH / AGG_CELL_PX));
+    if (aw != aggW || ah != aggH) {
+        aggW = aw; aggH = ah;
+        aggCells.assign((size_t)aw * ah, AggCell{0, 0, 0, 0, 0, 0, 0});
+        aggTouched.clear();
+    }
+    renderCount = 0;
+    for (int i = 0; i < circleCount; i++) {
+        const float cx = (positions[i*2] - camX0) * sxs, cy = (positions[i*2+1] - camY0) * sys;
+        const float mx = sizes[i] * mxs, my = sizes[i] * mys;
+        if (cx < -mx || cx > 1.0f + mx || cy < -my || cy > 1.0f + my) continue; // fuera de la vista
+        const float px = sizes[i] * zoom;
+        if (px >= LOD_MIN_PX) {
+            pushRender(cx, cy, colors[i*3], colors[i*3+1], colors[i*3+2], px);
+            continue;
+        }
+        const int ax = std::max(0, std::min(aw - 1, (int)(cx * aw))), ay = std::max(0, std::min(ah - 1, (int)(cy * ah)));
+        AggCell& c = aggCells[ay * aw + ax];
+        if (c.n == 0.0f) aggTouched.push_back(ay * aw + ax);
+        c.n += 1.0f; c.x += cx; c.y += cy;
+        c.r += colors[i*3]; c.g += colors[i*3+1]; c.b += colors[i*3+2];
+        c.area += px * px;
+    }
+    aggregatedCount = (int)aggTouched.size();
+    for (int cell : aggTouched) {
+        AggCell& c = aggCells[cell];
+        const float inv = 1.0f / c.n;
+        pushRender(c.x * inv, c.y * inv, c.r * inv, c.g * inv, c.b * inv,
+                   std::min(AGG_CELL_PX, std::max(LOD_MIN_PX, std::sqrt(c.area))));
+        c = AggCell{0, 0, 0, 0, 0, 0, 0};
+    }
+    aggTouched.clear();
+    return renderCount;
+}
 
 extern "C" {
     // Inicializar
     EMSCRIPTEN_KEEPALIVE
     void init() {
-        circles.clear();
-        circles.reserve(MAX_CIRCLES);
+        positions.assign(MAX_CIRCLES * 2, 0.0f);
+        velX.assign(MAX_CIRCLES, 0.0f);
+        velY.assign(MAX_CIRCLES, 0.0f);
+        colors.assign(MAX_CIRCLES * 3, 0.0f);
+        sizes.assign(MAX_CIRCLES, 0.0f);
+        renderPos.assign(MAX_CIRCLES * 2, 0.0f);
+        renderCol.assign(MAX_CIRCLES * 3, 0.0f);
+        renderSize.assign(MAX_CIRCLES, 0.0f);
+        renderCount = aggregatedCount = 0;
+        circleCount = 0;
+        maxCircleSize = 0.0f;
+        dirtyBegin = dirtyEnd = 0;
+        sortIdx.clear(); sortKey.clear();
+        for (auto& e : emitters) e.active = false;
     }
-    
-    // Agregar círculo
+
+    // Agregar círculo (velocidad random, color gradiente por x)
     EMSCRIPTEN_KEEPALIVE
     void addCircle(float x, float y) {
-        if ((int)circles.size() >= MAX_CIRCLES) return;
-        
-        Circle c;
-        c.x = x;
-        c.y = y;
-        // Velocidad random para efecto cool
-        c.vx = (std::rand() % 100 - 50) * 0.001f;
-        c.vy = (std::rand() % 100 - 50) * 0.001f;
-        // Color gradiente basado en posición
-        c.r = x;
-        c.g = 0.5f;
-        c.b = 1.0f - x;
-        c.size = 3.0f + (std::rand() % 20);
-        
-        circles.push_back(c);
-    }
-    
-    // Update physics
+        if (circleCount >= MAX_CIRCLES) return;
+        pushDefaultCircle(x, y);
+        markAttribDirty(circleCount - 1, circleCount);
+    }
+
+    // Buffer de al menos count*2 floats donde JS deja las posiciones para addCircles()
+    EMSCRIPTEN_KEEPALIVE
+    float* getSpawnStaging(int count) {
+        spawnStaging.resize((size_t)std::max(1, std::min(count, MAX_CIRCLES)) * 2);
+        return spawnStaging.data();
+    }
+
+    // Agregar count círculos desde x,y intercalados en xy: un solo cruce JS -> wasm.
+    // Devuelve cuántos entraron (se corta en MAX_CIRCLES).
+    EMSCRIPTEN_KEEPALIVE
+    int addCircles(const float* xy, int count) {
+        const int n = std::max(0, std::min(count, MAX_CIRCLES - circleCount));
+        const int first = circleCount;
+        for (int k = 0; k < n; k++) pushDefaultCircle(xy[k*2], xy[k*2+1]);
+        if (n > 0) markAttribDirty(first, circleCount);
+        return n;
+    }
+
+    // Crea un emisor (mode 0 = burst, 1 = stream) con valores por defecto; -1 si no hay slots libres
+    EMSCRIPTEN_KEEPALIVE
+    int createEmitter(int mode, float x, float y) {
+        for (int id = 0; id < MAX_EMITTERS; id++) {
+            Emitter& e = emitters[id];
+            if (e.active) continue;
+            e.active = true;
+            e.mode = mode == EMITTER_BURST ? EMITTER_BURST : EMITTER_STREAM;
+            e.x = x; e.y = y;
+            e.rate = mode == EMITTER_BURST ? 1000.0f : 2000.0f;
+            e.accum = 0.0f;
+            e.dir = -1.5707963f; e.spread = 6.2831853f; e.speed = 0.02f;
+            e.c0[0] = 1.0f; e.c0[1] = 0.8f; e.c0[2] = 0.2f;
+            e.c1[0] = 0.9f; e.c1[1] = 0.1f; e.c1[2] = 0.4f;
+            e.sizeMin = 3.0f; e.sizeMax = 12.0f;
+            e.rng = 0x9e3779b9u * (uint32_t)(id + 1) ^ nextRand(spawnRng);
+            if (e.rng == 0) e.rng = 1;
+            return id;
+        }
+        return -1;
+    }
+
+    EMSCRIPTEN_KEEPALIVE
+    void destroyEmitter(int id) {
+        if (Emitter* e = emitterById(id)) e->active = false;
+    }
+
+    EMSCRIPTEN_KEEPALIVE
+    void moveEmitter(int id, float x, float y) {
+        if (Emitter* e = emitterById(id)) { e->x = x; e->y = y; }
+    }
+
+    // stream: círculos por segundo; burst: cantidad total
+    EMSCRIPTEN_KEEPALIVE
+    void setEmitterRate(int id, float rate) {
+        if (Emitter* e = emitterById(id)) e->rate = std::max(0.0f, rate);
+    }
+
+    EMSCRIPTEN_KEEPALIVE
+    void setEmitterSpread(int id, float dir, float spread, float speed) {
+        if (Emitter* e = emitterById(id)) { e->dir = dir; e->spread = spread; e->speed = speed; }
+    }
+
+    EMSCRIPTEN_KEEPALIVE
+    void setEmitterColors(int id, float r0, float g0, float b0, float r1, float g1, float b1) {
+        if (Emitter* e = emitterById(id)) {
+            e->c0[0] = r0; e->c0[1] = g0; e->c0[2] = b0;
+            e->c1[0] = r1; e->c1[1] = g1; e->c1[2] = b1;
+        }
+    }
+
+    EMSCRIPTEN_KEEPALIVE
+    void setEmitterSize(int id, float sizeMin, float sizeMax) {
+        if (Emitter* e = emitterById(id)) { e->sizeMin = sizeMin; e->sizeMax = std::max(sizeMin, sizeMax); }
+    }
+
+    // Update physics: escribe las posiciones en el buffer de upload directamente
     EMSCRIPTEN_KEEPALIVE
     void updateCircles(float deltaTime) {
-        for (auto& c : circles) {
-            c.x += c.vx * deltaTime;
-            c.y += c.vy * deltaTime;
-            
+        for (auto& e : emitters)
+            if (e.active) runEmitter(e, deltaTime);
+
+        float* p = positions.data();
+        float* vx = velX.data();
+        float* vy = velY.data();
+        for (int i = 0; i < circleCount; i++) {
+            float x = p[i*2] + vx[i] * deltaTime;
+            float y = p[i*2+1] + vy[i] * deltaTime;
+
             // Bounce en bordes
-            if (c.x < 0 || c.x > 1) c.vx *= -0.9f;
-            if (c.y < 0 || c.y > 1) c.vy *= -0.9f;
-            
+            if (x < 0 || x > 1) vx[i] *= -0.9f;
+            if (y < 0 || y > 1) vy[i] *= -0.9f;
+
             // Gravedad sutil
-            c.vy += 0.00001f * deltaTime;
-            
+            vy[i] += 0.00001f * deltaTime;
+
             // Damping
-            c.vx *= 0.999f;
-            c.vy *= 0.999f;
+            vx[i] *= 0.999f;
+            vy[i] *= 0.999f;
+
+            p[i*2] = x;
+            p[i*2+1] = y;
         }
+
+        if (collisionsOn && circleCount > 1) resolveCollisions(deltaTime);
+    }
+
+    // Colisiones entre círculos (0 = sólo bordes, como siempre)
+    EMSCRIPTEN_KEEPALIVE
+    void setCollisions(int on) {
+        collisionsOn = on != 0;
+        broadphaseMs = narrowphaseMs = 0.0;
+        collisionPairs = 0;
+    }
+
+    EMSCRIPTEN_KEEPALIVE
+    int getCollisions() {
+        return collisionsOn ? 1 : 0;
+    }
+
+    // Tamaño del canvas en px: el radio de colisión (size/2) está en px como gl_PointSize
+    EMSCRIPTEN_KEEPALIVE
+    void setViewportSize(float w, float h) {
+        viewW = std::max(1.0f, w);
+        viewH = std::max(1.0f, h);
     }
-    
-    // Obtener buffer de posiciones para WebGL
+
+    // ms del último update: broadphase (claves + orden + celdas) y narrowphase (gather, pares, scatter)
+    EMSCRIPTEN_KEEPALIVE
+    double getBroadphaseMs() {
+        return broadphaseMs;
+    }
+
+    EMSCRIPTEN_KEEPALIVE
+    double getNarrowphaseMs() {
+        return narrowphaseMs;
+    }
+
+    // pares en contacto en el último update
+    EMSCRIPTEN_KEEPALIVE
+    int getCollisionPairs() {
+        return collisionPairs;
+    }
+
+    EMSCRIPTEN_KEEPALIVE
+    int getBroadphaseRebuilds() {
+        return broadphaseRebuilds;
+    }
+
+    // Buffer de posiciones para WebGL (circleCount * 2 floats)
     EMSCRIPTEN_KEEPALIVE
     float* getPositions() {
-        static std::vector<float> positions;
-        positions.clear();
-        positions.reserve(circles.size() * 2);
-        
-        for (const auto& c : circles) {
-            positions.push_back(c.x);
-            positions.push_back(c.y);
-        }
-        
         return positions.data();
     }
-    
-    // Obtener buffer de colores
+
+    // Buffer de colores (circleCount * 3 floats)
     EMSCRIPTEN_KEEPALIVE
     float* getColors() {
-        static std::vector<float> colors;
-        colors.clear();
-        colors.reserve(circles.size() * 3);
-        
-        for (const auto& c : circles) {
-            colors.push_back(c.r);
-            colors.push_back(c.g);
-            colors.push_back(c.b);
-        }
-        
         return colors.data();
     }
-    
-    // Obtener buffer de tamaños
+
+    // Buffer de tamaños (circleCount floats)
     EMSCRIPTEN_KEEPALIVE
     float* getSizes() {
-        static std::vector<float> sizes;
-        sizes.clear();
-        sizes.reserve(circles.size());
-        
-        for (const auto& c : circles) {
-            sizes.push_back(c.size);
-        }
-        
         return sizes.data();
     }
-    
+
     // Obtener cantidad de círculos
     EMSCRIPTEN_KEEPALIVE
     int getCircleCount() {
-        return (int)circles.size();
+        return circleCount;
+    }
+
+    EMSCRIPTEN_KEEPALIVE
+    int getMaxCircles() {
+        return MAX_CIRCLES;
+    }
+
+    // Rango de círculos con color/tamaño pendiente de subir (vacío si begin >= end)
+    EMSCRIPTEN_KEEPALIVE
+    int getAttribDirtyBegin() {
+        return dirtyBegin;
+    }
+
+    EMSCRIPTEN_KEEPALIVE
+    int getAttribDirtyEnd() {
+        return dirtyEnd;
+    }
+
+    // JS lo llama después de subir colors/sizes del rango sucio
+    EMSCRIPTEN_KEEPALIVE
+    void clearAttribDirty() {
+        dirtyBegin = dirtyEnd = 0;
+    }
+
+    // Fuerza a republicar colores y tamaños de todos (p.ej. si JS recreó sus buffers de GPU)
+    EMSCRIPTEN_KEEPALIVE
+    void markAllAttribDirty() {
+        markAttribDirty(0, circleCount);
+    }
+
+    // Rectángulo del mundo visible en pantalla (por defecto 0,0 - 1,1)
+    EMSCRIPTEN_KEEPALIVE
+    void setCamera(float x0, float y0, float x1, float y1) {
+        if (!(x1 > x0) || !(y1 > y0)) return;
+        camX0 = x0; camY0 = y0; camX1 = x1; camY1 = y1;
+    }
+
+    EMSCRIPTEN_KEEPALIVE
+    void resetCamera() {
+        camX0 = camY0 = 0.0f; camX1 = camY1 = 1.0f;
+    }
+
+    // Arma lo que se dibuja este frame. RENDER_DIRECT: usar getPositions/Colors/Sizes (+ rango sucio);
+    // RENDER_COMPACT: usar getRender*View(), getRenderCount() puntos en coordenadas de cámara.
+    EMSCRIPTEN_KEEPALIVE
+    int prepareRender() {
+        auto t0 = std::chrono::steady_clock::now();
+        int mode = RENDER_DIRECT;
+        if (cameraIsDefault()) {
+            renderCount = circleCount;
+            aggregatedCount = 0;
+        } else {
+            buildCompactRender();
+            mode = RENDER_COMPACT;
+        }
+        renderPrepMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        return mode;
+    }
+
+    // puntos a dibujar del último prepareRender() (visibles + celdas agregadas)
+    EMSCRIPTEN_KEEPALIVE
+    int getRenderCount() {
+        return renderCount;
+    }
+
+    // cuántos de esos puntos son celdas de LOD
+    EMSCRIPTEN_KEEPALIVE
+    int getAggregatedCount() {
+        return aggregatedCount;
+    }
+
+    EMSCRIPTEN_KEEPALIVE
+    double getRenderPrepMs() {
+        return renderPrepMs;
     }
-    
+
     // Limpiar todo
     EMSCRIPTEN_KEEPALIVE
     void clearCircles() {
-        circles.clear();
+        circleCount = 0;
+        maxCircleSize = 0.0f;
+        dirtyBegin = dirtyEnd = 0;
+        sortIdx.clear(); sortKey.clear();
     }
 }
 
-// --- Embind: vistas tipadas para evitar acceso manual al HEAP desde JS ---
+// --- Embind: vistas tipadas sobre los buffers persistentes (sin copia) ---
+#ifdef __EMSCRIPTEN__
 using namespace emscripten;
 
-static std::vector<float> positionsScratch;
-static std::vector<float> colorsScratch;
-static std::vector<float> sizesScratch;
-
 val getPositionsView() {
-    positionsScratch.clear();
-    positionsScratch.reserve(circles.size() * 2);
-    for (const auto& c : circles) {
-        positionsScratch.push_back(c.x);
-        positionsScratch.push_back(c.y);
-    }
-    return val(typed_memory_view(positionsScratch.size(), positionsScratch.data()));
+    return val(typed_memory_view((size_t)circleCount * 2, positions.data()));
 }
 
 val getColorsView() {
-    colorsScratch.clear();
-    colorsScratch.reserve(circles.size() * 3);
-    for (const auto& c : circles) {
-        colorsScratch.push_back(c.r);
-        colorsScratch.push_back(c.g);
-        colorsScratch.push_back(c.b);
-    }
-    return val(typed_memory_view(colorsScratch.size(), colorsScratch.data()));
+    return val(typed_memory_view((size_t)circleCount * 3, colors.data()));
 }
 
 val getSizesView() {
-    sizesScratch.clear();
-    sizesScratch.reserve(circles.size());
-    for (const auto& c : circles) {
-        sizesScratch.push_back(c.size);
-    }
-    return val(typed_memory_view(sizesScratch.size(), sizesScratch.data()));
+    return val(typed_memory_view((size_t)circleCount, sizes.data()));
+}
+
+// buffers compactos de prepareRender() en modo RENDER_COMPACT
+val getRenderPositionsView() {
+    return val(typed_memory_view((size_t)renderCount * 2, renderPos.data()));
+}
+
+val getRenderColorsView() {
+    return val(typed_memory_view((size_t)renderCount * 3, renderCol.data()));
+}
+
+val getRenderSizesView() {
+    return val(typed_memory_view((size_t)renderCount, renderSize.data()));
 }
 
 EMSCRIPTEN_BINDINGS(renderer_bindings) {
     function("getPositionsView", &getPositionsView);
     function("getColorsView", &getColorsView);
     function("getSizesView", &getSizesView);
+    function("getRenderPositionsView", &getRenderPositionsView);
+    function("getRenderColorsView", &getRenderColorsView);
+    function("getRenderSizesView", &getRenderSizesView);
+}
+#endif
+
+#ifdef RENDERER_BENCH
+// Benchmark nativo (./build.sh native): colisiones a n círculos como el botón de benchmark de app.js
+// (tamaños 3..22 px repartidos al azar en un canvas de 1920×1080), ms de broadphase y narrowphase por frame.
+#include <cstdio>
+
+int main(int argc, char** argv) {
+    const int frames = 120;
+    std::printf("viewport 1920x1080, tamaños 3..22 px, %d frames a 16.67 ms\n", frames);
+    const int counts[] = {10000, 25000, 50000, 100000};
+    for (int n : counts) {
+        if (argc > 1 && std::atoi(argv[1]) != n) continue;
+        init();
+        setViewportSize(1920.0f, 1080.0f);
+        setCollisions(1);
+        std::vector<float> xy((size_t)n * 2);
+        uint32_t rng = 12345u;
+        for (float& v : xy) v = randUnit(rng);
+        addCircles(xy.data(), n);
+        // los primeros frames son el estallido inicial (velocidades de ±0.05 por ms contra las paredes); el resto
+        // es el régimen que ve el demo una vez que se asienta
+        const int warm = 20;
+        double warmWorst = 0.0, broad = 0.0, narrow = 0.0, worst = 0.0;
+        long pairs = 0;
+        for (int f = 0; f < frames; f++) {
+            updateCircles(16.67f);
+            const double ms = broadphaseMs + narrowphaseMs;
+            if (f < warm) { warmWorst = std::max(warmWorst, ms); continue; }
+            broad += broadphaseMs; narrow += narrowphaseMs; pairs += collisionPairs;
+            worst = std::max(worst, ms);
+        }
+        const int m = frames - warm;
+        std::printf("%6d círculos  arranque peor %.3f ms | régimen: broad %.3f ms  narrow %.3f ms  total %.3f ms (peor %.3f)  %ld contactos\n",
+                    n, warmWorst, broad / m, narrow / m, (broad + narrow) / m, worst, pairs / m);
+    }
+    return 0;
 }
+#endif